@@ -0,0 +1,243 @@
+#include "3dsystem/3d_transform.h"
+
+#include "config.h"
+#include "game/output.h"
+#include "game/viewport.h"
+#include "global/vars.h"
+
+#include <stdbool.h>
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+    #define PHD_TRANSFORM_SSE2
+    #include <emmintrin.h>
+#endif
+
+#ifdef PHD_TRANSFORM_SSE2
+// Vertices are transformed in blocks of 4 into a structure of arrays, which
+// is then copied out to the vertex buffer.
+typedef struct PHD_VBUF_BLOCK {
+    float xv[4];
+    float yv[4];
+    float zv[4];
+    float xs[4];
+    float ys[4];
+    int32_t clip[4];
+} PHD_VBUF_BLOCK;
+
+static bool phd_IsSSE2Supported();
+static bool phd_CanTransformSSE2(const PHD_MATRIX *mptr);
+static int16_t phd_TransformVerticesSSE2(
+    const int16_t *obj_ptr, int32_t stride, int32_t count, PHD_VBUF *vbuf);
+
+static bool phd_IsSSE2Supported()
+{
+    static int supported = -1;
+    if (supported == -1) {
+        __builtin_cpu_init();
+        supported = __builtin_cpu_supports("sse2") ? 1 : 0;
+    }
+    return supported;
+}
+
+static bool phd_CanTransformSSE2(const PHD_MATRIX *mptr)
+{
+    // the rotation part is multiplied in 16-bit pairs
+    const int32_t rotation[] = {
+        mptr->_00, mptr->_01, mptr->_02, mptr->_10, mptr->_11,
+        mptr->_12, mptr->_20, mptr->_21, mptr->_22,
+    };
+    for (int i = 0; i < 9; i++) {
+        if (rotation[i] < INT16_MIN || rotation[i] > INT16_MAX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+__attribute__((target("sse2"), force_align_arg_pointer)) static int16_t
+phd_TransformVerticesSSE2(
+    const int16_t *obj_ptr, int32_t stride, int32_t count, PHD_VBUF *vbuf)
+{
+    const PHD_MATRIX *mptr = g_PhdMatrixPtr;
+
+    // x * m0 + y * m1 and z * m2 + 1 * 0 are computed with a single
+    // multiply-add on interleaved 16-bit pairs each, which gives the exact
+    // 32-bit integer results of the scalar code
+#define PAIR(a, b)                                                             \
+    _mm_set1_epi32(((uint32_t)(uint16_t)(b) << 16) | (uint16_t)(a))
+    const __m128i m0_xy = PAIR(mptr->_00, mptr->_01);
+    const __m128i m0_z = PAIR(mptr->_02, 0);
+    const __m128i m1_xy = PAIR(mptr->_10, mptr->_11);
+    const __m128i m1_z = PAIR(mptr->_12, 0);
+    const __m128i m2_xy = PAIR(mptr->_20, mptr->_21);
+    const __m128i m2_z = PAIR(mptr->_22, 0);
+#undef PAIR
+    const __m128i m0_t = _mm_set1_epi32(mptr->_03);
+    const __m128i m1_t = _mm_set1_epi32(mptr->_13);
+    const __m128i m2_t = _mm_set1_epi32(mptr->_23);
+
+    const __m128i near_z = _mm_set1_epi32(Output_GetNearZ());
+    const __m128 persp = _mm_set1_ps(g_PhdPersp);
+    const __m128 center_x = _mm_set1_ps(ViewPort_GetCenterX());
+    const __m128 center_y = _mm_set1_ps(ViewPort_GetCenterY());
+    const __m128 left = _mm_set1_ps(g_PhdLeft);
+    const __m128 right = _mm_set1_ps(g_PhdRight);
+    const __m128 top = _mm_set1_ps(g_PhdTop);
+    const __m128 bottom = _mm_set1_ps(g_PhdBottom);
+    const __m128i flag_left = _mm_set1_epi32(1);
+    const __m128i flag_right = _mm_set1_epi32(2);
+    const __m128i flag_top = _mm_set1_epi32(4);
+    const __m128i flag_bottom = _mm_set1_epi32(8);
+    const __m128i flag_near = _mm_set1_epi32(-32768);
+
+    PHD_VBUF_BLOCK block;
+    __m128i total_clip = _mm_set1_epi32(-1);
+
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const int16_t *v0 = obj_ptr;
+        const int16_t *v1 = v0 + stride;
+        const int16_t *v2 = v1 + stride;
+        const int16_t *v3 = v2 + stride;
+        obj_ptr = v3 + stride;
+
+        const __m128i xy = _mm_setr_epi16(
+            v0[0], v0[1], v1[0], v1[1], v2[0], v2[1], v3[0], v3[1]);
+        const __m128i z1 =
+            _mm_setr_epi16(v0[2], 1, v1[2], 1, v2[2], 1, v3[2], 1);
+
+        const __m128i xv_int = _mm_add_epi32(
+            _mm_add_epi32(_mm_madd_epi16(xy, m0_xy), _mm_madd_epi16(z1, m0_z)),
+            m0_t);
+        const __m128i yv_int = _mm_add_epi32(
+            _mm_add_epi32(_mm_madd_epi16(xy, m1_xy), _mm_madd_epi16(z1, m1_z)),
+            m1_t);
+        const __m128i zv_int = _mm_add_epi32(
+            _mm_add_epi32(_mm_madd_epi16(xy, m2_xy), _mm_madd_epi16(z1, m2_z)),
+            m2_t);
+
+        const __m128 xv = _mm_cvtepi32_ps(xv_int);
+        const __m128 yv = _mm_cvtepi32_ps(yv_int);
+        const __m128 zv = _mm_cvtepi32_ps(zv_int);
+
+        const __m128 scale = _mm_div_ps(persp, zv);
+        const __m128 xs = _mm_add_ps(center_x, _mm_mul_ps(xv, scale));
+        const __m128 ys = _mm_add_ps(center_y, _mm_mul_ps(yv, scale));
+
+        // x and y flags are exclusive, so the right and bottom tests only
+        // need to run when the left and top ones fail, like in the scalar
+        // code
+        const __m128i is_left = _mm_castps_si128(_mm_cmplt_ps(xs, left));
+        const __m128i is_right = _mm_andnot_si128(
+            is_left, _mm_castps_si128(_mm_cmpgt_ps(xs, right)));
+        const __m128i is_top = _mm_castps_si128(_mm_cmplt_ps(ys, top));
+        const __m128i is_bottom = _mm_andnot_si128(
+            is_top, _mm_castps_si128(_mm_cmpgt_ps(ys, bottom)));
+        const __m128i is_near = _mm_cmplt_epi32(zv_int, near_z);
+
+        __m128i clip = _mm_or_si128(
+            _mm_or_si128(
+                _mm_and_si128(is_left, flag_left),
+                _mm_and_si128(is_right, flag_right)),
+            _mm_or_si128(
+                _mm_and_si128(is_top, flag_top),
+                _mm_and_si128(is_bottom, flag_bottom)));
+        clip = _mm_or_si128(
+            _mm_andnot_si128(is_near, clip), _mm_and_si128(is_near, flag_near));
+        total_clip = _mm_and_si128(total_clip, clip);
+
+        _mm_storeu_ps(block.xv, xv);
+        _mm_storeu_ps(block.yv, yv);
+        _mm_storeu_ps(block.zv, zv);
+        _mm_storeu_ps(block.xs, xs);
+        _mm_storeu_ps(block.ys, ys);
+        _mm_storeu_si128((__m128i *)block.clip, clip);
+
+        for (int j = 0; j < 4; j++) {
+            vbuf->xv = block.xv[j];
+            vbuf->yv = block.yv[j];
+            vbuf->zv = block.zv[j];
+            vbuf->clip = block.clip[j];
+            if (block.clip[j] >= 0) {
+                vbuf->xs = block.xs[j];
+                vbuf->ys = block.ys[j];
+            }
+            vbuf++;
+        }
+    }
+
+    _mm_storeu_si128((__m128i *)block.clip, total_clip);
+    int16_t result = block.clip[0] & block.clip[1] & block.clip[2]
+        & block.clip[3];
+
+    if (i < count) {
+        result &= phd_TransformVerticesExact(obj_ptr, stride, count - i, vbuf);
+    }
+    return result;
+}
+#endif
+
+int16_t phd_TransformVertices(
+    const int16_t *obj_ptr, int32_t stride, int32_t count, PHD_VBUF *vbuf)
+{
+#ifdef PHD_TRANSFORM_SSE2
+    if (g_Config.rendering.enable_simd_transform && count >= 4
+        && phd_IsSSE2Supported() && phd_CanTransformSSE2(g_PhdMatrixPtr)) {
+        return phd_TransformVerticesSSE2(obj_ptr, stride, count, vbuf);
+    }
+#endif
+    return phd_TransformVerticesExact(obj_ptr, stride, count, vbuf);
+}
+
+int16_t phd_TransformVerticesExact(
+    const int16_t *obj_ptr, int32_t stride, int32_t count, PHD_VBUF *vbuf)
+{
+    const PHD_MATRIX *mptr = g_PhdMatrixPtr;
+    int16_t total_clip = -1;
+
+    for (int i = 0; i < count; i++) {
+        double xv = mptr->_00 * obj_ptr[0] + mptr->_01 * obj_ptr[1]
+            + mptr->_02 * obj_ptr[2] + mptr->_03;
+        double yv = mptr->_10 * obj_ptr[0] + mptr->_11 * obj_ptr[1]
+            + mptr->_12 * obj_ptr[2] + mptr->_13;
+        int32_t zv_int = mptr->_20 * obj_ptr[0] + mptr->_21 * obj_ptr[1]
+            + mptr->_22 * obj_ptr[2] + mptr->_23;
+        double zv = zv_int;
+        vbuf->xv = xv;
+        vbuf->yv = yv;
+        vbuf->zv = zv;
+
+        int16_t clip_flags;
+        if (zv < Output_GetNearZ()) {
+            clip_flags = -32768;
+        } else {
+            clip_flags = 0;
+
+            double persp = g_PhdPersp / zv;
+            double xs = ViewPort_GetCenterX() + xv * persp;
+            double ys = ViewPort_GetCenterY() + yv * persp;
+
+            if (xs < g_PhdLeft) {
+                clip_flags |= 1;
+            } else if (xs > g_PhdRight) {
+                clip_flags |= 2;
+            }
+
+            if (ys < g_PhdTop) {
+                clip_flags |= 4;
+            } else if (ys > g_PhdBottom) {
+                clip_flags |= 8;
+            }
+
+            vbuf->xs = xs;
+            vbuf->ys = ys;
+        }
+
+        vbuf->clip = clip_flags;
+        total_clip &= clip_flags;
+        obj_ptr += stride;
+        vbuf++;
+    }
+
+    return total_clip;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include "global/types.h"
+
+#include <stdint.h>
+
+// Transforms the vertices, stored as x, y, z triplets placed stride values
+// apart, by the current matrix into view space, and projects the ones in
+// front of the near plane onto the screen. Returns the clip flags shared by
+// all of the vertices.
+int16_t phd_TransformVertices(
+    const int16_t *obj_ptr, int32_t stride, int32_t count, PHD_VBUF *vbuf);
+
+// Scalar version of the above, matching the original code bit for bit.
+int16_t phd_TransformVerticesExact(
+    const int16_t *obj_ptr, int32_t stride, int32_t count, PHD_VBUF *vbuf);
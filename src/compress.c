@@ -0,0 +1,130 @@
+#include "compress.h"
+
+#include "util.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#define COMPRESS_WINDOW_BITS 12
+#define COMPRESS_WINDOW (1 << COMPRESS_WINDOW_BITS)
+#define COMPRESS_MIN_MATCH 3
+#define COMPRESS_MAX_MATCH (COMPRESS_MIN_MATCH + 15)
+#define COMPRESS_HASH_BITS 12
+#define COMPRESS_HASH_SIZE (1 << COMPRESS_HASH_BITS)
+
+static uint32_t Compress_Hash(const uint8_t *data);
+
+static uint32_t Compress_Hash(const uint8_t *data)
+{
+    const uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16);
+    return (value * 2654435761U) >> (32 - COMPRESS_HASH_BITS);
+}
+
+size_t Compress_Bound(size_t size)
+{
+    // every 8 literals cost one extra flag byte
+    return size + size / 8 + 1;
+}
+
+size_t Compress_Encode(const void *src, size_t src_size, void *dst)
+{
+    const uint8_t *in = src;
+    uint8_t *out = dst;
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+
+    // only the last position of each hash is remembered, which keeps the
+    // search to a single probe
+    int32_t head[COMPRESS_HASH_SIZE];
+    for (int i = 0; i < COMPRESS_HASH_SIZE; i++) {
+        head[i] = -1;
+    }
+
+    while (in_pos < src_size) {
+        uint8_t *flags = &out[out_pos++];
+        *flags = 0;
+
+        for (int bit = 0; bit < 8 && in_pos < src_size; bit++) {
+            size_t match_len = 0;
+            size_t match_offset = 0;
+            if (in_pos + COMPRESS_MIN_MATCH <= src_size) {
+                const uint32_t hash = Compress_Hash(&in[in_pos]);
+                const int32_t candidate = head[hash];
+                head[hash] = in_pos;
+                if (candidate >= 0 && in_pos - candidate <= COMPRESS_WINDOW) {
+                    const size_t max_len =
+                        MIN(COMPRESS_MAX_MATCH, src_size - in_pos);
+                    while (match_len < max_len
+                           && in[candidate + match_len]
+                               == in[in_pos + match_len]) {
+                        match_len++;
+                    }
+                    match_offset = in_pos - candidate;
+                }
+            }
+
+            if (match_len < COMPRESS_MIN_MATCH) {
+                out[out_pos++] = in[in_pos++];
+                continue;
+            }
+
+            *flags |= 1 << bit;
+            const uint16_t token = ((match_offset - 1) << 4)
+                | (match_len - COMPRESS_MIN_MATCH);
+            out[out_pos++] = token & 0xFF;
+            out[out_pos++] = token >> 8;
+
+            for (size_t i = 1; i < match_len; i++) {
+                if (in_pos + i + COMPRESS_MIN_MATCH <= src_size) {
+                    head[Compress_Hash(&in[in_pos + i])] = in_pos + i;
+                }
+            }
+            in_pos += match_len;
+        }
+    }
+
+    return out_pos;
+}
+
+bool Compress_Decode(
+    const void *src, size_t src_size, void *dst, size_t dst_size)
+{
+    const uint8_t *in = src;
+    uint8_t *out = dst;
+    size_t in_pos = 0;
+    size_t out_pos = 0;
+
+    while (in_pos < src_size) {
+        const uint8_t flags = in[in_pos++];
+
+        for (int bit = 0; bit < 8 && in_pos < src_size; bit++) {
+            if (!(flags & (1 << bit))) {
+                if (out_pos >= dst_size) {
+                    return false;
+                }
+                out[out_pos++] = in[in_pos++];
+                continue;
+            }
+
+            if (in_pos + 2 > src_size) {
+                return false;
+            }
+            const uint16_t token = in[in_pos] | (in[in_pos + 1] << 8);
+            in_pos += 2;
+
+            const size_t offset = (token >> 4) + 1;
+            const size_t len = (token & 0xF) + COMPRESS_MIN_MATCH;
+            if (offset > out_pos || len > dst_size - out_pos) {
+                return false;
+            }
+
+            // the source may overlap the output, so copy byte by byte
+            for (size_t i = 0; i < len; i++) {
+                out[out_pos] = out[out_pos - offset];
+                out_pos++;
+            }
+        }
+    }
+
+    return out_pos == dst_size;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// A small LZSS codec for data that the game writes out itself, such as the
+// saves. It favours speed and simplicity over the compression ratio.
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Returns the largest size that compressing size bytes can produce.
+size_t Compress_Bound(size_t size);
+
+// Compresses the data into dst, which must hold at least Compress_Bound bytes.
+// Returns the compressed size.
+size_t Compress_Encode(const void *src, size_t src_size, void *dst);
+
+// Decompresses the data into dst. Returns false if the data is malformed or
+// does not decompress to exactly dst_size bytes.
+bool Compress_Decode(
+    const void *src, size_t src_size, void *dst, size_t dst_size);
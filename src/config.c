@@ -1,6 +1,7 @@
 #include "config.h"
 
 #include "filesystem.h"
+#include "game/gamebuf.h"
 #include "global/const.h"
 #include "global/vars.h"
 #include "specific/s_shell.h"
@@ -106,9 +107,13 @@ bool Config_ReadFromJSON(const char *cfg_data)
     struct json_value_s *root;
     struct json_parse_result_s parse_result;
 
+    // the document is only needed while the options are read, so it goes into
+    // scratch memory along with an index to speed up the key lookups
+    GAMEBUF_SCOPE scope = GameBuf_BeginScratch();
     root = json_parse_ex(
-        cfg_data, strlen(cfg_data), json_parse_flags_allow_json5, NULL, NULL,
-        &parse_result);
+        cfg_data, strlen(cfg_data),
+        json_parse_flags_allow_json5 | json_parse_flags_build_object_index,
+        GameBuf_AllocScratchJSON, NULL, &parse_result);
     if (root) {
         result = true;
     } else {
@@ -157,7 +162,19 @@ bool Config_ReadFromJSON(const char *cfg_data)
     READ_FLOAT(brightness, 1.0);
     READ_BOOL(enable_round_shadow, true);
     READ_BOOL(enable_3d_pickups, true);
+    READ_BOOL(enable_memory_stats, false);
+    READ_BOOL(enable_level_cache, false);
+    READ_INTEGER(quick_save_slots, 0);
+    READ_BOOL(enable_json_log, false);
+    READ_BOOL(enable_shared_pathfinding, false);
+    READ_INTEGER(creature_slots, NUM_SLOTS);
+    READ_INTEGER(pathfinding_budget, 0);
+    READ_BOOL(enable_hierarchical_pathfinding, false);
     READ_FLOAT(rendering.anisotropy_filter, 16.0f);
+    READ_BOOL(rendering.enable_draw_batching, true);
+    READ_BOOL(rendering.enable_texture_array, true);
+    READ_BOOL(rendering.enable_room_cache, true);
+    READ_BOOL(rendering.enable_simd_transform, true);
 
     READ_ENUM(
         healthbar_showing_mode, BSM_FLASHING_OR_DEFAULT, m_BarShowingModes);
@@ -171,10 +188,9 @@ bool Config_ReadFromJSON(const char *cfg_data)
     READ_ENUM(screenshot_format, SCREENSHOT_FORMAT_JPEG, m_ScreenshotFormats);
 
     CLAMP(g_Config.fov_value, 30, 255);
+    CLAMP(g_Config.creature_slots, 0, MAX_CREATURE_SLOTS);
 
-    if (root) {
-        json_value_free(root);
-    }
+    GameBuf_EndScratch(scope);
     return result;
 }
 
@@ -83,6 +83,14 @@ typedef struct {
     float brightness;
     bool enable_round_shadow;
     bool enable_3d_pickups;
+    bool enable_memory_stats;
+    bool enable_level_cache;
+    int32_t quick_save_slots;
+    bool enable_json_log;
+    bool enable_shared_pathfinding;
+    int32_t creature_slots;
+    int32_t pathfinding_budget;
+    bool enable_hierarchical_pathfinding;
 
     struct {
         int32_t layout;
@@ -92,6 +100,10 @@ typedef struct {
         uint32_t enable_perspective_filter : 1;
         uint32_t enable_bilinear_filter : 1;
         uint32_t enable_fps_counter : 1;
+        uint32_t enable_draw_batching : 1;
+        uint32_t enable_texture_array : 1;
+        uint32_t enable_room_cache : 1;
+        uint32_t enable_simd_transform : 1;
         float anisotropy_filter;
     } rendering;
 
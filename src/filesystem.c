@@ -3,16 +3,44 @@
 #include "log.h"
 #include "memory.h"
 #include "specific/s_filesystem.h"
+#include "util.h"
 
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
 
 struct MYFILE {
     FILE *fp;
+    char *buffer;
+    size_t buffer_size;
+    size_t buffer_pos;
+    bool is_mapped;
 };
 
+static bool File_ReadToMemory(MYFILE *file);
+
+static bool File_ReadToMemory(MYFILE *file)
+{
+    fseek(file->fp, 0, SEEK_END);
+    file->buffer_size = ftell(file->fp);
+    fseek(file->fp, 0, SEEK_SET);
+
+    file->buffer = Memory_Alloc(file->buffer_size);
+    file->buffer_pos = 0;
+    const bool result =
+        fread(file->buffer, 1, file->buffer_size, file->fp)
+        == file->buffer_size;
+
+    fclose(file->fp);
+    file->fp = NULL;
+    if (!result) {
+        Memory_FreePointer(&file->buffer);
+    }
+    return result;
+}
+
 bool File_IsAbsolute(const char *path)
 {
     return path && (path[0] == '/' || strstr(path, ":\\"));
@@ -89,12 +117,31 @@ MYFILE *File_Open(const char *path, FILE_OPEN_MODE mode)
     case FILE_OPEN_READ:
         file->fp = fopen(full_path, "rb");
         break;
+    case FILE_OPEN_READ_MEMORY:
+        file->fp = fopen(full_path, "rb");
+        if (file->fp && !File_ReadToMemory(file)) {
+            LOG_ERROR("Can't read file %s", full_path);
+        }
+        break;
+    case FILE_OPEN_READ_MAPPED:
+        file->buffer = S_File_Map(full_path, &file->buffer_size);
+        file->buffer_pos = 0;
+        if (file->buffer) {
+            file->is_mapped = true;
+            file->fp = NULL;
+            break;
+        }
+        file->fp = fopen(full_path, "rb");
+        if (file->fp && !File_ReadToMemory(file)) {
+            LOG_ERROR("Can't read file %s", full_path);
+        }
+        break;
     default:
         file->fp = NULL;
         break;
     }
     Memory_FreePointer(&full_path);
-    if (!file->fp) {
+    if (!file->fp && !file->buffer) {
         Memory_FreePointer(&file);
     }
     return file;
@@ -102,9 +149,27 @@ MYFILE *File_Open(const char *path, FILE_OPEN_MODE mode)
 
 size_t File_Read(void *data, size_t item_size, size_t count, MYFILE *file)
 {
+    if (file->buffer) {
+        const size_t remaining = file->buffer_size - file->buffer_pos;
+        if (item_size && count > remaining / item_size) {
+            count = remaining / item_size;
+        }
+        memcpy(data, &file->buffer[file->buffer_pos], item_size * count);
+        file->buffer_pos += item_size * count;
+        return count;
+    }
     return fread(data, item_size, count, file->fp);
 }
 
+void *File_MapRange(MYFILE *file, size_t offset, size_t size)
+{
+    if (!file->buffer || offset > file->buffer_size
+        || size > file->buffer_size - offset) {
+        return NULL;
+    }
+    return &file->buffer[offset];
+}
+
 size_t File_Write(
     const void *data, size_t item_size, size_t count, MYFILE *file)
 {
@@ -123,6 +188,22 @@ void File_Skip(MYFILE *file, size_t bytes)
 
 void File_Seek(MYFILE *file, size_t pos, FILE_SEEK_MODE mode)
 {
+    if (file->buffer) {
+        switch (mode) {
+        case FILE_SEEK_SET:
+            file->buffer_pos = pos;
+            break;
+        case FILE_SEEK_CUR:
+            file->buffer_pos += pos;
+            break;
+        case FILE_SEEK_END:
+            file->buffer_pos = file->buffer_size + pos;
+            break;
+        }
+        CLAMPG(file->buffer_pos, file->buffer_size);
+        return;
+    }
+
     switch (mode) {
     case FILE_SEEK_SET:
         fseek(file->fp, pos, SEEK_SET);
@@ -138,11 +219,17 @@ void File_Seek(MYFILE *file, size_t pos, FILE_SEEK_MODE mode)
 
 size_t File_Pos(MYFILE *file)
 {
+    if (file->buffer) {
+        return file->buffer_pos;
+    }
     return ftell(file->fp);
 }
 
 size_t File_Size(MYFILE *file)
 {
+    if (file->buffer) {
+        return file->buffer_size;
+    }
     size_t old = ftell(file->fp);
     fseek(file->fp, 0, SEEK_END);
     size_t size = ftell(file->fp);
@@ -152,7 +239,14 @@ size_t File_Size(MYFILE *file)
 
 void File_Close(MYFILE *file)
 {
-    fclose(file->fp);
+    if (file->fp) {
+        fclose(file->fp);
+    }
+    if (file->is_mapped) {
+        S_File_Unmap(file->buffer, file->buffer_size);
+        file->buffer = NULL;
+    }
+    Memory_FreePointer(&file->buffer);
     Memory_FreePointer(&file);
 }
 
@@ -161,6 +255,21 @@ int File_Delete(const char *path)
     return remove(path);
 }
 
+bool File_GetInfo(const char *path, size_t *size, int64_t *mtime)
+{
+    char *full_path = NULL;
+    File_GetFullPath(path, &full_path);
+    struct stat st;
+    const bool result = stat(full_path, &st) == 0;
+    Memory_FreePointer(&full_path);
+    if (!result) {
+        return false;
+    }
+    *size = st.st_size;
+    *mtime = st.st_mtime;
+    return true;
+}
+
 bool File_Load(const char *path, char **output_data, size_t *output_size)
 {
     MYFILE *fp = File_Open(path, FILE_OPEN_READ);
@@ -185,3 +294,32 @@ bool File_Load(const char *path, char **output_data, size_t *output_size)
     }
     return true;
 }
+
+bool File_WriteAtomic(const char *path, const void *data, size_t size)
+{
+    char *full_path = NULL;
+    File_GetFullPath(path, &full_path);
+    char *tmp_path = Memory_Alloc(strlen(full_path) + 5);
+    sprintf(tmp_path, "%s.tmp", full_path);
+
+    bool result = false;
+    FILE *fp = fopen(tmp_path, "wb");
+    if (fp) {
+        result = fwrite(data, sizeof(char), size, fp) == size;
+        result = S_File_Sync(fp) && result;
+        result = fclose(fp) == 0 && result;
+        if (result) {
+            result = S_File_Replace(tmp_path, full_path);
+        }
+        if (!result) {
+            remove(tmp_path);
+        }
+    }
+    if (!result) {
+        LOG_ERROR("Can't write file %s", full_path);
+    }
+
+    Memory_FreePointer(&tmp_path);
+    Memory_FreePointer(&full_path);
+    return result;
+}
@@ -2,6 +2,7 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 typedef enum {
     FILE_SEEK_SET,
@@ -12,6 +13,11 @@ typedef enum {
 typedef enum {
     FILE_OPEN_READ,
     FILE_OPEN_WRITE,
+    // reads the whole file at once and serves the reads from memory
+    FILE_OPEN_READ_MEMORY,
+    // maps the file into memory, falling back to FILE_OPEN_READ_MEMORY if
+    // that is not possible; the mapping is copy-on-write
+    FILE_OPEN_READ_MAPPED,
 } FILE_OPEN_MODE;
 
 typedef struct MYFILE MYFILE;
@@ -25,6 +31,11 @@ void File_GuessExtension(const char *path, char **out, const char **extensions);
 
 MYFILE *File_Open(const char *path, FILE_OPEN_MODE mode);
 size_t File_Read(void *data, size_t item_size, size_t count, MYFILE *file);
+// Returns a pointer to the given range of a file opened with
+// FILE_OPEN_READ_MEMORY or FILE_OPEN_READ_MAPPED, or NULL if the file is not
+// held in memory or the range is out of bounds. The pointer stays valid until
+// the file is closed.
+void *File_MapRange(MYFILE *file, size_t offset, size_t size);
 size_t File_Write(
     const void *data, size_t item_size, size_t count, MYFILE *file);
 void File_CreateDirectory(const char *path);
@@ -34,5 +45,13 @@ void File_Skip(MYFILE *file, size_t bytes);
 void File_Seek(MYFILE *file, size_t pos, FILE_SEEK_MODE mode);
 void File_Close(MYFILE *file);
 int File_Delete(const char *path);
+// Gets the size and the last modification time of a file without opening
+// it. Returns false if the file does not exist.
+bool File_GetInfo(const char *path, size_t *size, int64_t *mtime);
 
 bool File_Load(const char *path, char **output_data, size_t *output_size);
+
+// Writes the data to a temporary file next to the target, flushes it to the
+// disk and only then puts it in place of the target, so that the target is
+// never left half-written.
+bool File_WriteAtomic(const char *path, const void *data, size_t size);
@@ -0,0 +1,121 @@
+#include "game/ai_scheduler.h"
+
+#include "config.h"
+#include "global/const.h"
+#include "global/vars.h"
+#include "log.h"
+#include "util.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// creatures closer to the camera than this are never held back
+#define AI_SCHEDULER_NEAR_DIST (WALL_L * 8)
+
+static int32_t m_Histogram[AI_SCHEDULER_HISTOGRAM_SIZE] = { 0 };
+static uint32_t m_Frame = 0;
+static bool m_IsFrameStarted = false;
+
+static int32_t m_Remaining = 0;
+static int32_t m_Period = 1;
+static int32_t m_Used = 0;
+static int32_t m_FarCount = 0;
+
+static int32_t AIScheduler_GetBucket(int32_t used);
+static bool AIScheduler_IsNear(const ITEM_INFO *item);
+
+static int32_t AIScheduler_GetBucket(int32_t used)
+{
+    int32_t bucket = 0;
+    while (used > 0 && bucket < AI_SCHEDULER_HISTOGRAM_SIZE - 1) {
+        used >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+static bool AIScheduler_IsNear(const ITEM_INFO *item)
+{
+    const int32_t x = (item->pos.x - g_Camera.pos.x) >> 8;
+    const int32_t y = (item->pos.y - g_Camera.pos.y) >> 8;
+    const int32_t z = (item->pos.z - g_Camera.pos.z) >> 8;
+    return SQUARE(x) + SQUARE(y) + SQUARE(z)
+        < SQUARE(AI_SCHEDULER_NEAR_DIST >> 8);
+}
+
+void AIScheduler_Init()
+{
+    memset(m_Histogram, 0, sizeof(m_Histogram));
+    m_IsFrameStarted = false;
+    m_Remaining = 0;
+    m_Period = 1;
+    m_Used = 0;
+    m_FarCount = 0;
+}
+
+void AIScheduler_BeginFrame()
+{
+    if (m_IsFrameStarted) {
+        m_Histogram[AIScheduler_GetBucket(m_Used)]++;
+    }
+    m_IsFrameStarted = true;
+    m_Frame++;
+
+    // the far creatures take turns, each getting one every m_Period frames;
+    // the period grows while the budget keeps running out and shrinks again
+    // once there is plenty left
+    const int32_t budget = g_Config.pathfinding_budget;
+    if (budget <= 0) {
+        m_Period = 1;
+    } else if (m_Remaining <= 0 && m_FarCount) {
+        m_Period = MIN(m_Period * 2, m_FarCount);
+    } else if (m_Used < budget / 2) {
+        m_Period = MAX(m_Period / 2, 1);
+    }
+
+    m_Remaining = budget;
+    m_Used = 0;
+    m_FarCount = 0;
+}
+
+int32_t AIScheduler_GetExpansions(const ITEM_INFO *item, int32_t wanted)
+{
+    if (g_Config.pathfinding_budget <= 0 || AIScheduler_IsNear(item)) {
+        return wanted;
+    }
+
+    m_FarCount++;
+    const int32_t item_num = item - g_Items;
+    if ((m_Frame + item_num) % m_Period) {
+        return 0;
+    }
+    // make up for the frames spent waiting, but no more than the original
+    // game would have allowed over them, so that a single creature cannot
+    // use up the whole budget
+    return MIN(MIN(wanted, MAX_EXPANSION) * m_Period, MAX(m_Remaining, 0));
+}
+
+void AIScheduler_AddCost(int32_t expansions)
+{
+    m_Remaining -= expansions;
+    m_Used += expansions;
+}
+
+void AIScheduler_GetHistogram(int32_t histogram[AI_SCHEDULER_HISTOGRAM_SIZE])
+{
+    memcpy(histogram, m_Histogram, sizeof(m_Histogram));
+}
+
+void AIScheduler_LogStats()
+{
+    char buf[AI_SCHEDULER_HISTOGRAM_SIZE * 12 + 1];
+    char *ptr = buf;
+    int32_t frames = 0;
+    for (int i = 0; i < AI_SCHEDULER_HISTOGRAM_SIZE; i++) {
+        ptr += sprintf(ptr, " %d", m_Histogram[i]);
+        frames += m_Histogram[i];
+    }
+    if (frames) {
+        LOG_INFO("box expansions per frame over %d frames:%s", frames, buf);
+    }
+}
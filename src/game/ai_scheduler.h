@@ -0,0 +1,34 @@
+#pragma once
+
+#include "global/types.h"
+
+#include <stdint.h>
+
+#define AI_SCHEDULER_HISTOGRAM_SIZE 16
+
+// Spreads the box graph searches of the creatures over the frames, so that
+// the pathfinding cost of a frame stays flat no matter how many creatures are
+// active. Each frame has a budget of box expansions. Creatures near the
+// camera always get what they ask for; the rest share what is left, taking
+// turns in larger slices when there is not enough to go round. A budget of
+// 0 disables the scheduler.
+
+// Clears the statistics for a new level.
+void AIScheduler_Init();
+
+// Starts a new game frame.
+void AIScheduler_BeginFrame();
+
+// Returns how many boxes the given creature may expand this frame.
+int32_t AIScheduler_GetExpansions(const ITEM_INFO *item, int32_t wanted);
+
+// Counts the boxes that were actually expanded against the budget.
+void AIScheduler_AddCost(int32_t expansions);
+
+// Fills histogram with the number of frames by the box expansions they
+// used: bucket 0 counts the frames without any, and bucket n > 0 those that
+// used from 2^(n-1) up to 2^n - 1, with the last bucket taking the rest.
+void AIScheduler_GetHistogram(int32_t histogram[AI_SCHEDULER_HISTOGRAM_SIZE]);
+
+// Writes the histogram of the current level to the log.
+void AIScheduler_LogStats();
@@ -2,6 +2,9 @@
 
 #include "3dsystem/phd_math.h"
 #include "config.h"
+#include "game/ai_scheduler.h"
+#include "game/box_cluster.h"
+#include "game/box_field.h"
 #include "game/control.h"
 #include "game/draw.h"
 #include "game/items.h"
@@ -52,12 +55,13 @@ void CreatureAIInfo(ITEM_INFO *item, AI_INFO *info)
     g_LaraItem->box_number = r->floor[x_floor + y_floor * r->x_size].box;
     info->enemy_zone = zone[g_LaraItem->box_number];
 
+    const LOT_INFO *search = BoxField_GetSearch(&creature->LOT);
     if (g_Boxes[g_LaraItem->box_number].overlap_index
         & creature->LOT.block_mask) {
         info->enemy_zone |= BLOCKED;
     } else if (
-        creature->LOT.node[item->box_number].search_number
-        == (creature->LOT.search_number | BLOCKED_SEARCH)) {
+        search->node[item->box_number].search_number
+        == (search->search_number | BLOCKED_SEARCH)) {
         info->enemy_zone |= BLOCKED;
     }
 
@@ -97,6 +101,7 @@ int32_t SearchLOT(LOT_INFO *LOT, int32_t expansion)
     int16_t search_zone = zone[LOT->head];
     for (int i = 0; i < expansion; i++) {
         if (LOT->head == NO_BOX) {
+            AIScheduler_AddCost(i);
             return 0;
         }
 
@@ -116,6 +121,10 @@ int32_t SearchLOT(LOT_INFO *LOT, int32_t expansion)
                 continue;
             }
 
+            if (!BoxCluster_IsAllowed(LOT, box_number)) {
+                continue;
+            }
+
             int change = g_Boxes[box_number].height - box->height;
             if (change > LOT->step || change < LOT->drop) {
                 continue;
@@ -159,30 +168,45 @@ int32_t SearchLOT(LOT_INFO *LOT, int32_t expansion)
         node->next_expansion = NO_BOX;
     }
 
+    AIScheduler_AddCost(expansion);
     return 1;
 }
 
-int32_t UpdateLOT(LOT_INFO *LOT, int32_t expansion)
+int32_t UpdateLOT(LOT_INFO *LOT, int32_t expansion, int16_t from_box)
 {
+    if (g_Config.enable_shared_pathfinding) {
+        if (LOT->required_box != NO_BOX) {
+            LOT->target_box = LOT->required_box;
+        }
+        BoxField_Update(LOT, expansion, from_box);
+        return 1;
+    }
+
     if (LOT->required_box != NO_BOX && LOT->required_box != LOT->target_box) {
         LOT->target_box = LOT->required_box;
+        RestartLOT(LOT);
+        BoxCluster_Restrict(LOT, from_box);
+    }
 
-        BOX_NODE *expand = &LOT->node[LOT->target_box];
-        if (expand->next_expansion == NO_BOX && LOT->tail != LOT->target_box) {
-            expand->next_expansion = LOT->head;
+    BoxCluster_Check(LOT, from_box);
+    return SearchLOT(LOT, expansion);
+}
 
-            if (LOT->head == NO_BOX) {
-                LOT->tail = LOT->target_box;
-            }
+void RestartLOT(LOT_INFO *LOT)
+{
+    BOX_NODE *expand = &LOT->node[LOT->target_box];
+    if (expand->next_expansion == NO_BOX && LOT->tail != LOT->target_box) {
+        expand->next_expansion = LOT->head;
 
-            LOT->head = LOT->target_box;
+        if (LOT->head == NO_BOX) {
+            LOT->tail = LOT->target_box;
         }
 
-        expand->search_number = ++LOT->search_number;
-        expand->exit_box = NO_BOX;
+        LOT->head = LOT->target_box;
     }
 
-    return SearchLOT(LOT, expansion);
+    expand->search_number = ++LOT->search_number;
+    expand->exit_box = NO_BOX;
 }
 
 void TargetBox(LOT_INFO *LOT, int16_t box_number)
@@ -290,8 +314,9 @@ void CreatureMood(ITEM_INFO *item, AI_INFO *info, int32_t violent)
     }
 
     LOT_INFO *LOT = &creature->LOT;
-    if (LOT->node[item->box_number].search_number
-        == (LOT->search_number | BLOCKED_SEARCH)) {
+    const LOT_INFO *search = BoxField_GetSearch(LOT);
+    if (search->node[item->box_number].search_number
+        == (search->search_number | BLOCKED_SEARCH)) {
         LOT->required_box = NO_BOX;
     }
 
@@ -456,7 +481,12 @@ int32_t CalculateTarget(PHD_VECTOR *target, ITEM_INFO *item, LOT_INFO *LOT)
     int32_t top = 0;
     int32_t bottom = 0;
 
-    UpdateLOT(LOT, MAX_EXPANSION);
+    // a shared search is expanded by every creature using it, so it still
+    // grows by MAX_EXPANSION per creature each frame and picks up where it
+    // left off, even right after every search was dropped at once
+    UpdateLOT(
+        LOT, AIScheduler_GetExpansions(item, MAX_EXPANSION), item->box_number);
+    const LOT_INFO *search = BoxField_GetSearch(LOT);
 
     target->x = item->pos.x;
     target->y = item->pos.y;
@@ -627,7 +657,7 @@ int32_t CalculateTarget(PHD_VECTOR *target, ITEM_INFO *item, LOT_INFO *LOT)
             return TARGET_PRIMARY;
         }
 
-        box_number = LOT->node[box_number].exit_box;
+        box_number = search->node[box_number].exit_box;
         if (box_number != NO_BOX
             && (g_Boxes[box_number].overlap_index & LOT->block_mask)) {
             break;
@@ -734,6 +764,7 @@ int32_t CreatureAnimation(int16_t item_num, int16_t angle, int16_t tilt)
         return 0;
     }
     LOT_INFO *LOT = &creature->LOT;
+    const LOT_INFO *search = BoxField_GetSearch(LOT);
 
     PHD_VECTOR old;
     old.x = item->pos.x;
@@ -766,7 +797,8 @@ int32_t CreatureAnimation(int16_t item_num, int16_t angle, int16_t tilt)
     int16_t room_num = item->room_number;
     FLOOR_INFO *floor = GetFloor(item->pos.x, y, item->pos.z, &room_num);
     int32_t height = g_Boxes[floor->box].height;
-    int16_t next_box = LOT->node[floor->box].exit_box;
+    int16_t next_box =
+        floor->box != NO_BOX ? search->node[floor->box].exit_box : NO_BOX;
     int32_t next_height;
     if (next_box != NO_BOX) {
         next_height = g_Boxes[next_box].height;
@@ -799,7 +831,8 @@ int32_t CreatureAnimation(int16_t item_num, int16_t angle, int16_t tilt)
 
         floor = GetFloor(item->pos.x, y, item->pos.z, &room_num);
         height = g_Boxes[floor->box].height;
-        next_box = LOT->node[floor->box].exit_box;
+        next_box =
+            floor->box != NO_BOX ? search->node[floor->box].exit_box : NO_BOX;
         if (next_box != NO_BOX) {
             next_height = g_Boxes[next_box].height;
         } else {
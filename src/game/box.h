@@ -7,7 +7,8 @@
 void InitialiseCreature(int16_t item_num);
 void CreatureAIInfo(ITEM_INFO *item, AI_INFO *info);
 int32_t SearchLOT(LOT_INFO *LOT, int32_t expansion);
-int32_t UpdateLOT(LOT_INFO *LOT, int32_t expansion);
+int32_t UpdateLOT(LOT_INFO *LOT, int32_t expansion, int16_t from_box);
+void RestartLOT(LOT_INFO *LOT);
 void TargetBox(LOT_INFO *LOT, int16_t box_number);
 int32_t StalkBox(ITEM_INFO *item, int16_t box_number);
 int32_t EscapeBox(ITEM_INFO *item, int16_t box_number);
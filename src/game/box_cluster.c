@@ -0,0 +1,241 @@
+#include "game/box_cluster.h"
+
+#include "config.h"
+#include "game/box.h"
+#include "game/gamebuf.h"
+#include "global/const.h"
+#include "global/vars.h"
+#include "util.h"
+
+#include <stddef.h>
+
+// how many clusters longer than the shortest route a route may be to still
+// be searched
+#define BOX_CLUSTER_SLACK 1
+
+static int32_t m_ClusterCount = 0;
+static int16_t *m_BoxClusters = NULL;
+// cluster links in compressed rows: the neighbours of cluster i are
+// m_Links[m_LinkStart[i]] up to m_Links[m_LinkStart[i + 1]]
+static int32_t *m_LinkStart = NULL;
+static int16_t *m_Links = NULL;
+static int16_t *m_TargetDistance = NULL;
+static int16_t *m_FromDistance = NULL;
+static int16_t *m_Queue = NULL;
+
+static void BoxCluster_AssignBoxes();
+static int32_t BoxCluster_ForEachLink(const int16_t *boxes, bool store);
+static void BoxCluster_Measure(int16_t start, int16_t *distance);
+
+static void BoxCluster_AssignBoxes()
+{
+    for (int i = 0; i < g_NumberBoxes; i++) {
+        m_BoxClusters[i] = -1;
+    }
+
+    // a box that spans more than one room goes with the first of them
+    for (int i = 0; i < g_RoomCount; i++) {
+        const ROOM_INFO *r = &g_RoomInfo[i];
+        const int32_t count = r->x_size * r->y_size;
+        for (int j = 0; j < count; j++) {
+            const int16_t box_number = r->floor[j].box;
+            if (box_number != NO_BOX && m_BoxClusters[box_number] < 0) {
+                m_BoxClusters[box_number] = i;
+            }
+        }
+    }
+}
+
+static int32_t BoxCluster_ForEachLink(const int16_t *boxes, bool store)
+{
+    // m_FromDistance doubles as a marker of the neighbours already seen, so
+    // that each link is only listed once
+    int32_t count = 0;
+    for (int i = 0; i < m_ClusterCount; i++) {
+        m_FromDistance[i] = -1;
+    }
+
+    int32_t box_index = 0;
+    for (int cluster = 0; cluster < m_ClusterCount; cluster++) {
+        if (store) {
+            m_LinkStart[cluster] = count;
+        }
+
+        for (; box_index < g_NumberBoxes; box_index++) {
+            const int16_t box = boxes[box_index];
+            if (box == NO_BOX || m_BoxClusters[box] != cluster) {
+                break;
+            }
+
+            int index = g_Boxes[box].overlap_index & OVERLAP_INDEX;
+            bool done = false;
+            do {
+                int16_t box_number = g_Overlap[index++];
+                if (box_number & END_BIT) {
+                    done = true;
+                    box_number &= BOX_NUMBER;
+                }
+
+                const int16_t other = m_BoxClusters[box_number];
+                if (other < 0 || other == cluster
+                    || m_FromDistance[other] == cluster) {
+                    continue;
+                }
+                m_FromDistance[other] = cluster;
+                if (store) {
+                    m_Links[count] = other;
+                }
+                count++;
+            } while (!done);
+        }
+    }
+
+    if (store) {
+        m_LinkStart[m_ClusterCount] = count;
+    }
+    return count;
+}
+
+static void BoxCluster_Measure(int16_t start, int16_t *distance)
+{
+    for (int i = 0; i < m_ClusterCount; i++) {
+        distance[i] = -1;
+    }
+
+    int32_t head = 0;
+    int32_t tail = 0;
+    distance[start] = 0;
+    m_Queue[tail++] = start;
+    while (head < tail) {
+        const int16_t cluster = m_Queue[head++];
+        for (int i = m_LinkStart[cluster]; i < m_LinkStart[cluster + 1]; i++) {
+            const int16_t other = m_Links[i];
+            if (distance[other] < 0) {
+                distance[other] = distance[cluster] + 1;
+                m_Queue[tail++] = other;
+            }
+        }
+    }
+}
+
+void BoxCluster_Init()
+{
+    m_ClusterCount = g_RoomCount;
+    m_BoxClusters =
+        GameBuf_Alloc(sizeof(int16_t) * g_NumberBoxes, GBUF_CREATURE_LOT);
+    m_LinkStart = GameBuf_Alloc(
+        sizeof(int32_t) * (m_ClusterCount + 1), GBUF_CREATURE_LOT);
+    m_TargetDistance =
+        GameBuf_Alloc(sizeof(int16_t) * m_ClusterCount, GBUF_CREATURE_LOT);
+    m_FromDistance =
+        GameBuf_Alloc(sizeof(int16_t) * m_ClusterCount, GBUF_CREATURE_LOT);
+    m_Queue =
+        GameBuf_Alloc(sizeof(int16_t) * m_ClusterCount, GBUF_CREATURE_LOT);
+
+    BoxCluster_AssignBoxes();
+
+    // the boxes sorted by their cluster, leaving out the ones without any
+    GAMEBUF_SCOPE scope = GameBuf_BeginScratch();
+    int16_t *boxes = GameBuf_AllocScratch(sizeof(int16_t) * g_NumberBoxes);
+    int32_t box_count = 0;
+    for (int cluster = 0; cluster < m_ClusterCount; cluster++) {
+        m_LinkStart[cluster] = box_count;
+    }
+    for (int i = 0; i < g_NumberBoxes; i++) {
+        if (m_BoxClusters[i] >= 0) {
+            box_count++;
+            m_LinkStart[m_BoxClusters[i]]++;
+        }
+    }
+    int32_t offset = 0;
+    for (int cluster = 0; cluster < m_ClusterCount; cluster++) {
+        const int32_t size = m_LinkStart[cluster];
+        m_LinkStart[cluster] = offset;
+        offset += size;
+    }
+    for (int i = 0; i < g_NumberBoxes; i++) {
+        if (m_BoxClusters[i] >= 0) {
+            boxes[m_LinkStart[m_BoxClusters[i]]++] = i;
+        }
+    }
+    for (int i = box_count; i < g_NumberBoxes; i++) {
+        boxes[i] = NO_BOX;
+    }
+
+    const int32_t link_count = BoxCluster_ForEachLink(boxes, false);
+    m_Links = GameBuf_Alloc(
+        sizeof(int16_t) * MAX(link_count, 1), GBUF_CREATURE_LOT);
+    BoxCluster_ForEachLink(boxes, true);
+    GameBuf_EndScratch(scope);
+}
+
+int16_t BoxCluster_GetKey(int16_t target_box, int16_t from_box)
+{
+    if (!g_Config.enable_hierarchical_pathfinding || !m_BoxClusters
+        || from_box == NO_BOX || target_box == NO_BOX) {
+        return -1;
+    }
+
+    const int16_t target_cluster = m_BoxClusters[target_box];
+    const int16_t from_cluster = m_BoxClusters[from_box];
+    if (target_cluster < 0 || target_cluster == from_cluster) {
+        return -1;
+    }
+    return from_cluster;
+}
+
+bool BoxCluster_Restrict(LOT_INFO *LOT, int16_t from_box)
+{
+    const int16_t from_cluster = BoxCluster_GetKey(LOT->target_box, from_box);
+    if (from_cluster < 0) {
+        return false;
+    }
+
+    const int16_t target_cluster = m_BoxClusters[LOT->target_box];
+    BoxCluster_Measure(target_cluster, m_TargetDistance);
+    const int16_t route = m_TargetDistance[from_cluster];
+    if (route < 0) {
+        return false;
+    }
+    BoxCluster_Measure(from_cluster, m_FromDistance);
+
+    if (!LOT->cluster_mask) {
+        LOT->cluster_mask =
+            GameBuf_Alloc(sizeof(uint8_t) * m_ClusterCount, GBUF_CREATURE_LOT);
+    }
+    for (int i = 0; i < m_ClusterCount; i++) {
+        LOT->cluster_mask[i] = m_TargetDistance[i] >= 0
+            && m_FromDistance[i] >= 0
+            && m_TargetDistance[i] + m_FromDistance[i]
+                <= route + BOX_CLUSTER_SLACK;
+    }
+    LOT->cluster_search_number = LOT->search_number;
+    return true;
+}
+
+bool BoxCluster_Check(LOT_INFO *LOT, int16_t from_box)
+{
+    if (!LOT->cluster_mask
+        || LOT->cluster_search_number != LOT->search_number
+        || LOT->head != NO_BOX || from_box == NO_BOX) {
+        return false;
+    }
+
+    const BOX_NODE *node = &LOT->node[from_box];
+    if ((node->search_number & SEARCH_NUMBER)
+        == (LOT->search_number & SEARCH_NUMBER)) {
+        return false;
+    }
+    RestartLOT(LOT);
+    return true;
+}
+
+bool BoxCluster_IsAllowed(const LOT_INFO *LOT, int16_t box_number)
+{
+    if (!LOT->cluster_mask
+        || LOT->cluster_search_number != LOT->search_number) {
+        return true;
+    }
+    const int16_t cluster = m_BoxClusters[box_number];
+    return cluster < 0 || LOT->cluster_mask[cluster];
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "global/types.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// A coarse version of the box graph where every room is a single cluster,
+// built when the level loads. When a search is started towards a box in
+// another room, the way is first worked out over the clusters, and the box
+// search is kept to the rooms along the shortest routes. If the box search
+// runs out without reaching the creature, it is redone over the whole zone.
+// The clusters and their links ignore the zones and the flip state: the
+// limit only ever narrows a search, which still checks the zone of every
+// box, so a link that a zone or a flip closes off just leaves the limit
+// wider than it needs to be.
+
+// Builds the clusters for the current level.
+void BoxCluster_Init();
+
+// Tells which cluster a search towards target_box would be limited for, if
+// started from the given box, or -1 if it would not be limited.
+int16_t BoxCluster_GetKey(int16_t target_box, int16_t from_box);
+
+// Limits a newly started search to the rooms between its target box and the
+// given box. Returns false if the search was left unlimited.
+bool BoxCluster_Restrict(LOT_INFO *LOT, int16_t from_box);
+
+// Redoes a limited search without the limit if it ended without reaching
+// the given box. Returns true if the search was redone.
+bool BoxCluster_Check(LOT_INFO *LOT, int16_t from_box);
+
+// Tells whether a search may expand into the given box.
+bool BoxCluster_IsAllowed(const LOT_INFO *LOT, int16_t box_number);
@@ -0,0 +1,183 @@
+#include "game/box_field.h"
+
+#include "game/box.h"
+#include "game/box_cluster.h"
+#include "game/gamebuf.h"
+#include "game/lot.h"
+#include "global/const.h"
+#include "global/vars.h"
+
+#include <stddef.h>
+
+typedef struct BOX_FIELD {
+    uint32_t id;
+    uint32_t last_used;
+    const int16_t *zone;
+    // the cluster of the creature the search was limited for, or -1 if it
+    // covers the whole zone; a limited search can be wrong for creatures
+    // elsewhere, so only those in the same cluster share it
+    int16_t cluster_key;
+    LOT_INFO lot;
+} BOX_FIELD;
+
+static BOX_FIELD *m_Fields = NULL;
+static int32_t m_FieldCount = 0;
+static uint32_t m_NextID = 1;
+// searches with older IDs are out of date; this way invalidating does not
+// touch the pool, which can happen while a level is still being set up
+static uint32_t m_FirstValidID = 1;
+static uint32_t m_Clock = 0;
+
+static bool BoxField_IsValid(const BOX_FIELD *field);
+static const int16_t *BoxField_GetZone(const LOT_INFO *LOT);
+static bool BoxField_Matches(
+    const BOX_FIELD *field, const LOT_INFO *LOT, const int16_t *zone,
+    int16_t cluster_key);
+static BOX_FIELD *BoxField_Find(
+    const LOT_INFO *LOT, const int16_t *zone, int16_t cluster_key);
+static BOX_FIELD *BoxField_GetFree();
+static void BoxField_Start(
+    BOX_FIELD *field, const LOT_INFO *LOT, const int16_t *zone);
+
+static bool BoxField_IsValid(const BOX_FIELD *field)
+{
+    return field->id >= m_FirstValidID;
+}
+
+static const int16_t *BoxField_GetZone(const LOT_INFO *LOT)
+{
+    if (LOT->fly) {
+        return g_FlyZone[g_FlipStatus];
+    } else if (LOT->step == STEP_L) {
+        return g_GroundZone[g_FlipStatus];
+    } else {
+        return g_GroundZone2[g_FlipStatus];
+    }
+}
+
+static bool BoxField_Matches(
+    const BOX_FIELD *field, const LOT_INFO *LOT, const int16_t *zone,
+    int16_t cluster_key)
+{
+    return BoxField_IsValid(field) && field->zone == zone
+        && field->lot.target_box == LOT->target_box
+        && field->lot.step == LOT->step && field->lot.drop == LOT->drop
+        && field->lot.block_mask == LOT->block_mask
+        && (field->cluster_key == -1 || field->cluster_key == cluster_key);
+}
+
+static BOX_FIELD *BoxField_Find(
+    const LOT_INFO *LOT, const int16_t *zone, int16_t cluster_key)
+{
+    for (int i = 0; i < m_FieldCount; i++) {
+        if (BoxField_Matches(&m_Fields[i], LOT, zone, cluster_key)) {
+            return &m_Fields[i];
+        }
+    }
+    return NULL;
+}
+
+static BOX_FIELD *BoxField_GetFree()
+{
+    BOX_FIELD *oldest = &m_Fields[0];
+    for (int i = 0; i < m_FieldCount; i++) {
+        BOX_FIELD *field = &m_Fields[i];
+        if (!BoxField_IsValid(field)) {
+            return field;
+        }
+        if (field->last_used < oldest->last_used) {
+            oldest = field;
+        }
+    }
+    return oldest;
+}
+
+static void BoxField_Start(
+    BOX_FIELD *field, const LOT_INFO *LOT, const int16_t *zone)
+{
+    LOT_INFO *search = &field->lot;
+    if (!search->node) {
+        InitialiseLOT(search);
+    } else {
+        ClearLOT(search);
+    }
+    search->step = LOT->step;
+    search->drop = LOT->drop;
+    search->fly = LOT->fly;
+    search->block_mask = LOT->block_mask;
+    search->target_box = LOT->target_box;
+
+    RestartLOT(search);
+
+    field->id = m_NextID++;
+    field->zone = zone;
+}
+
+void BoxField_Init()
+{
+    // one per creature slot and one for Lara, so that every LOT can keep its
+    // own search even when all of them head for different boxes
+    m_FieldCount = GetBaddieSlotCount() + 1;
+    m_Fields =
+        GameBuf_Alloc(sizeof(BOX_FIELD) * m_FieldCount, GBUF_CREATURE_LOT);
+    for (int i = 0; i < m_FieldCount; i++) {
+        m_Fields[i].id = 0;
+        m_Fields[i].lot.node = NULL;
+    }
+    m_Clock = 0;
+    m_FirstValidID = m_NextID;
+}
+
+void BoxField_Invalidate()
+{
+    m_FirstValidID = m_NextID;
+}
+
+void BoxField_Update(LOT_INFO *LOT, int32_t expansion, int16_t from_box)
+{
+    if (LOT->target_box == NO_BOX || !m_Fields) {
+        LOT->field = NULL;
+        return;
+    }
+
+    const int16_t *zone = BoxField_GetZone(LOT);
+    const int16_t cluster_key = BoxCluster_GetKey(LOT->target_box, from_box);
+    BOX_FIELD *field = LOT->field;
+    if (!field || field->id != LOT->field_id
+        || !BoxField_Matches(field, LOT, zone, cluster_key)) {
+        field = BoxField_Find(LOT, zone, cluster_key);
+        if (!field) {
+            // a creature that may not search this frame waits for its turn,
+            // rather than starting a search it cannot expand and possibly
+            // taking the place of one that another creature is using
+            if (!expansion) {
+                return;
+            }
+            field = BoxField_GetFree();
+            BoxField_Start(field, LOT, zone);
+            field->cluster_key = BoxCluster_Restrict(&field->lot, from_box)
+                ? cluster_key
+                : -1;
+        }
+    }
+
+    if (BoxCluster_Check(&field->lot, from_box)) {
+        field->cluster_key = -1;
+    }
+    if (field->lot.head != NO_BOX) {
+        SearchLOT(&field->lot, expansion);
+    }
+
+    field->last_used = ++m_Clock;
+    LOT->field = field;
+    LOT->field_id = field->id;
+}
+
+const LOT_INFO *BoxField_GetSearch(const LOT_INFO *LOT)
+{
+    const BOX_FIELD *field = LOT->field;
+    if (field && field->id == LOT->field_id && BoxField_IsValid(field)) {
+        return &field->lot;
+    }
+    return LOT;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "global/types.h"
+
+// Box graph searches shared between creatures. Rather than every creature
+// expanding its own search towards its target box, the search is done once
+// for each target box and set of movement limits, and every creature heading
+// for the same box with the same limits adds to and reads the same results.
+// Most of the time that is all the creatures that are chasing Lara.
+
+// Sets up the search pool for the current level.
+void BoxField_Init();
+
+// Drops every search, for when boxes get blocked or unblocked.
+void BoxField_Invalidate();
+
+// Finds or starts the search towards LOT->target_box from the given box and
+// expands it by up to the given number of boxes. A search that is not
+// finished carries on from where it stopped the next time it is expanded.
+void BoxField_Update(LOT_INFO *LOT, int32_t expansion, int16_t from_box);
+
+// Returns the LOT whose nodes hold the search results for the given LOT,
+// which is the LOT itself if it does not use a shared search.
+const LOT_INFO *BoxField_GetSearch(const LOT_INFO *LOT);
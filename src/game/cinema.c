@@ -10,6 +10,7 @@
 #include "game/output.h"
 #include "game/setup.h"
 #include "game/sound.h"
+#include "game/visibility.h"
 #include "global/const.h"
 #include "global/types.h"
 #include "global/vars.h"
@@ -60,12 +61,10 @@ void InitCinematicRooms()
         }
     }
 
-    g_RoomsToDrawCount = 0;
+    Visibility_ClearRoomsToDraw();
     for (int16_t room_num = 0; room_num < g_RoomCount; room_num++) {
         if (!g_RoomInfo[room_num].bound_active) {
-            if (g_RoomsToDrawCount + 1 < MAX_ROOMS_TO_DRAW) {
-                g_RoomsToDraw[g_RoomsToDrawCount++] = room_num;
-            }
+            Visibility_AddRoomToDraw(room_num);
         }
     }
 }
@@ -7,6 +7,7 @@
 #include "game/items.h"
 #include "game/sound.h"
 #include "game/sphere.h"
+#include "game/visibility.h"
 #include "global/const.h"
 #include "global/types.h"
 #include "global/vars.h"
@@ -468,10 +469,8 @@ int32_t CollideStaticObjects(
 void GetNearByRooms(
     int32_t x, int32_t y, int32_t z, int32_t r, int32_t h, int16_t room_num)
 {
-    g_RoomsToDrawCount = 0;
-    if (g_RoomsToDrawCount + 1 < MAX_ROOMS_TO_DRAW) {
-        g_RoomsToDraw[g_RoomsToDrawCount++] = room_num;
-    }
+    Visibility_ClearRoomsToDraw();
+    Visibility_AddRoomToDraw(room_num);
     GetNewRoom(x + r, y, z + r, room_num);
     GetNewRoom(x - r, y, z + r, room_num);
     GetNewRoom(x + r, y, z - r, room_num);
@@ -493,9 +492,7 @@ void GetNewRoom(int32_t x, int32_t y, int32_t z, int16_t room_num)
         }
     }
 
-    if (g_RoomsToDrawCount + 1 < MAX_ROOMS_TO_DRAW) {
-        g_RoomsToDraw[g_RoomsToDrawCount++] = room_num;
-    }
+    Visibility_AddRoomToDraw(room_num);
 }
 
 void ShiftItem(ITEM_INFO *item, COLL_INFO *coll)
@@ -2,6 +2,7 @@
 
 #include "3dsystem/phd_math.h"
 #include "config.h"
+#include "game/ai_scheduler.h"
 #include "game/camera.h"
 #include "game/demo.h"
 #include "game/gameflow.h"
@@ -16,6 +17,7 @@
 #include "game/objects/puzzle_hole.h"
 #include "game/objects/switch.h"
 #include "game/overlay.h"
+#include "game/quicksave.h"
 #include "game/sound.h"
 #include "game/traps/lava.h"
 #include "game/traps/movable_block.h"
@@ -233,6 +235,14 @@ int32_t ControlPhase(int32_t nframes, GAMEFLOW_LEVEL_TYPE level_type)
             }
         }
 
+        if (level_type != GFL_DEMO) {
+            if (g_InputDB.quick_save && !g_Lara.death_count) {
+                QuickSave_Save();
+            } else if (g_InputDB.quick_load && QuickSave_Load(g_Input.slow)) {
+                g_OverlayFlag = 1;
+            }
+        }
+
         if (g_Lara.death_count > DEATH_WAIT
             || (g_Lara.death_count > DEATH_WAIT_MIN && g_Input.any
                 && !g_Input.fly_cheat)
@@ -284,6 +294,8 @@ int32_t ControlPhase(int32_t nframes, GAMEFLOW_LEVEL_TYPE level_type)
             }
         }
 
+        AIScheduler_BeginFrame();
+
         int16_t item_num = g_NextItemActive;
         while (item_num != NO_ITEM) {
             ITEM_INFO *item = &g_Items[item_num];
@@ -313,13 +325,7 @@ int32_t ControlPhase(int32_t nframes, GAMEFLOW_LEVEL_TYPE level_type)
         Overlay_BarHealthTimerTick();
 
         if (g_Config.disable_healing_between_levels) {
-            int8_t lara_found = 0;
-            for (int i = 0; i < g_LevelItemCount; i++) {
-                if (g_Items[i].object_number == O_LARA) {
-                    lara_found = 1;
-                }
-            }
-            if (lara_found) {
+            if (g_Lara.item_number != NO_ITEM) {
                 g_StoredLaraHealth =
                     g_LaraItem ? g_LaraItem->hit_points : LARA_HITPOINTS;
             }
@@ -59,6 +59,17 @@ int32_t StartDemo()
     // so temporarily turn off all the T1M enhancements
     int8_t old_enhanced_look = g_Config.enable_enhanced_look;
     g_Config.enable_enhanced_look = 0;
+    // the shared searches find the path sooner, which changes how the
+    // creatures move
+    bool old_shared_pathfinding = g_Config.enable_shared_pathfinding;
+    g_Config.enable_shared_pathfinding = false;
+    int32_t old_creature_slots = g_Config.creature_slots;
+    g_Config.creature_slots = NUM_SLOTS;
+    int32_t old_pathfinding_budget = g_Config.pathfinding_budget;
+    g_Config.pathfinding_budget = 0;
+    bool old_hierarchical_pathfinding =
+        g_Config.enable_hierarchical_pathfinding;
+    g_Config.enable_hierarchical_pathfinding = false;
 
     if (InitialiseLevel(m_DemoLevel)) {
         LoadLaraDemoPos();
@@ -80,6 +91,10 @@ int32_t StartDemo()
     }
 
     g_Config.enable_enhanced_look = old_enhanced_look;
+    g_Config.enable_shared_pathfinding = old_shared_pathfinding;
+    g_Config.creature_slots = old_creature_slots;
+    g_Config.pathfinding_budget = old_pathfinding_budget;
+    g_Config.enable_hierarchical_pathfinding = old_hierarchical_pathfinding;
 
     return GF_EXIT_TO_TITLE;
 }
@@ -10,12 +10,14 @@
 #include "game/overlay.h"
 #include "game/random.h"
 #include "game/viewport.h"
+#include "game/visibility.h"
 #include "global/const.h"
 #include "global/vars.h"
 #include "specific/s_misc.h"
 
 static int16_t m_InterpolatedBounds[6] = { 0 };
 static bool m_CameraUnderwater = false;
+static int16_t m_ViewRoom = -1;
 
 void DrawRooms(int16_t current_room)
 {
@@ -25,30 +27,36 @@ void DrawRooms(int16_t current_room)
     g_PhdBottom = ViewPort_GetMaxY();
 
     ROOM_INFO *r = &g_RoomInfo[current_room];
-    r->left = g_PhdLeft;
-    r->top = g_PhdTop;
-    r->right = g_PhdRight;
-    r->bottom = g_PhdBottom;
-    r->bound_active = 1;
-
-    g_RoomsToDrawCount = 0;
-    if (g_RoomsToDrawCount + 1 < MAX_ROOMS_TO_DRAW) {
-        g_RoomsToDraw[g_RoomsToDrawCount++] = current_room;
-    }
-
     m_CameraUnderwater = r->flags & RF_UNDERWATER;
+    m_ViewRoom = current_room;
+
+    // a camera that stays in place sees the same rooms as in the last frame
+    if (!Visibility_RestoreRooms(current_room)) {
+        r->left = g_PhdLeft;
+        r->top = g_PhdTop;
+        r->right = g_PhdRight;
+        r->bottom = g_PhdBottom;
+        r->bound_active = 1;
 
-    phd_PushMatrix();
-    phd_TranslateAbs(r->x, r->y, r->z);
-    if (r->doors) {
-        for (int i = 0; i < r->doors->count; i++) {
-            DOOR_INFO *door = &r->doors->door[i];
-            if (SetRoomBounds(&door->x, door->room_num, r)) {
-                GetRoomBounds(door->room_num);
+        Visibility_ClearRoomsToDraw();
+        Visibility_AddRoomToDraw(current_room);
+
+        phd_PushMatrix();
+        phd_TranslateAbs(r->x, r->y, r->z);
+        if (r->doors) {
+            for (int i = 0; i < r->doors->count; i++) {
+                DOOR_INFO *door = &r->doors->door[i];
+                if (Visibility_IsRoomPotentiallyVisible(
+                        m_ViewRoom, door->room_num)
+                    && SetRoomBounds(&door->x, door->room_num, r)) {
+                    GetRoomBounds(door->room_num);
+                }
             }
         }
+        phd_PopMatrix();
+
+        Visibility_StoreRooms(current_room);
     }
-    phd_PopMatrix();
     Output_ClearScreen();
 
     for (int i = 0; i < g_RoomsToDrawCount; i++) {
@@ -73,7 +81,8 @@ void GetRoomBounds(int16_t room_num)
     if (r->doors) {
         for (int i = 0; i < r->doors->count; i++) {
             DOOR_INFO *door = &r->doors->door[i];
-            if (SetRoomBounds(&door->x, door->room_num, r)) {
+            if (Visibility_IsRoomPotentiallyVisible(m_ViewRoom, door->room_num)
+                && SetRoomBounds(&door->x, door->room_num, r)) {
                 GetRoomBounds(door->room_num);
             }
         }
@@ -213,9 +222,7 @@ int32_t SetRoomBounds(int16_t *objptr, int16_t room_num, ROOM_INFO *parent)
     }
 
     if (!r->bound_active) {
-        if (g_RoomsToDrawCount + 1 < MAX_ROOMS_TO_DRAW) {
-            g_RoomsToDraw[g_RoomsToDrawCount++] = room_num;
-        }
+        Visibility_AddRoomToDraw(room_num);
         r->bound_active = 1;
     }
     return 1;
@@ -240,7 +247,7 @@ void PrintRooms(int16_t room_number)
     g_PhdTop = r->top;
     g_PhdBottom = r->bottom;
 
-    Output_DrawRoom(r->data);
+    Output_DrawRoom(room_number);
 
     for (int i = r->item_number; i != NO_ITEM; i = g_Items[i].next_item) {
         ITEM_INFO *item = &g_Items[i];
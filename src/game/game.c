@@ -3,6 +3,7 @@
 #include "game/inv.h"
 #include "game/settings.h"
 #include "config.h"
+#include "game/ai_scheduler.h"
 #include "game/camera.h"
 #include "game/control.h"
 #include "game/draw.h"
@@ -10,6 +11,7 @@
 #include "game/input.h"
 #include "game/music.h"
 #include "game/output.h"
+#include "game/quicksave.h"
 #include "game/savegame.h"
 #include "game/screen.h"
 #include "game/setup.h"
@@ -35,6 +37,8 @@ int32_t StartGame(int32_t level_num, GAMEFLOW_LEVEL_TYPE level_type)
         return GF_EXIT_TO_TITLE;
     }
 
+    SaveGame_StoreItemBaseline();
+    QuickSave_StoreLevelState();
     if (level_type == GFL_SAVED) {
         SaveGame_ApplySaveBuffer(&g_GameInfo);
     }
@@ -83,6 +87,7 @@ int32_t GameLoop(GAMEFLOW_LEVEL_TYPE level_type)
             break;
         }
         nframes = Draw_ProcessFrame();
+        SaveGame_UpdateWrite();
 
         if (ask_for_save) {
             int32_t return_val = Display_Inventory(INV_SAVE_CRYSTAL_MODE);
@@ -94,6 +99,7 @@ int32_t GameLoop(GAMEFLOW_LEVEL_TYPE level_type)
         }
     }
 
+    AIScheduler_LogStats();
     Sound_StopAllSamples();
     Music_Stop();
     Music_SetVolume(g_Config.music_volume);
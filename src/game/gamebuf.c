@@ -1,13 +1,59 @@
 #include "game/gamebuf.h"
 
-#include "game/shell.h"
+#include "filesystem.h"
+#include "json.h"
+#include "log.h"
 #include "memory.h"
+#include "util.h"
 
-#define MALLOC_SIZE 0x1000000 // 16 MB
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
 
-static char *m_GameMemoryPointer = NULL;
-static char *m_GameAllocMemPointer = NULL;
-static size_t m_GameAllocMemFree = 0;
+#define GAMEBUF_BLOCK_SIZE 0x1000000 // 16 MB
+#define GAMEBUF_SCRATCH_BLOCK_SIZE 0x100000 // 1 MB
+#define GAMEBUF_ALIGNMENT 16
+
+typedef struct GAMEBUF_BLOCK {
+    struct GAMEBUF_BLOCK *next;
+    size_t size;
+    size_t used;
+    size_t dirty;
+    char *data;
+} GAMEBUF_BLOCK;
+
+typedef struct GAMEBUF_ARENA {
+    GAMEBUF_BLOCK *first_block;
+    GAMEBUF_BLOCK *current_block;
+    int32_t block_count;
+    size_t block_size;
+} GAMEBUF_ARENA;
+
+typedef struct GAMEBUF_STATS {
+    size_t bytes;
+    size_t peak;
+    int32_t count;
+} GAMEBUF_STATS;
+
+static GAMEBUF_ARENA m_Arena = { .block_size = GAMEBUF_BLOCK_SIZE };
+static GAMEBUF_ARENA m_ScratchArena = {
+    .block_size = GAMEBUF_SCRATCH_BLOCK_SIZE,
+};
+static int32_t m_ScratchDepth = 0;
+static size_t m_ScratchBytes = 0;
+static size_t m_ScratchPeak = 0;
+static size_t m_TotalBytes = 0;
+static size_t m_TotalPeak = 0;
+static GAMEBUF_STATS m_Stats[GBUF_NUMBER_OF] = { 0 };
+
+static const char *GameBuf_GetBufferName(GAME_BUFFER buffer);
+static GAMEBUF_BLOCK *GameBuf_AllocBlock(size_t size);
+static void *GameBuf_ArenaAlloc(GAMEBUF_ARENA *arena, size_t size);
+static void GameBuf_ArenaRewind(
+    GAMEBUF_ARENA *arena, GAMEBUF_BLOCK *block, size_t used);
+static void GameBuf_ArenaFree(GAMEBUF_ARENA *arena);
+static size_t GameBuf_AlignSize(size_t size);
+static void GameBuf_ResetStats();
 
 static const char *GameBuf_GetBufferName(GAME_BUFFER buffer)
 {
@@ -46,37 +92,242 @@ static const char *GameBuf_GetBufferName(GAME_BUFFER buffer)
         case GBUF_SAMPLES:                  return "Samples";
         case GBUF_TRAP_DATA:                return "Trap data";
         case GBUF_CREATURE_DATA:            return "Creature data";
+        case GBUF_NUMBER_OF:                break;
     }
     // clang-format on
     return "Unknown";
 };
 
+static GAMEBUF_BLOCK *GameBuf_AllocBlock(size_t size)
+{
+    // the block header and its data share a single allocation, with enough
+    // slack to align the data
+    GAMEBUF_BLOCK *block =
+        Memory_Alloc(sizeof(GAMEBUF_BLOCK) + size + GAMEBUF_ALIGNMENT);
+    const uintptr_t data = (uintptr_t)(block + 1);
+    block->data = (char *)((data + GAMEBUF_ALIGNMENT - 1)
+                           & ~(uintptr_t)(GAMEBUF_ALIGNMENT - 1));
+    block->size = size;
+    block->used = 0;
+    block->dirty = 0;
+    block->next = NULL;
+    return block;
+}
+
+static void *GameBuf_ArenaAlloc(GAMEBUF_ARENA *arena, size_t size)
+{
+    if (!arena->first_block) {
+        arena->first_block = GameBuf_AllocBlock(arena->block_size);
+        arena->current_block = arena->first_block;
+        arena->block_count = 1;
+    }
+
+    // the blocks past the current one are always rewound, so they can be
+    // reused as they are; a new block is only chained on at the very end
+    GAMEBUF_BLOCK *block = arena->current_block;
+    while (size > block->size - block->used) {
+        if (!block->next) {
+            block->next = GameBuf_AllocBlock(MAX(size, arena->block_size));
+            arena->block_count++;
+        }
+        block = block->next;
+    }
+    arena->current_block = block;
+
+    // fresh blocks come zeroed, so only the memory handed out before the
+    // last rewind needs clearing
+    char *result = block->data + block->used;
+    if (block->used < block->dirty) {
+        memset(result, 0, MIN(size, block->dirty - block->used));
+    }
+    block->used += size;
+    block->dirty = MAX(block->dirty, block->used);
+    return result;
+}
+
+static void GameBuf_ArenaRewind(
+    GAMEBUF_ARENA *arena, GAMEBUF_BLOCK *block, size_t used)
+{
+    if (!block) {
+        block = arena->first_block;
+        used = 0;
+    }
+    if (!block) {
+        return;
+    }
+
+    block->used = used;
+    for (GAMEBUF_BLOCK *next = block->next; next; next = next->next) {
+        next->used = 0;
+    }
+    arena->current_block = block;
+}
+
+static void GameBuf_ArenaFree(GAMEBUF_ARENA *arena)
+{
+    GAMEBUF_BLOCK *block = arena->first_block;
+    while (block) {
+        GAMEBUF_BLOCK *next = block->next;
+        Memory_FreePointer(&block);
+        block = next;
+    }
+    arena->first_block = NULL;
+    arena->current_block = NULL;
+    arena->block_count = 0;
+}
+
+static size_t GameBuf_AlignSize(size_t size)
+{
+    return (size + GAMEBUF_ALIGNMENT - 1) & ~(size_t)(GAMEBUF_ALIGNMENT - 1);
+}
+
+static void GameBuf_ResetStats()
+{
+    // the peaks are kept so that they cover every level played so far
+    m_TotalBytes = 0;
+    for (int i = 0; i < GBUF_NUMBER_OF; i++) {
+        m_Stats[i].bytes = 0;
+        m_Stats[i].count = 0;
+    }
+}
+
 void GameBuf_Init()
 {
-    m_GameMemoryPointer = Memory_Alloc(MALLOC_SIZE);
-    m_GameAllocMemPointer = m_GameMemoryPointer;
-    m_GameAllocMemFree = MALLOC_SIZE;
+    GameBuf_Reset();
+}
+
+void GameBuf_Reset()
+{
+    assert(!m_ScratchDepth);
+    GameBuf_ArenaRewind(&m_Arena, NULL, 0);
+    GameBuf_ArenaRewind(&m_ScratchArena, NULL, 0);
+    m_ScratchBytes = 0;
+    GameBuf_ResetStats();
 }
 
 void GameBuf_Shutdown()
 {
-    Memory_FreePointer(&m_GameMemoryPointer);
-    m_GameAllocMemPointer = NULL;
-    m_GameAllocMemFree = 0;
+    GameBuf_ArenaFree(&m_Arena);
+    GameBuf_ArenaFree(&m_ScratchArena);
+    m_ScratchDepth = 0;
+    m_ScratchBytes = 0;
+    GameBuf_ResetStats();
 }
 
 void *GameBuf_Alloc(int32_t alloc_size, GAME_BUFFER buffer)
 {
-    size_t aligned_size = (alloc_size + 3) & ~3;
+    assert(alloc_size >= 0);
+    assert(buffer >= 0 && buffer < GBUF_NUMBER_OF);
 
-    if (aligned_size > m_GameAllocMemFree) {
-        Shell_ExitSystemFmt(
-            "GameBuf_Alloc(): OUT OF MEMORY %s %d",
+    const size_t aligned_size = GameBuf_AlignSize(alloc_size);
+    const int32_t block_count = m_Arena.block_count;
+    void *result = GameBuf_ArenaAlloc(&m_Arena, aligned_size);
+    if (block_count && m_Arena.block_count != block_count) {
+        LOG_INFO(
+            "growing to %d blocks for %s (%zu bytes)", m_Arena.block_count,
             GameBuf_GetBufferName(buffer), aligned_size);
     }
 
-    void *result = m_GameAllocMemPointer;
-    m_GameAllocMemFree -= aligned_size;
-    m_GameAllocMemPointer += aligned_size;
+    GAMEBUF_STATS *stats = &m_Stats[buffer];
+    stats->bytes += aligned_size;
+    stats->count++;
+    stats->peak = MAX(stats->peak, stats->bytes);
+    m_TotalBytes += aligned_size;
+    m_TotalPeak = MAX(m_TotalPeak, m_TotalBytes);
     return result;
 }
+
+GAMEBUF_SCOPE GameBuf_BeginScratch()
+{
+    m_ScratchDepth++;
+    return (GAMEBUF_SCOPE) {
+        .block = m_ScratchArena.current_block,
+        .used = m_ScratchArena.current_block
+            ? m_ScratchArena.current_block->used
+            : 0,
+        .bytes = m_ScratchBytes,
+    };
+}
+
+void *GameBuf_AllocScratch(int32_t alloc_size)
+{
+    assert(m_ScratchDepth > 0);
+    assert(alloc_size >= 0);
+
+    const size_t aligned_size = GameBuf_AlignSize(alloc_size);
+    void *result = GameBuf_ArenaAlloc(&m_ScratchArena, aligned_size);
+    m_ScratchBytes += aligned_size;
+    m_ScratchPeak = MAX(m_ScratchPeak, m_ScratchBytes);
+    return result;
+}
+
+void *GameBuf_AllocScratchJSON(void *user_data, size_t size)
+{
+    if (size > INT32_MAX) {
+        return NULL;
+    }
+    return GameBuf_AllocScratch(size);
+}
+
+void GameBuf_EndScratch(GAMEBUF_SCOPE scope)
+{
+    assert(m_ScratchDepth > 0);
+    m_ScratchDepth--;
+    GameBuf_ArenaRewind(&m_ScratchArena, scope.block, scope.used);
+    m_ScratchBytes = scope.bytes;
+}
+
+void GameBuf_LogStats()
+{
+    LOG_INFO(
+        "%zu bytes in %d blocks (peak %zu bytes, scratch peak %zu bytes)",
+        m_TotalBytes, m_Arena.block_count, m_TotalPeak, m_ScratchPeak);
+    for (int i = 0; i < GBUF_NUMBER_OF; i++) {
+        const GAMEBUF_STATS *stats = &m_Stats[i];
+        if (!stats->peak) {
+            continue;
+        }
+        LOG_INFO(
+            "%s: %zu bytes in %d allocations (peak %zu bytes)",
+            GameBuf_GetBufferName(i), stats->bytes, stats->count, stats->peak);
+    }
+}
+
+bool GameBuf_WriteStats(const char *path)
+{
+    MYFILE *fp = File_Open(path, FILE_OPEN_WRITE);
+    if (!fp) {
+        LOG_ERROR("Can't open file %s", path);
+        return false;
+    }
+
+    struct json_object_s *root_obj = json_object_new();
+    json_object_append_number_int(root_obj, "bytes", m_TotalBytes);
+    json_object_append_number_int(root_obj, "peak", m_TotalPeak);
+    json_object_append_number_int(root_obj, "blocks", m_Arena.block_count);
+    json_object_append_number_int(root_obj, "scratch_peak", m_ScratchPeak);
+
+    struct json_object_s *buffers_obj = json_object_new();
+    for (int i = 0; i < GBUF_NUMBER_OF; i++) {
+        const GAMEBUF_STATS *stats = &m_Stats[i];
+        struct json_object_s *buffer_obj = json_object_new();
+        json_object_append_number_int(buffer_obj, "bytes", stats->bytes);
+        json_object_append_number_int(buffer_obj, "peak", stats->peak);
+        json_object_append_number_int(buffer_obj, "count", stats->count);
+        json_object_append(
+            buffers_obj, GameBuf_GetBufferName(i),
+            json_value_from_object(buffer_obj));
+    }
+    json_object_append(
+        root_obj, "buffers", json_value_from_object(buffers_obj));
+
+    size_t size;
+    struct json_value_s *root = json_value_from_object(root_obj);
+    char *data = json_write_pretty(root, "  ", "\n", &size);
+    json_value_free(root);
+
+    File_Write(data, sizeof(char), size - 1, fp);
+    File_Close(fp);
+    Memory_FreePointer(&data);
+    return true;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 // Internal game memory manager. It allocates its internal buffer once per
@@ -8,6 +10,10 @@
 // go, but it makes freeing memory really inconvenient which is why it is
 // intentionally not implemented. To use more dynamic memory management, use
 // Memory_Alloc / Memory_Free.
+//
+// When the buffer runs out, another block is added rather than resizing it, so
+// the returned pointers stay valid until the buffer is reset or shut down. All
+// of them are aligned to 16 bytes and zeroed.
 
 typedef enum GAME_BUFFER {
     GBUF_TEXTURE_PAGES,
@@ -43,8 +49,35 @@ typedef enum GAME_BUFFER {
     GBUF_SAMPLES,
     GBUF_TRAP_DATA,
     GBUF_CREATURE_DATA,
+    GBUF_NUMBER_OF,
 } GAME_BUFFER;
 
+typedef struct GAMEBUF_SCOPE {
+    void *block;
+    size_t used;
+    size_t bytes;
+} GAMEBUF_SCOPE;
+
 void GameBuf_Init();
 void *GameBuf_Alloc(int32_t alloc_size, GAME_BUFFER buffer);
 void GameBuf_Shutdown();
+
+// Releases everything allocated so far, but keeps the memory itself around
+// for the next level.
+void GameBuf_Reset();
+
+// Scratch memory for data that is only needed while loading. It is separate
+// from the level memory, and ending a scope releases everything allocated
+// since it began. Scopes can be nested.
+GAMEBUF_SCOPE GameBuf_BeginScratch();
+void *GameBuf_AllocScratch(int32_t alloc_size);
+void GameBuf_EndScratch(GAMEBUF_SCOPE scope);
+
+// Has the signature of the json_parse_ex allocator, so that JSON documents
+// can be parsed into the current scratch scope and dropped along with it.
+void *GameBuf_AllocScratchJSON(void *user_data, size_t size);
+
+// Reports the bytes used by each buffer, along with the highest usage seen
+// since the game started.
+void GameBuf_LogStats();
+bool GameBuf_WriteStats(const char *path);
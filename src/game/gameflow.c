@@ -773,6 +773,10 @@ static bool GameFlow_LoadFromFileImpl(const char *file_name)
     struct json_value_s *root = NULL;
     char *script_data = NULL;
 
+    // everything that outlives the parse is copied out of the document, so
+    // it can live in scratch memory and be dropped in one go
+    GAMEBUF_SCOPE scope = GameBuf_BeginScratch();
+
     if (!File_Load(file_name, &script_data, NULL)) {
         LOG_ERROR("failed to open script file");
         goto cleanup;
@@ -780,8 +784,9 @@ static bool GameFlow_LoadFromFileImpl(const char *file_name)
 
     struct json_parse_result_s parse_result;
     root = json_parse_ex(
-        script_data, strlen(script_data), json_parse_flags_allow_json5, NULL,
-        NULL, &parse_result);
+        script_data, strlen(script_data),
+        json_parse_flags_allow_json5 | json_parse_flags_build_object_index,
+        GameBuf_AllocScratchJSON, NULL, &parse_result);
     if (!root) {
         LOG_ERROR(
             "failed to parse script file: %s in line %d, char %d",
@@ -798,10 +803,7 @@ static bool GameFlow_LoadFromFileImpl(const char *file_name)
     result &= GameFlow_LoadScriptLevels(root_obj);
 
 cleanup:
-    if (root) {
-        json_value_free(root);
-        root = NULL;
-    }
+    GameBuf_EndScratch(scope);
 
     Memory_FreePointer(&script_data);
     return result;
@@ -812,6 +814,8 @@ void GameFlow_Shutdown()
     Memory_FreePointer(&g_GameFlow.main_menu_background_path);
     Memory_FreePointer(&g_GameFlow.save_game_fmt);
     Memory_FreePointer(&g_GameInfo.start);
+    Memory_FreePointer(&g_GameInfo.savegame_buffer);
+    g_GameInfo.savegame_buffer_size = 0;
 
     for (int i = 0; i < GS_NUMBER_OF; i++) {
         Memory_FreePointer(&g_GameFlow.strings[i]);
@@ -12,6 +12,7 @@
 #include "game/inv.h"
 #include "game/random.h"
 #include "game/sound.h"
+#include "game/spatial_hash.h"
 #include "game/sphere.h"
 #include "global/const.h"
 #include "global/types.h"
@@ -392,31 +393,18 @@ void LaraGetNewTarget(WEAPON_INFO *winfo)
     ITEM_INFO *bestitem = NULL;
     int16_t bestyrot = 0x7FFF;
 
-    int32_t maxdist = winfo->target_dist;
-    int32_t maxdist2 = maxdist * maxdist;
     GAME_VECTOR src;
     src.x = g_LaraItem->pos.x;
     src.y = g_LaraItem->pos.y - 650;
     src.z = g_LaraItem->pos.z;
     src.room_number = g_LaraItem->room_number;
 
-    ITEM_INFO *item = NULL;
-    for (int16_t item_num = g_NextItemActive; item_num != NO_ITEM;
-         item_num = item->next_active) {
-        item = &g_Items[item_num];
-        if (item->hit_points <= 0) {
-            continue;
-        }
-
-        int32_t x = item->pos.x - src.x;
-        int32_t y = item->pos.y - src.y;
-        int32_t z = item->pos.z - src.z;
-        if (ABS(x) > maxdist || ABS(y) > maxdist || ABS(z) > maxdist) {
-            continue;
-        }
-
-        int32_t dist = x * x + y * y + z * z;
-        if (dist >= maxdist2) {
+    const int16_t *item_nums;
+    const int32_t item_count = SpatialHash_FindItems(
+        src.x, src.y, src.z, winfo->target_dist, &item_nums);
+    for (int i = 0; i < item_count; i++) {
+        ITEM_INFO *item = &g_Items[item_nums[i]];
+        if (!item->active || item->hit_points <= 0) {
             continue;
         }
 
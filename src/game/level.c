@@ -6,15 +6,19 @@
 #include "game/gamebuf.h"
 #include "game/gameflow.h"
 #include "game/items.h"
+#include "game/level_cache.h"
 #include "game/output.h"
 #include "game/setup.h"
 #include "game/shell.h"
 #include "game/sound.h"
 #include "game/viewport.h"
+#include "game/visibility.h"
 #include "global/vars.h"
 #include "log.h"
 #include "memory.h"
+#include "specific/s_job.h"
 
+#include <stdint.h>
 #include <stdio.h>
 
 static int32_t m_MeshCount = 0;
@@ -35,6 +39,16 @@ static int32_t m_SpriteInfoCount = 0;
 static int32_t m_SpriteCount = 0;
 static int32_t m_OverlapCount = 0;
 
+// the samples are decoded after the whole file is parsed
+static int32_t m_SampleCount = 0;
+static const char **m_SamplePointers = NULL;
+static size_t *m_SampleSizes = NULL;
+static bool m_SamplesLoaded = false;
+
+// the level file stays mapped for as long as the level is loaded, since the
+// large arrays point straight into it
+static MYFILE *m_LevelFile = NULL;
+
 static bool Level_LoadRooms(MYFILE *fp);
 static bool Level_LoadObjects(MYFILE *fp);
 static bool Level_LoadSprites(MYFILE *fp);
@@ -49,6 +63,10 @@ static bool Level_LoadCinematic(MYFILE *fp);
 static bool Level_LoadDemo(MYFILE *fp);
 static bool Level_LoadSamples(MYFILE *fp);
 static bool Level_LoadTexturePages(MYFILE *fp);
+static void Level_DecodeSamples(void *arg);
+static void *Level_ReadArray(
+    MYFILE *fp, size_t item_size, size_t count, size_t alignment,
+    GAME_BUFFER buffer);
 
 static bool Level_LoadFromFile(const char *filename, int32_t level_num);
 
@@ -57,14 +75,18 @@ static bool Level_LoadFromFile(const char *filename, int32_t level_num)
     int32_t version;
     int32_t file_level_num;
 
-    GameBuf_Shutdown();
-    GameBuf_Init();
-    MYFILE *fp = File_Open(filename, FILE_OPEN_READ);
+    GameBuf_Reset();
+    if (m_LevelFile) {
+        File_Close(m_LevelFile);
+        m_LevelFile = NULL;
+    }
+    MYFILE *fp = File_Open(filename, FILE_OPEN_READ_MAPPED);
     if (!fp) {
         Shell_ExitSystemFmt(
             "Level_LoadFromFile(): Could not open %s", filename);
         return false;
     }
+    m_LevelFile = fp;
 
     File_Read(&version, sizeof(int32_t), 1, fp);
     if (version != 32) {
@@ -133,13 +155,53 @@ static bool Level_LoadFromFile(const char *filename, int32_t level_num)
         return false;
     }
 
-    File_Close(fp);
+    // the samples are decoded in the background while the main thread
+    // uploads the textures and prepares the rooms
+    const bool decode_samples = Sound_PrepareSamples(m_SampleCount);
+    S_JOB *sample_job = NULL;
+    if (decode_samples) {
+        sample_job = S_Job_Start(
+            Level_DecodeSamples, (void *)filename, "level_samples");
+    }
 
     Output_DownloadTextures(m_TexturePageCount);
+    Output_CacheRooms();
+    Visibility_ComputePVS();
+    Visibility_Invalidate();
+
+    S_Job_Wait(sample_job);
+    if (decode_samples && !m_SamplesLoaded) {
+        LOG_ERROR("failed to load %d samples", m_SampleCount);
+    }
+    Memory_FreePointer(&m_SamplePointers);
+    Memory_FreePointer(&m_SampleSizes);
+    m_SampleCount = 0;
+
+    GameBuf_LogStats();
+    if (g_Config.enable_memory_stats) {
+        GameBuf_WriteStats("memory_stats.json");
+    }
 
     return true;
 }
 
+static void *Level_ReadArray(
+    MYFILE *fp, size_t item_size, size_t count, size_t alignment,
+    GAME_BUFFER buffer)
+{
+    const size_t size = item_size * count;
+    void *data = File_MapRange(fp, File_Pos(fp), size);
+    if (data && (uintptr_t)data % alignment == 0) {
+        File_Skip(fp, size);
+        return data;
+    }
+
+    // unaligned arrays and files that could not be mapped are copied
+    data = GameBuf_Alloc(size, buffer);
+    File_Read(data, item_size, count, fp);
+    return data;
+}
+
 static bool Level_LoadRooms(MYFILE *fp)
 {
     uint16_t count2;
@@ -164,9 +226,8 @@ static bool Level_LoadRooms(MYFILE *fp)
 
         // Room mesh
         File_Read(&count4, sizeof(uint32_t), 1, fp);
-        current_room_info->data =
-            GameBuf_Alloc(sizeof(uint16_t) * count4, GBUF_ROOM_MESH);
-        File_Read(current_room_info->data, sizeof(uint16_t), count4, fp);
+        current_room_info->data = Level_ReadArray(
+            fp, sizeof(uint16_t), count4, sizeof(uint16_t), GBUF_ROOM_MESH);
 
         // Doors
         File_Read(&count2, sizeof(uint16_t), 1, fp);
@@ -232,9 +293,9 @@ static bool Level_LoadRooms(MYFILE *fp)
     }
 
     File_Read(&m_FloorDataSize, sizeof(uint32_t), 1, fp);
-    g_FloorData =
-        GameBuf_Alloc(sizeof(uint16_t) * m_FloorDataSize, GBUF_FLOOR_DATA);
-    File_Read(g_FloorData, sizeof(uint16_t), m_FloorDataSize, fp);
+    g_FloorData = Level_ReadArray(
+        fp, sizeof(uint16_t), m_FloorDataSize, sizeof(uint16_t),
+        GBUF_FLOOR_DATA);
 
     return true;
 }
@@ -243,12 +304,13 @@ static bool Level_LoadObjects(MYFILE *fp)
 {
     File_Read(&m_MeshCount, sizeof(int32_t), 1, fp);
     LOG_INFO("%d meshes", m_MeshCount);
-    g_MeshBase = GameBuf_Alloc(sizeof(int16_t) * m_MeshCount, GBUF_MESHES);
-    File_Read(g_MeshBase, sizeof(int16_t), m_MeshCount, fp);
+    g_MeshBase = Level_ReadArray(
+        fp, sizeof(int16_t), m_MeshCount, sizeof(int16_t), GBUF_MESHES);
 
     File_Read(&m_MeshPtrCount, sizeof(int32_t), 1, fp);
+    GAMEBUF_SCOPE scratch = GameBuf_BeginScratch();
     uint32_t *mesh_indices =
-        GameBuf_Alloc(sizeof(uint32_t) * m_MeshPtrCount, GBUF_MESH_POINTERS);
+        GameBuf_AllocScratch(sizeof(uint32_t) * m_MeshPtrCount);
     File_Read(mesh_indices, sizeof(uint32_t), m_MeshPtrCount, fp);
 
     g_Meshes =
@@ -256,6 +318,7 @@ static bool Level_LoadObjects(MYFILE *fp)
     for (int i = 0; i < m_MeshPtrCount; i++) {
         g_Meshes[i] = &g_MeshBase[mesh_indices[i] / 2];
     }
+    GameBuf_EndScratch(scratch);
 
     File_Read(&m_AnimCount, sizeof(int32_t), 1, fp);
     LOG_INFO("%d anims", m_AnimCount);
@@ -276,21 +339,21 @@ static bool Level_LoadObjects(MYFILE *fp)
 
     File_Read(&m_AnimCommandCount, sizeof(int32_t), 1, fp);
     LOG_INFO("%d anim commands", m_AnimCommandCount);
-    g_AnimCommands =
-        GameBuf_Alloc(sizeof(int16_t) * m_AnimCommandCount, GBUF_ANIM_COMMANDS);
-    File_Read(g_AnimCommands, sizeof(int16_t), m_AnimCommandCount, fp);
+    g_AnimCommands = Level_ReadArray(
+        fp, sizeof(int16_t), m_AnimCommandCount, sizeof(int16_t),
+        GBUF_ANIM_COMMANDS);
 
     File_Read(&m_AnimBoneCount, sizeof(int32_t), 1, fp);
     LOG_INFO("%d anim bones", m_AnimBoneCount);
-    g_AnimBones =
-        GameBuf_Alloc(sizeof(int32_t) * m_AnimBoneCount, GBUF_ANIM_BONES);
-    File_Read(g_AnimBones, sizeof(int32_t), m_AnimBoneCount, fp);
+    g_AnimBones = Level_ReadArray(
+        fp, sizeof(int32_t), m_AnimBoneCount, sizeof(int32_t),
+        GBUF_ANIM_BONES);
 
     File_Read(&m_AnimFrameCount, sizeof(int32_t), 1, fp);
     LOG_INFO("%d anim frames", m_AnimFrameCount);
-    g_AnimFrames =
-        GameBuf_Alloc(sizeof(int16_t) * m_AnimFrameCount, GBUF_ANIM_FRAMES);
-    File_Read(g_AnimFrames, sizeof(int16_t), m_AnimFrameCount, fp);
+    g_AnimFrames = Level_ReadArray(
+        fp, sizeof(int16_t), m_AnimFrameCount, sizeof(int16_t),
+        GBUF_ANIM_FRAMES);
     for (int i = 0; i < m_AnimCount; i++) {
         g_Anims[i].frame_ptr = &g_AnimFrames[(size_t)g_Anims[i].frame_ptr / 2];
     }
@@ -571,8 +634,8 @@ static bool Level_LoadSamples(MYFILE *fp)
         return false;
     }
 
-    char *sample_data = GameBuf_Alloc(sample_data_size, GBUF_SAMPLES);
-    File_Read(sample_data, sizeof(char), sample_data_size, fp);
+    const char *sample_data = Level_ReadArray(
+        fp, sizeof(char), sample_data_size, sizeof(char), GBUF_SAMPLES);
 
     int32_t num_samples;
     File_Read(&num_samples, sizeof(int32_t), 1, fp);
@@ -599,22 +662,47 @@ static bool Level_LoadSamples(MYFILE *fp)
         sample_sizes[i] = next_offset - current_offset;
     }
 
-    Sound_LoadSamples(num_samples, sample_pointers, sample_sizes);
-
     Memory_FreePointer(&sample_offsets);
-    Memory_FreePointer(&sample_pointers);
-    Memory_FreePointer(&sample_sizes);
+
+    m_SampleCount = num_samples;
+    m_SamplePointers = sample_pointers;
+    m_SampleSizes = sample_sizes;
 
     return true;
 }
 
+static void Level_DecodeSamples(void *arg)
+{
+    const char *filename = arg;
+    m_SamplesLoaded = false;
+
+    // the cache is keyed on the whole level file, so hashing it is left to
+    // the background thread as well
+    const size_t level_size = File_Size(m_LevelFile);
+    const void *level_data = File_MapRange(m_LevelFile, 0, level_size);
+    const bool use_cache = g_Config.enable_level_cache && level_data;
+    if (use_cache) {
+        LevelCache_Init(filename, level_data, level_size);
+        if (LevelCache_LoadSamples(m_SampleCount)) {
+            m_SamplesLoaded = true;
+            return;
+        }
+    }
+
+    m_SamplesLoaded =
+        Sound_LoadSamples(m_SampleCount, m_SamplePointers, m_SampleSizes);
+    if (m_SamplesLoaded && use_cache) {
+        LevelCache_StoreSamples(m_SampleCount);
+    }
+}
+
 static bool Level_LoadTexturePages(MYFILE *fp)
 {
     File_Read(&m_TexturePageCount, sizeof(int32_t), 1, fp);
     LOG_INFO("%d texture pages", m_TexturePageCount);
-    uint8_t *base =
-        GameBuf_Alloc(m_TexturePageCount * 256 * 256, GBUF_TEXTURE_PAGES);
-    File_Read(base, 256 * 256, m_TexturePageCount, fp);
+    uint8_t *base = Level_ReadArray(
+        fp, 256 * 256, m_TexturePageCount, sizeof(uint8_t),
+        GBUF_TEXTURE_PAGES);
     for (int i = 0; i < m_TexturePageCount; i++) {
         g_TexturePagePtrs[i] = base;
         base += 256 * 256;
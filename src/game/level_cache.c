@@ -0,0 +1,298 @@
+#include "game/level_cache.h"
+
+#include "filesystem.h"
+#include "game/sound.h"
+#include "global/vars.h"
+#include "log.h"
+#include "memory.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define LEVEL_CACHE_DIR "cache"
+#define LEVEL_CACHE_EXTENSION ".bin"
+#define LEVEL_CACHE_MAGIC 0x434D3154 // T1MC
+#define LEVEL_CACHE_FORMAT 1
+#define LEVEL_CACHE_ALIGNMENT 16
+#define LEVEL_CACHE_HASH_SEED 0xCBF29CE484222325ULL
+#define LEVEL_CACHE_HASH_PRIME 0x9E3779B97F4A7C15ULL
+
+typedef enum LEVEL_CACHE_SECTION_TYPE {
+    LEVEL_CACHE_SECTION_SAMPLES = 1,
+} LEVEL_CACHE_SECTION_TYPE;
+
+typedef struct LEVEL_CACHE_HEADER {
+    uint32_t magic;
+    uint32_t format;
+    uint64_t key;
+    uint32_t section_count;
+    uint32_t reserved;
+} LEVEL_CACHE_HEADER;
+
+typedef struct LEVEL_CACHE_SECTION {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+} LEVEL_CACHE_SECTION;
+
+typedef struct LEVEL_CACHE_SAMPLES {
+    uint32_t count;
+    uint32_t reserved[3];
+} LEVEL_CACHE_SAMPLES;
+
+typedef struct LEVEL_CACHE_SAMPLE {
+    int32_t channels;
+    int32_t num_samples;
+    uint64_t offset;
+} LEVEL_CACHE_SAMPLE;
+
+static char *m_Path = NULL;
+static uint64_t m_Key = 0;
+
+static uint64_t LevelCache_Hash(uint64_t hash, const void *data, size_t size);
+static size_t LevelCache_Align(size_t size);
+static void LevelCache_WritePadding(MYFILE *fp);
+static const void *LevelCache_FindSection(
+    MYFILE *fp, LEVEL_CACHE_SECTION_TYPE type, size_t *out_size);
+
+static uint64_t LevelCache_Hash(uint64_t hash, const void *data, size_t size)
+{
+    const uint8_t *ptr = data;
+    while (size >= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, ptr, sizeof(word));
+        hash = (hash ^ word) * LEVEL_CACHE_HASH_PRIME;
+        hash ^= hash >> 32;
+        ptr += sizeof(uint64_t);
+        size -= sizeof(uint64_t);
+    }
+    while (size--) {
+        hash = (hash ^ *ptr++) * LEVEL_CACHE_HASH_PRIME;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+static size_t LevelCache_Align(size_t size)
+{
+    return (size + LEVEL_CACHE_ALIGNMENT - 1)
+        & ~(size_t)(LEVEL_CACHE_ALIGNMENT - 1);
+}
+
+static void LevelCache_WritePadding(MYFILE *fp)
+{
+    static const char zero[LEVEL_CACHE_ALIGNMENT] = { 0 };
+    const size_t pos = File_Pos(fp);
+    const size_t padding = LevelCache_Align(pos) - pos;
+    if (padding) {
+        File_Write(zero, sizeof(char), padding, fp);
+    }
+}
+
+static const void *LevelCache_FindSection(
+    MYFILE *fp, LEVEL_CACHE_SECTION_TYPE type, size_t *out_size)
+{
+    LEVEL_CACHE_HEADER header;
+    if (File_Read(&header, sizeof(LEVEL_CACHE_HEADER), 1, fp) != 1
+        || header.magic != LEVEL_CACHE_MAGIC
+        || header.format != LEVEL_CACHE_FORMAT || header.key != m_Key) {
+        return NULL;
+    }
+
+    for (uint32_t i = 0; i < header.section_count; i++) {
+        LEVEL_CACHE_SECTION section;
+        if (File_Read(&section, sizeof(LEVEL_CACHE_SECTION), 1, fp) != 1) {
+            return NULL;
+        }
+        if (section.type == type) {
+            *out_size = section.size;
+            return File_MapRange(fp, section.offset, section.size);
+        }
+    }
+    return NULL;
+}
+
+void LevelCache_Init(
+    const char *level_path, const void *level_data, size_t level_size)
+{
+    LevelCache_Shutdown();
+
+    // the key covers the game version as well, since the way the data is
+    // prepared can change between versions
+    m_Key = LevelCache_Hash(
+        LEVEL_CACHE_HASH_SEED, g_T1MVersion, strlen(g_T1MVersion));
+    m_Key = LevelCache_Hash(m_Key, level_data, level_size);
+
+    const char *name = level_path;
+    for (const char *ptr = level_path; *ptr; ptr++) {
+        if (*ptr == '/' || *ptr == '\\') {
+            name = ptr + 1;
+        }
+    }
+
+    char *dir_path = NULL;
+    File_GetFullPath(LEVEL_CACHE_DIR, &dir_path);
+    m_Path = Memory_Alloc(
+        strlen(dir_path) + strlen(name) + strlen(LEVEL_CACHE_EXTENSION) + 2);
+    sprintf(m_Path, "%s/%s%s", dir_path, name, LEVEL_CACHE_EXTENSION);
+    Memory_FreePointer(&dir_path);
+}
+
+void LevelCache_Shutdown()
+{
+    Memory_FreePointer(&m_Path);
+    m_Key = 0;
+}
+
+bool LevelCache_LoadSamples(int32_t sample_count)
+{
+    if (!m_Path || !File_Exists(m_Path)) {
+        return false;
+    }
+
+    MYFILE *fp = File_Open(m_Path, FILE_OPEN_READ_MAPPED);
+    if (!fp) {
+        return false;
+    }
+
+    bool result = false;
+    const float **data = NULL;
+    int32_t *channels = NULL;
+    int32_t *num_samples = NULL;
+
+    size_t size = 0;
+    const char *section =
+        LevelCache_FindSection(fp, LEVEL_CACHE_SECTION_SAMPLES, &size);
+    if (!section) {
+        LOG_INFO("%s is out of date", m_Path);
+        goto cleanup;
+    }
+
+    const LEVEL_CACHE_SAMPLES *samples = (const LEVEL_CACHE_SAMPLES *)section;
+    const LEVEL_CACHE_SAMPLE *entries =
+        (const LEVEL_CACHE_SAMPLE *)(section + sizeof(LEVEL_CACHE_SAMPLES));
+    if (samples->count != (uint32_t)sample_count
+        || sizeof(LEVEL_CACHE_SAMPLES)
+                + sizeof(LEVEL_CACHE_SAMPLE) * samples->count
+            > size) {
+        goto cleanup;
+    }
+
+    data = Memory_Alloc(sizeof(float *) * sample_count);
+    channels = Memory_Alloc(sizeof(int32_t) * sample_count);
+    num_samples = Memory_Alloc(sizeof(int32_t) * sample_count);
+    for (int i = 0; i < sample_count; i++) {
+        const LEVEL_CACHE_SAMPLE *entry = &entries[i];
+        const uint64_t data_size =
+            (uint64_t)entry->num_samples * entry->channels * sizeof(float);
+        if (entry->channels <= 0 || entry->num_samples < 0
+            || entry->offset > size || data_size > size - entry->offset) {
+            goto cleanup;
+        }
+        data[i] = (const float *)(section + entry->offset);
+        channels[i] = entry->channels;
+        num_samples[i] = entry->num_samples;
+    }
+
+    result = Sound_LoadSampleData(sample_count, data, channels, num_samples);
+    if (result) {
+        LOG_INFO("loaded %d samples from %s", sample_count, m_Path);
+    }
+
+cleanup:
+    Memory_FreePointer(&data);
+    Memory_FreePointer(&channels);
+    Memory_FreePointer(&num_samples);
+    File_Close(fp);
+    return result;
+}
+
+bool LevelCache_StoreSamples(int32_t sample_count)
+{
+    if (!m_Path) {
+        return false;
+    }
+
+    const float **data = Memory_Alloc(sizeof(float *) * sample_count);
+    LEVEL_CACHE_SAMPLE *entries =
+        Memory_Alloc(sizeof(LEVEL_CACHE_SAMPLE) * sample_count);
+
+    bool result = false;
+    MYFILE *fp = NULL;
+
+    size_t offset = LevelCache_Align(
+        sizeof(LEVEL_CACHE_SAMPLES)
+        + sizeof(LEVEL_CACHE_SAMPLE) * sample_count);
+    for (int i = 0; i < sample_count; i++) {
+        LEVEL_CACHE_SAMPLE *entry = &entries[i];
+        if (!Sound_GetSampleData(
+                i, &data[i], &entry->channels, &entry->num_samples)) {
+            goto cleanup;
+        }
+        entry->offset = offset;
+        offset += LevelCache_Align(
+            entry->num_samples * entry->channels * sizeof(float));
+    }
+
+    char *dir_path = NULL;
+    File_GetFullPath(LEVEL_CACHE_DIR, &dir_path);
+    File_CreateDirectory(dir_path);
+    Memory_FreePointer(&dir_path);
+
+    fp = File_Open(m_Path, FILE_OPEN_WRITE);
+    if (!fp) {
+        LOG_ERROR("Can't open file %s", m_Path);
+        goto cleanup;
+    }
+
+    // the header goes in without the key at first and is only completed once
+    // everything else is written, so that an interrupted write never leaves
+    // behind a file that looks valid
+    LEVEL_CACHE_HEADER header = {
+        .magic = LEVEL_CACHE_MAGIC,
+        .format = LEVEL_CACHE_FORMAT,
+        .key = 0,
+        .section_count = 1,
+    };
+    LEVEL_CACHE_SECTION section = {
+        .type = LEVEL_CACHE_SECTION_SAMPLES,
+        .offset = LevelCache_Align(
+            sizeof(LEVEL_CACHE_HEADER) + sizeof(LEVEL_CACHE_SECTION)),
+        .size = offset,
+    };
+    File_Write(&header, sizeof(LEVEL_CACHE_HEADER), 1, fp);
+    File_Write(&section, sizeof(LEVEL_CACHE_SECTION), 1, fp);
+    LevelCache_WritePadding(fp);
+
+    const LEVEL_CACHE_SAMPLES samples = { .count = sample_count };
+    File_Write(&samples, sizeof(LEVEL_CACHE_SAMPLES), 1, fp);
+    File_Write(entries, sizeof(LEVEL_CACHE_SAMPLE), sample_count, fp);
+    LevelCache_WritePadding(fp);
+    for (int i = 0; i < sample_count; i++) {
+        File_Write(
+            data[i], sizeof(float),
+            entries[i].num_samples * entries[i].channels, fp);
+        LevelCache_WritePadding(fp);
+    }
+
+    result = File_Pos(fp) == section.offset + section.size;
+    if (result) {
+        header.key = m_Key;
+        File_Seek(fp, 0, FILE_SEEK_SET);
+        result = File_Write(&header, sizeof(LEVEL_CACHE_HEADER), 1, fp) == 1;
+    }
+    if (result) {
+        LOG_INFO("stored %d samples in %s", sample_count, m_Path);
+    } else {
+        LOG_ERROR("Can't write file %s", m_Path);
+    }
+
+cleanup:
+    if (fp) {
+        File_Close(fp);
+    }
+    Memory_FreePointer(&data);
+    Memory_FreePointer(&entries);
+    return result;
+}
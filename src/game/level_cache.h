@@ -0,0 +1,21 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Baked copies of the level data that is slow to prepare, such as the decoded
+// sound samples. There is one cache file per level in the cache directory,
+// and it is only used if both the level file and the game version match the
+// ones it was made from.
+
+// Works out the cache file and its key for the given level file contents.
+void LevelCache_Init(
+    const char *level_path, const void *level_data, size_t level_size);
+void LevelCache_Shutdown();
+
+// Loads the decoded samples from the cache. This runs on the level sample
+// job, so the old samples must already have been cleared on the main thread
+// with Sound_PrepareSamples; a failure only returns false.
+bool LevelCache_LoadSamples(int32_t sample_count);
+bool LevelCache_StoreSamples(int32_t sample_count);
@@ -1,28 +1,86 @@
 #include "game/lot.h"
 
+#include "config.h"
 #include "game/gamebuf.h"
-#include "game/shell.h"
 #include "global/const.h"
 #include "global/vars.h"
+#include "util.h"
 
 #include <stddef.h>
 
+static int32_t m_SlotCount = 0;
 static int32_t m_SlotsUsed = 0;
 static CREATURE_INFO *m_BaddieSlots = NULL;
 
+// the free slots are kept on a stack with the lowest slot on top, so that
+// they get used in the same order as in the original game; InitialiseSlot
+// takes the slot on top
+static int32_t *m_FreeSlots = NULL;
+
+static int32_t GetCameraDistance(const ITEM_INFO *item);
+static void ReleaseSlot(int32_t slot);
+
+static int32_t GetCameraDistance(const ITEM_INFO *item)
+{
+    int32_t x = (item->pos.x - g_Camera.pos.x) >> 8;
+    int32_t y = (item->pos.y - g_Camera.pos.y) >> 8;
+    int32_t z = (item->pos.z - g_Camera.pos.z) >> 8;
+    return SQUARE(x) + SQUARE(y) + SQUARE(z);
+}
+
+static void ReleaseSlot(int32_t slot)
+{
+    // slots are released rarely, so keeping the stack sorted is cheap
+    int32_t index = m_SlotCount - m_SlotsUsed;
+    m_SlotsUsed--;
+    while (index > 0 && m_FreeSlots[index - 1] < slot) {
+        m_FreeSlots[index] = m_FreeSlots[index - 1];
+        index--;
+    }
+    m_FreeSlots[index] = slot;
+}
+
 void InitialiseLOTArray()
 {
+    m_SlotCount = g_Config.creature_slots;
+    if (m_SlotCount <= 0) {
+        // enough for every creature in the level to be active at once
+        m_SlotCount = 0;
+        for (int i = 0; i < g_LevelItemCount; i++) {
+            if (g_Objects[g_Items[i].object_number].intelligent) {
+                m_SlotCount++;
+            }
+        }
+        m_SlotCount = MAX(m_SlotCount, NUM_SLOTS);
+    }
+
     m_BaddieSlots =
-        GameBuf_Alloc(NUM_SLOTS * sizeof(CREATURE_INFO), GBUF_CREATURE_INFO);
-    for (int i = 0; i < NUM_SLOTS; i++) {
-        CREATURE_INFO *creature = &m_BaddieSlots[i];
-        creature->item_num = NO_ITEM;
-        creature->LOT.node =
-            GameBuf_Alloc(sizeof(BOX_NODE) * g_NumberBoxes, GBUF_CREATURE_LOT);
+        GameBuf_Alloc(m_SlotCount * sizeof(CREATURE_INFO), GBUF_CREATURE_INFO);
+    m_FreeSlots =
+        GameBuf_Alloc(m_SlotCount * sizeof(int32_t), GBUF_CREATURE_INFO);
+
+    // the pathfinding nodes are only allocated once a slot gets used, since
+    // most levels never fill all of them
+    for (int i = 0; i < m_SlotCount; i++) {
+        m_BaddieSlots[i].LOT.node = NULL;
+    }
+    ResetLOTArray();
+}
+
+void ResetLOTArray()
+{
+    for (int i = 0; i < m_SlotCount; i++) {
+        m_BaddieSlots[i].item_num = NO_ITEM;
+        m_FreeSlots[i] = m_SlotCount - 1 - i;
     }
     m_SlotsUsed = 0;
 }
 
+int32_t GetBaddieSlotCount()
+{
+    return m_SlotCount;
+}
+
 void DisableBaddieAI(int16_t item_num)
 {
     ITEM_INFO *item = &g_Items[item_num];
@@ -30,7 +88,7 @@ void DisableBaddieAI(int16_t item_num)
     item->data = NULL;
     if (creature) {
         creature->item_num = NO_ITEM;
-        m_SlotsUsed--;
+        ReleaseSlot(creature - m_BaddieSlots);
     }
 }
 
@@ -40,34 +98,24 @@ int32_t EnableBaddieAI(int16_t item_num, int32_t always)
         return 1;
     }
 
-    if (m_SlotsUsed < NUM_SLOTS) {
-        for (int32_t slot = 0; slot < NUM_SLOTS; slot++) {
-            CREATURE_INFO *creature = &m_BaddieSlots[slot];
-            if (creature->item_num == NO_ITEM) {
-                InitialiseSlot(item_num, slot);
-                return 1;
-            }
-        }
-        Shell_ExitSystem("UnpauseBaddie() grimmer!");
+    if (m_SlotsUsed < m_SlotCount) {
+        InitialiseSlot(item_num, m_FreeSlots[m_SlotCount - m_SlotsUsed - 1]);
+        return 1;
     }
 
     int32_t worst_dist = 0;
     if (!always) {
-        ITEM_INFO *item = &g_Items[item_num];
-        int32_t x = (item->pos.x - g_Camera.pos.x) >> 8;
-        int32_t y = (item->pos.y - g_Camera.pos.y) >> 8;
-        int32_t z = (item->pos.z - g_Camera.pos.z) >> 8;
-        worst_dist = SQUARE(x) + SQUARE(y) + SQUARE(z);
+        worst_dist = GetCameraDistance(&g_Items[item_num]);
     }
 
+    // the number of slots is capped at MAX_CREATURE_SLOTS unless there is
+    // one for every creature, in which case the pool is never full, so
+    // looking at each of them is cheap; the distances change every frame,
+    // which a sorted structure would have to keep up with
     int32_t worst_slot = -1;
-    for (int32_t slot = 0; slot < NUM_SLOTS; slot++) {
-        CREATURE_INFO *creature = &m_BaddieSlots[slot];
-        ITEM_INFO *item = &g_Items[creature->item_num];
-        int32_t x = (item->pos.x - g_Camera.pos.x) >> 8;
-        int32_t y = (item->pos.y - g_Camera.pos.y) >> 8;
-        int32_t z = (item->pos.z - g_Camera.pos.z) >> 8;
-        int32_t dist = SQUARE(x) + SQUARE(y) + SQUARE(z);
+    for (int32_t slot = 0; slot < m_SlotCount; slot++) {
+        const int32_t dist =
+            GetCameraDistance(&g_Items[m_BaddieSlots[slot].item_num]);
         if (dist > worst_dist) {
             worst_dist = dist;
             worst_slot = slot;
@@ -88,6 +136,10 @@ void InitialiseSlot(int16_t item_num, int32_t slot)
 {
     CREATURE_INFO *creature = &m_BaddieSlots[slot];
     ITEM_INFO *item = &g_Items[item_num];
+    if (!creature->LOT.node) {
+        creature->LOT.node =
+            GameBuf_Alloc(sizeof(BOX_NODE) * g_NumberBoxes, GBUF_CREATURE_LOT);
+    }
     item->data = creature;
     creature->item_num = item_num;
     creature->mood = MOOD_BORED;
@@ -175,6 +227,7 @@ int32_t InitialiseLOT(LOT_INFO *LOT)
 {
     LOT->node =
         GameBuf_Alloc(sizeof(BOX_NODE) * g_NumberBoxes, GBUF_CREATURE_LOT);
+    LOT->cluster_mask = NULL;
     ClearLOT(LOT);
     return 1;
 }
@@ -186,6 +239,9 @@ void ClearLOT(LOT_INFO *LOT)
     LOT->tail = NO_BOX;
     LOT->target_box = NO_BOX;
     LOT->required_box = NO_BOX;
+    LOT->field = NULL;
+    LOT->field_id = 0;
+    LOT->cluster_search_number = 0;
 
     for (int i = 0; i < g_NumberBoxes; i++) {
         BOX_NODE *node = &LOT->node[i];
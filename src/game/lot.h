@@ -5,6 +5,8 @@
 #include <stdint.h>
 
 void InitialiseLOTArray();
+void ResetLOTArray();
+int32_t GetBaddieSlotCount();
 void DisableBaddieAI(int16_t item_num);
 int32_t EnableBaddieAI(int16_t item_num, int32_t always);
 void InitialiseSlot(int16_t item_num, int32_t slot);
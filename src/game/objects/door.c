@@ -1,5 +1,6 @@
 #include "game/objects/door.h"
 
+#include "game/box_field.h"
 #include "game/collide.h"
 #include "game/control.h"
 #include "game/draw.h"
@@ -55,6 +56,7 @@ static void ShutThatDoor(DOORPOS_DATA *d, ITEM_INFO *item)
     int16_t box_num = d->block;
     if (box_num != NO_BOX) {
         g_Boxes[box_num].overlap_index |= BLOCKED;
+        BoxField_Invalidate();
     }
 }
 
@@ -70,6 +72,7 @@ static void OpenThatDoor(DOORPOS_DATA *d)
     int16_t box_num = d->block;
     if (box_num != NO_BOX) {
         g_Boxes[box_num].overlap_index &= ~BLOCKED;
+        BoxField_Invalidate();
     }
 }
 
@@ -1,6 +1,7 @@
 #include "game/output.h"
 
 #include "3dsystem/3d_gen.h"
+#include "3dsystem/3d_transform.h"
 #include "3dsystem/matrix.h"
 #include "3dsystem/phd_math.h"
 #include "config.h"
@@ -8,10 +9,13 @@
 #include "game/random.h"
 #include "game/viewport.h"
 #include "global/vars.h"
+#include "memory.h"
 #include "specific/s_misc.h"
 #include "specific/s_output.h"
 #include "specific/s_shell.h"
 
+#include <string.h>
+
 PHD_VECTOR g_LsVectorView = { 0 };
 
 static PHD_VBUF m_VBuf[1500] = { 0 };
@@ -19,6 +23,25 @@ static int32_t m_DrawDistFade = 0;
 static int32_t m_DrawDistMax = 0;
 static RGBF m_WaterColor = { 0 };
 
+// When the static room geometry lives on the GPU, only the faces with
+// animated textures and the room sprites are left for the CPU. Each entry
+// remembers the room mesh it was built from, as flipmaps swap the rooms
+// around, and points to the leftover geometry stored in the same format as
+// the room mesh itself, except that it lists the vertex indices to transform
+// instead of the vertices. The GPU draws the static faces without the
+// per-face rejection of the CPU path, clipped to the portal window instead;
+// the bounds of the room vertices are kept to skip the rooms that are
+// entirely out of view.
+typedef struct ROOM_CACHE_ENTRY {
+    const int16_t *data;
+    const int16_t *dynamic_data;
+    int16_t min[3];
+    int16_t max[3];
+} ROOM_CACHE_ENTRY;
+
+static ROOM_CACHE_ENTRY *m_RoomCache = NULL;
+static int16_t *m_RoomCacheData = NULL;
+
 static const int16_t *Output_DrawObjectG3(
     const int16_t *obj_ptr, int32_t number);
 static const int16_t *Output_DrawObjectG4(
@@ -31,7 +54,13 @@ static const int16_t *Output_DrawRoomSprites(
     const int16_t *obj_ptr, int32_t vertex_count);
 static const int16_t *Output_CalcObjectVertices(const int16_t *obj_ptr);
 static const int16_t *Output_CalcVerticeLight(const int16_t *obj_ptr);
+static void Output_CalcRoomVertex(
+    PHD_VBUF *vbuf, const int16_t *obj_ptr, int32_t rand_num);
+static void Output_ShadeRoomVertex(
+    PHD_VBUF *vbuf, int16_t shade, int32_t rand_num);
 static const int16_t *Output_CalcRoomVertices(const int16_t *obj_ptr);
+static int32_t Output_FindRoomCacheEntry(int16_t room_num);
+static bool Output_IsRoomCacheEntryVisible(const ROOM_CACHE_ENTRY *entry);
 static int32_t Output_CalcFogShade(int32_t depth);
 static void Output_CalcWibbleTable();
 
@@ -161,55 +190,11 @@ static const int16_t *Output_DrawRoomSprites(
 
 static const int16_t *Output_CalcObjectVertices(const int16_t *obj_ptr)
 {
-    int16_t total_clip = -1;
-
     obj_ptr++;
     int vertex_count = *obj_ptr++;
-    for (int i = 0; i < vertex_count; i++) {
-        double xv = g_PhdMatrixPtr->_00 * obj_ptr[0]
-            + g_PhdMatrixPtr->_01 * obj_ptr[1]
-            + g_PhdMatrixPtr->_02 * obj_ptr[2] + g_PhdMatrixPtr->_03;
-        double yv = g_PhdMatrixPtr->_10 * obj_ptr[0]
-            + g_PhdMatrixPtr->_11 * obj_ptr[1]
-            + g_PhdMatrixPtr->_12 * obj_ptr[2] + g_PhdMatrixPtr->_13;
-        int32_t zv_int = g_PhdMatrixPtr->_20 * obj_ptr[0]
-            + g_PhdMatrixPtr->_21 * obj_ptr[1]
-            + g_PhdMatrixPtr->_22 * obj_ptr[2] + g_PhdMatrixPtr->_23;
-        double zv = zv_int;
-        m_VBuf[i].xv = xv;
-        m_VBuf[i].yv = yv;
-        m_VBuf[i].zv = zv;
-
-        int32_t clip_flags;
-        if (zv < Output_GetNearZ()) {
-            clip_flags = -32768;
-        } else {
-            clip_flags = 0;
-
-            double persp = g_PhdPersp / zv;
-            double xs = ViewPort_GetCenterX() + xv * persp;
-            double ys = ViewPort_GetCenterY() + yv * persp;
-
-            if (xs < g_PhdLeft) {
-                clip_flags |= 1;
-            } else if (xs > g_PhdRight) {
-                clip_flags |= 2;
-            }
-
-            if (ys < g_PhdTop) {
-                clip_flags |= 4;
-            } else if (ys > g_PhdBottom) {
-                clip_flags |= 8;
-            }
-
-            m_VBuf[i].xs = xs;
-            m_VBuf[i].ys = ys;
-        }
-
-        m_VBuf[i].clip = clip_flags;
-        total_clip &= clip_flags;
-        obj_ptr += 3;
-    }
+    int16_t total_clip =
+        phd_TransformVertices(obj_ptr, 3, vertex_count, m_VBuf);
+    obj_ptr += 3 * vertex_count;
 
     return total_clip == 0 ? obj_ptr : NULL;
 }
@@ -258,77 +243,214 @@ static const int16_t *Output_CalcVerticeLight(const int16_t *obj_ptr)
     return obj_ptr;
 }
 
+static void Output_CalcRoomVertex(
+    PHD_VBUF *vbuf, const int16_t *obj_ptr, int32_t rand_num)
+{
+    double xv = g_PhdMatrixPtr->_00 * obj_ptr[0]
+        + g_PhdMatrixPtr->_01 * obj_ptr[1] + g_PhdMatrixPtr->_02 * obj_ptr[2]
+        + g_PhdMatrixPtr->_03;
+    double yv = g_PhdMatrixPtr->_10 * obj_ptr[0]
+        + g_PhdMatrixPtr->_11 * obj_ptr[1] + g_PhdMatrixPtr->_12 * obj_ptr[2]
+        + g_PhdMatrixPtr->_13;
+    int32_t zv_int = g_PhdMatrixPtr->_20 * obj_ptr[0]
+        + g_PhdMatrixPtr->_21 * obj_ptr[1] + g_PhdMatrixPtr->_22 * obj_ptr[2]
+        + g_PhdMatrixPtr->_23;
+    double zv = zv_int;
+    vbuf->xv = xv;
+    vbuf->yv = yv;
+    vbuf->zv = zv;
+    vbuf->g = obj_ptr[3];
+
+    if (zv < Output_GetNearZ()) {
+        vbuf->clip = 0x8000;
+    } else {
+        int16_t clip_flags = 0;
+        int32_t depth = zv_int >> W2V_SHIFT;
+        if (depth > Output_GetDrawDistMax()) {
+            vbuf->g = 0x1FFF;
+            clip_flags |= 16;
+        } else if (depth) {
+            vbuf->g += Output_CalcFogShade(depth);
+            if (!g_IsWaterEffect) {
+                CLAMPG(vbuf->g, 0x1FFF);
+            }
+        }
+
+        double persp = g_PhdPersp / zv;
+        double xs = ViewPort_GetCenterX() + xv * persp;
+        double ys = ViewPort_GetCenterY() + yv * persp;
+        if (g_IsWibbleEffect) {
+            xs += g_WibbleTable[(g_WibbleOffset + (int)ys) & 0x1F];
+            ys += g_WibbleTable[(g_WibbleOffset + (int)xs) & 0x1F];
+        }
+
+        if (xs < g_PhdLeft) {
+            clip_flags |= 1;
+        } else if (xs > g_PhdRight) {
+            clip_flags |= 2;
+        }
+
+        if (ys < g_PhdTop) {
+            clip_flags |= 4;
+        } else if (ys > g_PhdBottom) {
+            clip_flags |= 8;
+        }
+
+        if (g_IsWaterEffect) {
+            vbuf->g += g_ShadeTable[(
+                ((uint8_t)g_WibbleOffset
+                 + (uint8_t)g_RandTable[rand_num % WIBBLE_SIZE])
+                % WIBBLE_SIZE)];
+            CLAMP(vbuf->g, 0, 0x1FFF);
+        }
+
+        vbuf->xs = xs;
+        vbuf->ys = ys;
+        vbuf->clip = clip_flags;
+    }
+}
+
+static void Output_ShadeRoomVertex(
+    PHD_VBUF *vbuf, int16_t shade, int32_t rand_num)
+{
+    vbuf->g = shade;
+
+    if (vbuf->clip < 0) {
+        vbuf->clip = 0x8000;
+        return;
+    }
+
+    int16_t clip_flags = 0;
+    int32_t depth = (int32_t)vbuf->zv >> W2V_SHIFT;
+    if (depth > Output_GetDrawDistMax()) {
+        vbuf->g = 0x1FFF;
+        clip_flags |= 16;
+    } else if (depth) {
+        vbuf->g += Output_CalcFogShade(depth);
+        if (!g_IsWaterEffect) {
+            CLAMPG(vbuf->g, 0x1FFF);
+        }
+    }
+
+    if (g_IsWibbleEffect) {
+        double xs = vbuf->xs;
+        double ys = vbuf->ys;
+        xs += g_WibbleTable[(g_WibbleOffset + (int)ys) & 0x1F];
+        ys += g_WibbleTable[(g_WibbleOffset + (int)xs) & 0x1F];
+
+        if (xs < g_PhdLeft) {
+            clip_flags |= 1;
+        } else if (xs > g_PhdRight) {
+            clip_flags |= 2;
+        }
+
+        if (ys < g_PhdTop) {
+            clip_flags |= 4;
+        } else if (ys > g_PhdBottom) {
+            clip_flags |= 8;
+        }
+
+        vbuf->xs = xs;
+        vbuf->ys = ys;
+    } else {
+        clip_flags |= vbuf->clip;
+    }
+
+    if (g_IsWaterEffect) {
+        vbuf->g += g_ShadeTable[(
+            ((uint8_t)g_WibbleOffset
+             + (uint8_t)g_RandTable[rand_num % WIBBLE_SIZE])
+            % WIBBLE_SIZE)];
+        CLAMP(vbuf->g, 0, 0x1FFF);
+    }
+
+    vbuf->clip = clip_flags;
+}
+
 static const int16_t *Output_CalcRoomVertices(const int16_t *obj_ptr)
 {
     int32_t vertex_count = *obj_ptr++;
 
+    if (!g_Config.rendering.enable_simd_transform) {
+        for (int i = 0; i < vertex_count; i++) {
+            Output_CalcRoomVertex(&m_VBuf[i], obj_ptr, vertex_count - i);
+            obj_ptr += 4;
+        }
+        return obj_ptr;
+    }
+
+    // transform the whole room at once, then apply the fog and the water
+    // effects that depend on the resulting depth and screen position
+    phd_TransformVertices(obj_ptr, 4, vertex_count, m_VBuf);
     for (int i = 0; i < vertex_count; i++) {
-        double xv = g_PhdMatrixPtr->_00 * obj_ptr[0]
-            + g_PhdMatrixPtr->_01 * obj_ptr[1]
-            + g_PhdMatrixPtr->_02 * obj_ptr[2] + g_PhdMatrixPtr->_03;
-        double yv = g_PhdMatrixPtr->_10 * obj_ptr[0]
-            + g_PhdMatrixPtr->_11 * obj_ptr[1]
-            + g_PhdMatrixPtr->_12 * obj_ptr[2] + g_PhdMatrixPtr->_13;
-        int32_t zv_int = g_PhdMatrixPtr->_20 * obj_ptr[0]
-            + g_PhdMatrixPtr->_21 * obj_ptr[1]
-            + g_PhdMatrixPtr->_22 * obj_ptr[2] + g_PhdMatrixPtr->_23;
-        double zv = zv_int;
-        m_VBuf[i].xv = xv;
-        m_VBuf[i].yv = yv;
-        m_VBuf[i].zv = zv;
-        m_VBuf[i].g = obj_ptr[3];
+        Output_ShadeRoomVertex(&m_VBuf[i], obj_ptr[3], vertex_count - i);
+        obj_ptr += 4;
+    }
+
+    return obj_ptr;
+}
+
+static int32_t Output_FindRoomCacheEntry(int16_t room_num)
+{
+    const int16_t *data = g_RoomInfo[room_num].data;
+    if (m_RoomCache[room_num].data == data) {
+        return room_num;
+    }
 
+    // the room was flipped
+    for (int i = 0; i < g_RoomCount; i++) {
+        if (m_RoomCache[i].data == data) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static bool Output_IsRoomCacheEntryVisible(const ROOM_CACHE_ENTRY *entry)
+{
+    // the same clip flags as Output_CalcRoomVertex, for the corners of the
+    // bounds; the room is out of view if they all share one
+    int32_t clip_and = -1;
+    for (int i = 0; i < 8; i++) {
+        const double x = i & 1 ? entry->max[0] : entry->min[0];
+        const double y = i & 2 ? entry->max[1] : entry->min[1];
+        const double z = i & 4 ? entry->max[2] : entry->min[2];
+        const double xv = g_PhdMatrixPtr->_00 * x + g_PhdMatrixPtr->_01 * y
+            + g_PhdMatrixPtr->_02 * z + g_PhdMatrixPtr->_03;
+        const double yv = g_PhdMatrixPtr->_10 * x + g_PhdMatrixPtr->_11 * y
+            + g_PhdMatrixPtr->_12 * z + g_PhdMatrixPtr->_13;
+        const double zv = g_PhdMatrixPtr->_20 * x + g_PhdMatrixPtr->_21 * y
+            + g_PhdMatrixPtr->_22 * z + g_PhdMatrixPtr->_23;
+
+        int32_t clip_flags = 0;
         if (zv < Output_GetNearZ()) {
-            m_VBuf[i].clip = 0x8000;
+            clip_flags = 0x8000;
         } else {
-            int16_t clip_flags = 0;
-            int32_t depth = zv_int >> W2V_SHIFT;
-            if (depth > Output_GetDrawDistMax()) {
-                m_VBuf[i].g = 0x1FFF;
+            if (zv / W2V_SCALE > Output_GetDrawDistMax()) {
                 clip_flags |= 16;
-            } else if (depth) {
-                m_VBuf[i].g += Output_CalcFogShade(depth);
-                if (!g_IsWaterEffect) {
-                    CLAMPG(m_VBuf[i].g, 0x1FFF);
-                }
-            }
-
-            double persp = g_PhdPersp / zv;
-            double xs = ViewPort_GetCenterX() + xv * persp;
-            double ys = ViewPort_GetCenterY() + yv * persp;
-            if (g_IsWibbleEffect) {
-                xs += g_WibbleTable[(g_WibbleOffset + (int)ys) & 0x1F];
-                ys += g_WibbleTable[(g_WibbleOffset + (int)xs) & 0x1F];
             }
 
+            const double persp = g_PhdPersp / zv;
+            const double xs = ViewPort_GetCenterX() + xv * persp;
+            const double ys = ViewPort_GetCenterY() + yv * persp;
             if (xs < g_PhdLeft) {
                 clip_flags |= 1;
             } else if (xs > g_PhdRight) {
                 clip_flags |= 2;
             }
-
             if (ys < g_PhdTop) {
                 clip_flags |= 4;
             } else if (ys > g_PhdBottom) {
                 clip_flags |= 8;
             }
+        }
 
-            if (g_IsWaterEffect) {
-                m_VBuf[i].g += g_ShadeTable[(
-                    ((uint8_t)g_WibbleOffset
-                     + (uint8_t)g_RandTable[(vertex_count - i) % WIBBLE_SIZE])
-                    % WIBBLE_SIZE)];
-                CLAMP(m_VBuf[i].g, 0, 0x1FFF);
-            }
-
-            m_VBuf[i].xs = xs;
-            m_VBuf[i].ys = ys;
-            m_VBuf[i].clip = clip_flags;
+        clip_and &= clip_flags;
+        if (!clip_and) {
+            return true;
         }
-        obj_ptr += 4;
     }
-
-    return obj_ptr;
+    return false;
 }
 
 static int32_t Output_CalcFogShade(int32_t depth)
@@ -479,6 +601,7 @@ void Output_CalculateStaticLight(int16_t adder)
 
 void Output_DrawPolygons(const int16_t *obj_ptr, int clip)
 {
+    S_Output_BeginDrawList();
     obj_ptr += 4;
     obj_ptr = Output_CalcObjectVertices(obj_ptr);
     if (obj_ptr) {
@@ -498,12 +621,160 @@ void Output_DrawPolygons_I(const int16_t *obj_ptr, int32_t clip)
     phd_PopMatrix();
 }
 
-void Output_DrawRoom(const int16_t *obj_ptr)
+void Output_DrawRoom(int16_t room_num)
+{
+    S_Output_BeginDrawList();
+    const int16_t *obj_ptr = g_RoomInfo[room_num].data;
+
+    int32_t entry_num = m_RoomCache ? Output_FindRoomCacheEntry(room_num) : -1;
+    if (entry_num < 0) {
+        obj_ptr = Output_CalcRoomVertices(obj_ptr);
+        obj_ptr = Output_DrawObjectGT4(obj_ptr + 1, *obj_ptr);
+        obj_ptr = Output_DrawObjectGT3(obj_ptr + 1, *obj_ptr);
+        obj_ptr = Output_DrawRoomSprites(obj_ptr + 1, *obj_ptr);
+        return;
+    }
+
+    if (Output_IsRoomCacheEntryVisible(&m_RoomCache[entry_num])) {
+        S_Output_DrawRoom(entry_num);
+    }
+
+    const int16_t *vertices = obj_ptr + 1;
+    const int32_t vertex_count = *obj_ptr;
+    const int16_t *dynamic_ptr = m_RoomCache[entry_num].dynamic_data;
+    const int32_t needed_count = *dynamic_ptr++;
+    for (int i = 0; i < needed_count; i++) {
+        const int16_t vertex_num = *dynamic_ptr++;
+        Output_CalcRoomVertex(
+            &m_VBuf[vertex_num], &vertices[vertex_num * 4],
+            vertex_count - vertex_num);
+    }
+    dynamic_ptr = Output_DrawObjectGT4(dynamic_ptr + 1, *dynamic_ptr);
+    dynamic_ptr = Output_DrawObjectGT3(dynamic_ptr + 1, *dynamic_ptr);
+
+    obj_ptr += 1 + vertex_count * 4;
+    obj_ptr += 1 + *obj_ptr * 5;
+    obj_ptr += 1 + *obj_ptr * 4;
+    Output_DrawRoomSprites(obj_ptr + 1, *obj_ptr);
+}
+
+void Output_CacheRooms()
+{
+    Memory_FreePointer(&m_RoomCache);
+    Memory_FreePointer(&m_RoomCacheData);
+
+    if (!g_Config.rendering.enable_room_cache || !S_Output_CacheRooms()) {
+        return;
+    }
+
+    // the leftover geometry can never be larger than the room meshes
+    size_t data_size = 0;
+    for (int i = 0; i < g_RoomCount; i++) {
+        const int16_t *obj_ptr = g_RoomInfo[i].data;
+        const int32_t vertex_count = *obj_ptr;
+        obj_ptr += 1 + vertex_count * 4;
+        const int32_t quad_count = *obj_ptr;
+        obj_ptr += 1 + quad_count * 5;
+        const int32_t tri_count = *obj_ptr;
+        data_size += 3 + vertex_count + quad_count * 5 + tri_count * 4;
+    }
+
+    m_RoomCache = Memory_Alloc(sizeof(ROOM_CACHE_ENTRY) * g_RoomCount);
+    m_RoomCacheData = Memory_Alloc(sizeof(int16_t) * data_size);
+
+    bool is_needed[sizeof(m_VBuf) / sizeof(m_VBuf[0])];
+    int16_t *data_ptr = m_RoomCacheData;
+    for (int i = 0; i < g_RoomCount; i++) {
+        const int16_t *obj_ptr = g_RoomInfo[i].data;
+        m_RoomCache[i].data = obj_ptr;
+        m_RoomCache[i].dynamic_data = data_ptr;
+
+        const int32_t vertex_count = *obj_ptr++;
+        for (int k = 0; k < 3; k++) {
+            m_RoomCache[i].min[k] = vertex_count ? obj_ptr[k] : 0;
+            m_RoomCache[i].max[k] = vertex_count ? obj_ptr[k] : 0;
+        }
+        for (int j = 0; j < vertex_count; j++) {
+            is_needed[j] = false;
+            for (int k = 0; k < 3; k++) {
+                m_RoomCache[i].min[k] = MIN(m_RoomCache[i].min[k], obj_ptr[k]);
+                m_RoomCache[i].max[k] = MAX(m_RoomCache[i].max[k], obj_ptr[k]);
+            }
+            obj_ptr += 4;
+        }
+
+        int16_t *faces_ptr = data_ptr + 1 + vertex_count;
+        int16_t *count_ptr = faces_ptr++;
+        *count_ptr = 0;
+        int32_t quad_count = *obj_ptr++;
+        for (int j = 0; j < quad_count; j++) {
+            if (Output_IsAnimatedTexture(obj_ptr[4])) {
+                for (int k = 0; k < 5; k++) {
+                    *faces_ptr++ = obj_ptr[k];
+                }
+                for (int k = 0; k < 4; k++) {
+                    is_needed[obj_ptr[k]] = true;
+                }
+                (*count_ptr)++;
+            }
+            obj_ptr += 5;
+        }
+
+        count_ptr = faces_ptr++;
+        *count_ptr = 0;
+        int32_t tri_count = *obj_ptr++;
+        for (int j = 0; j < tri_count; j++) {
+            if (Output_IsAnimatedTexture(obj_ptr[3])) {
+                for (int k = 0; k < 4; k++) {
+                    *faces_ptr++ = obj_ptr[k];
+                }
+                for (int k = 0; k < 3; k++) {
+                    is_needed[obj_ptr[k]] = true;
+                }
+                (*count_ptr)++;
+            }
+            obj_ptr += 4;
+        }
+
+        int32_t sprite_count = *obj_ptr++;
+        for (int j = 0; j < sprite_count; j++) {
+            is_needed[obj_ptr[0]] = true;
+            obj_ptr += 2;
+        }
+
+        // pack the vertex list and move the faces right after it
+        int16_t *vertex_ptr = data_ptr + 1;
+        for (int j = 0; j < vertex_count; j++) {
+            if (is_needed[j]) {
+                *vertex_ptr++ = j;
+            }
+        }
+        *data_ptr = vertex_ptr - (data_ptr + 1);
+        const size_t faces_size = faces_ptr - (data_ptr + 1 + vertex_count);
+        memmove(
+            vertex_ptr, data_ptr + 1 + vertex_count,
+            faces_size * sizeof(int16_t));
+        data_ptr = vertex_ptr + faces_size;
+    }
+}
+
+bool Output_IsAnimatedTexture(int16_t texture_num)
 {
-    obj_ptr = Output_CalcRoomVertices(obj_ptr);
-    obj_ptr = Output_DrawObjectGT4(obj_ptr + 1, *obj_ptr);
-    obj_ptr = Output_DrawObjectGT3(obj_ptr + 1, *obj_ptr);
-    obj_ptr = Output_DrawRoomSprites(obj_ptr + 1, *obj_ptr);
+    if (!g_AnimTextureRanges) {
+        return false;
+    }
+
+    const int16_t *ptr = g_AnimTextureRanges;
+    int16_t range_count = *ptr++;
+    for (int i = 0; i < range_count; i++) {
+        int16_t texture_count = *ptr++ + 1;
+        for (int j = 0; j < texture_count; j++) {
+            if (*ptr++ == texture_num) {
+                return true;
+            }
+        }
+    }
+    return false;
 }
 
 void Output_DrawShadow(int16_t size, int16_t *bptr, ITEM_INFO *item)
@@ -607,6 +878,7 @@ int32_t Output_GetFarZ()
 void Output_DrawSprite(
     int32_t x, int32_t y, int32_t z, int16_t sprnum, int16_t shade)
 {
+    S_Output_BeginDrawList();
     x -= g_W2VMatrix._03;
     y -= g_W2VMatrix._13;
     z -= g_W2VMatrix._23;
@@ -730,6 +1002,7 @@ void Output_DrawScreenSprite2D(
 void Output_DrawSpriteRel(
     int32_t x, int32_t y, int32_t z, int16_t sprnum, int16_t shade)
 {
+    S_Output_BeginDrawList();
     int32_t zv = g_PhdMatrixPtr->_20 * x + g_PhdMatrixPtr->_21 * y
         + g_PhdMatrixPtr->_22 * z + g_PhdMatrixPtr->_23;
     if (zv < Output_GetNearZ() || zv > Output_GetFarZ()) {
@@ -859,3 +1132,8 @@ bool Output_MakeScreenshot(const char *path)
 {
     return S_Output_MakeScreenshot(path);
 }
+
+void Output_LogRenderStats()
+{
+    S_Output_LogRenderStats();
+}
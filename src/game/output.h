@@ -37,7 +37,9 @@ void Output_CalculateStaticLight(int16_t adder);
 void Output_DrawPolygons(const int16_t *obj_ptr, int clip);
 void Output_DrawPolygons_I(const int16_t *obj_ptr, int32_t clip);
 
-void Output_DrawRoom(const int16_t *obj_ptr);
+void Output_DrawRoom(int16_t room_num);
+void Output_CacheRooms();
+bool Output_IsAnimatedTexture(int16_t texture_num);
 void Output_DrawShadow(int16_t size, int16_t *bptr, ITEM_INFO *item);
 void Output_DrawLightningSegment(
     int32_t x1, int32_t y1, int32_t z1, int32_t x2, int32_t y2, int32_t z2,
@@ -77,3 +79,5 @@ void Output_FadeToBlack();
 void Output_ApplyWaterEffect(float *r, float *g, float *b);
 
 bool Output_MakeScreenshot(const char *path);
+
+void Output_LogRenderStats();
@@ -486,6 +486,7 @@ void Overlay_DrawFPSInfo()
                 m_FPSText = Text_Create(10, 30, fps_buf);
                 m_FPSText->on_remove = Overlay_OnFPSTextRemoval;
             }
+            Output_LogRenderStats();
             g_FPSCounter = 0;
             elapsed = Clock_GetMS();
         }
@@ -0,0 +1,216 @@
+#include "game/quicksave.h"
+
+#include "config.h"
+#include "game/ai/pierre.h"
+#include "game/box_field.h"
+#include "game/camera.h"
+#include "game/hair.h"
+#include "game/items.h"
+#include "game/lot.h"
+#include "game/savegame.h"
+#include "game/sound.h"
+#include "global/const.h"
+#include "global/vars.h"
+#include "log.h"
+#include "memory.h"
+#include "util.h"
+
+#include <string.h>
+
+typedef struct QUICKSAVE {
+    char *data;
+    int32_t size;
+} QUICKSAVE;
+
+// The parts of the level that change as the game goes on.
+typedef struct QUICKSAVE_LEVEL_STATE {
+    int32_t level_num;
+    int32_t item_count;
+    ITEM_INFO *items;
+    int16_t next_item_active;
+    int16_t room_count;
+    ROOM_INFO *rooms;
+    int32_t floor_count;
+    FLOOR_INFO *floors;
+    int32_t box_count;
+    int16_t *overlap_indices;
+    LARA_INFO lara;
+    int16_t pierre_item_num;
+    int32_t flip_status;
+    int32_t flip_effect;
+    int32_t flip_timer;
+    int32_t flip_map_table[MAX_FLIP_MAPS];
+} QUICKSAVE_LEVEL_STATE;
+
+static QUICKSAVE *m_QuickSaves = NULL;
+static int32_t m_SlotCount = 0;
+static int32_t m_UsedCount = 0;
+static int32_t m_Newest = 0;
+static int32_t m_Age = 0;
+static QUICKSAVE_LEVEL_STATE m_LevelState = { .level_num = -1 };
+
+static void QuickSave_Resize(int32_t slot_count);
+static void QuickSave_RestoreLevelState();
+
+static void QuickSave_Resize(int32_t slot_count)
+{
+    for (int i = 0; i < m_SlotCount; i++) {
+        Memory_FreePointer(&m_QuickSaves[i].data);
+    }
+    Memory_FreePointer(&m_QuickSaves);
+
+    m_SlotCount = slot_count;
+    m_UsedCount = 0;
+    m_Newest = 0;
+    m_Age = 0;
+    if (m_SlotCount) {
+        m_QuickSaves = Memory_Alloc(sizeof(QUICKSAVE) * m_SlotCount);
+    }
+}
+
+static void QuickSave_RestoreLevelState()
+{
+    QUICKSAVE_LEVEL_STATE *state = &m_LevelState;
+
+    Sound_StopAllSamples();
+    Sound_ResetEffects();
+
+    // the flipped rooms swap their whole ROOM_INFO, so the floors are put
+    // back through the restored rooms to end up in the right place
+    memcpy(g_RoomInfo, state->rooms, sizeof(ROOM_INFO) * state->room_count);
+    FLOOR_INFO *floor = state->floors;
+    for (int i = 0; i < state->room_count; i++) {
+        ROOM_INFO *r = &g_RoomInfo[i];
+        const int32_t count = r->x_size * r->y_size;
+        memcpy(r->floor, floor, sizeof(FLOOR_INFO) * count);
+        floor += count;
+    }
+
+    for (int i = 0; i < state->box_count; i++) {
+        g_Boxes[i].overlap_index = state->overlap_indices[i];
+    }
+    BoxField_Invalidate();
+
+    memcpy(g_Items, state->items, sizeof(ITEM_INFO) * state->item_count);
+    InitialiseItemArray(MAX_ITEMS);
+    g_NextItemActive = state->next_item_active;
+    InitialiseFXArray();
+    ResetLOTArray();
+
+    g_Lara = state->lara;
+    g_PierreItemNum = state->pierre_item_num;
+    g_FlipStatus = state->flip_status;
+    g_FlipEffect = state->flip_effect;
+    g_FlipTimer = state->flip_timer;
+    memcpy(g_FlipMapTable, state->flip_map_table, sizeof(g_FlipMapTable));
+}
+
+void QuickSave_StoreLevelState()
+{
+    const int32_t slot_count = MAX(g_Config.quick_save_slots, 0);
+    if (slot_count != m_SlotCount) {
+        QuickSave_Resize(slot_count);
+    }
+    if (!m_SlotCount) {
+        return;
+    }
+
+    QUICKSAVE_LEVEL_STATE *state = &m_LevelState;
+    if (state->level_num != g_CurrentLevel) {
+        m_UsedCount = 0;
+        m_Newest = 0;
+        m_Age = 0;
+    }
+    state->level_num = g_CurrentLevel;
+
+    state->item_count = g_LevelItemCount;
+    state->items =
+        Memory_Realloc(state->items, sizeof(ITEM_INFO) * g_LevelItemCount);
+    memcpy(state->items, g_Items, sizeof(ITEM_INFO) * g_LevelItemCount);
+    state->next_item_active = g_NextItemActive;
+
+    state->room_count = g_RoomCount;
+    state->rooms =
+        Memory_Realloc(state->rooms, sizeof(ROOM_INFO) * g_RoomCount);
+    memcpy(state->rooms, g_RoomInfo, sizeof(ROOM_INFO) * g_RoomCount);
+
+    state->floor_count = 0;
+    for (int i = 0; i < g_RoomCount; i++) {
+        state->floor_count += g_RoomInfo[i].x_size * g_RoomInfo[i].y_size;
+    }
+    state->floors = Memory_Realloc(
+        state->floors, sizeof(FLOOR_INFO) * MAX(state->floor_count, 1));
+    FLOOR_INFO *floor = state->floors;
+    for (int i = 0; i < g_RoomCount; i++) {
+        const ROOM_INFO *r = &g_RoomInfo[i];
+        const int32_t count = r->x_size * r->y_size;
+        memcpy(floor, r->floor, sizeof(FLOOR_INFO) * count);
+        floor += count;
+    }
+
+    state->box_count = g_NumberBoxes;
+    state->overlap_indices = Memory_Realloc(
+        state->overlap_indices, sizeof(int16_t) * MAX(g_NumberBoxes, 1));
+    for (int i = 0; i < g_NumberBoxes; i++) {
+        state->overlap_indices[i] = g_Boxes[i].overlap_index;
+    }
+
+    state->lara = g_Lara;
+    state->pierre_item_num = g_PierreItemNum;
+    state->flip_status = g_FlipStatus;
+    state->flip_effect = g_FlipEffect;
+    state->flip_timer = g_FlipTimer;
+    memcpy(state->flip_map_table, g_FlipMapTable, sizeof(g_FlipMapTable));
+}
+
+void QuickSave_Shutdown()
+{
+    QuickSave_Resize(0);
+    Memory_FreePointer(&m_LevelState.items);
+    Memory_FreePointer(&m_LevelState.rooms);
+    Memory_FreePointer(&m_LevelState.floors);
+    Memory_FreePointer(&m_LevelState.overlap_indices);
+    m_LevelState.level_num = -1;
+}
+
+bool QuickSave_Save()
+{
+    if (!m_SlotCount || m_LevelState.level_num != g_CurrentLevel) {
+        return false;
+    }
+
+    m_Newest = m_UsedCount ? (m_Newest + 1) % m_SlotCount : 0;
+    m_UsedCount = MIN(m_UsedCount + 1, m_SlotCount);
+    m_Age = 0;
+
+    SaveGame_FillSaveBuffer(&g_GameInfo);
+    QUICKSAVE *quick_save = &m_QuickSaves[m_Newest];
+    quick_save->size = g_GameInfo.savegame_buffer_size;
+    quick_save->data = Memory_Realloc(quick_save->data, quick_save->size);
+    memcpy(quick_save->data, g_GameInfo.savegame_buffer, quick_save->size);
+
+    LOG_INFO("quick save %d, %d bytes", m_Newest, quick_save->size);
+    return true;
+}
+
+bool QuickSave_Load(bool older)
+{
+    if (!m_UsedCount || m_LevelState.level_num != g_CurrentLevel) {
+        return false;
+    }
+
+    if (older && m_Age + 1 < m_UsedCount) {
+        m_Age++;
+    }
+    const int32_t slot = (m_Newest - m_Age + m_SlotCount) % m_SlotCount;
+    const QUICKSAVE *quick_save = &m_QuickSaves[slot];
+
+    QuickSave_RestoreLevelState();
+    SaveGame_SetSaveBuffer(&g_GameInfo, quick_save->data, quick_save->size);
+    SaveGame_ApplySaveBuffer(&g_GameInfo);
+    InitialiseCamera();
+    InitialiseHair();
+
+    LOG_INFO("quick load %d", slot);
+    return true;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <stdbool.h>
+
+// Quick saves are kept in memory only, in a ring of the most recent ones. They
+// are restored in place on top of the loaded level, which is first put back
+// in the state it had right after loading, so no files are read and the level
+// is not parsed again.
+
+// Remembers the state of the level right after it is loaded. Forgets the
+// quick saves made on another level.
+void QuickSave_StoreLevelState();
+void QuickSave_Shutdown();
+
+bool QuickSave_Save();
+// Restores the latest quick save, or the one before the last restored one if
+// older is set.
+bool QuickSave_Load(bool older);
@@ -1,5 +1,6 @@
 #include "game/savegame.h"
 
+#include "compress.h"
 #include "filesystem.h"
 #include "game/ai/pod.h"
 #include "game/control.h"
@@ -17,11 +18,15 @@
 #include "global/const.h"
 #include "global/vars.h"
 #include "log.h"
+#include "memory.h"
+#include "specific/s_job.h"
+#include "util.h"
 
 #include <string.h>
 #include <assert.h>
 #include <stdio.h>
 #include <stddef.h>
+#include <time.h>
 
 // Loading a saved game is divided into two phases. First, the game reads the
 // savegame file contents to look for the level number. The rest of the save
@@ -30,10 +35,52 @@
 // Second phase occurs after everything finishes loading, e.g. items,
 // creatures, triggers etc., and is what actually sets Lara's health, creatures
 // status, triggers, inventory etc.
+//
+// The saves are made of tagged chunks that are looked up by their type, so
+// new chunks and new fields at the end of existing chunks can be added
+// without breaking the older saves. Only the items that differ from their
+// state at the start of the level are stored. The saves made by OG TombATI
+// and the older versions of Tomb1Main are a raw dump of the same data, and
+// can still be loaded.
 
 #define SAVEGAME_TITLE_SIZE 75
+#define SAVEGAME_BUFFER_MIN_SIZE 4096
+#define SAVEGAME_FILE_MAGIC 0x534D3154 // T1MS
+#define SAVEGAME_FILE_VERSION 1
+#define SAVEGAME_CHUNK_VERSION 1
+#define SAVEGAME_INDEX_MAGIC 0x58444953 // SIDX
+#define SAVEGAME_INDEX_VERSION 2
 #define SAVE_CREATURE (1 << 7)
 
+typedef enum SAVEGAME_COMPRESSION {
+    SAVEGAME_COMPRESSION_NONE = 0,
+    SAVEGAME_COMPRESSION_LZSS = 1,
+} SAVEGAME_COMPRESSION;
+
+typedef enum SAVEGAME_CHUNK_TYPE {
+    SAVEGAME_CHUNK_INFO = 1,
+    SAVEGAME_CHUNK_GAME = 2,
+    SAVEGAME_CHUNK_FLIPMAPS = 3,
+    SAVEGAME_CHUNK_CAMERAS = 4,
+    SAVEGAME_CHUNK_ITEMS = 5,
+    SAVEGAME_CHUNK_LARA = 6,
+    SAVEGAME_CHUNK_LOT = 7,
+} SAVEGAME_CHUNK_TYPE;
+
+typedef struct SAVEGAME_FILE_HEADER {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t compression;
+    uint32_t size;
+    uint32_t compressed_size;
+} SAVEGAME_FILE_HEADER;
+
+typedef struct SAVEGAME_CHUNK_HEADER {
+    uint16_t type;
+    uint16_t version;
+    uint32_t size;
+} SAVEGAME_CHUNK_HEADER;
+
 typedef struct SAVEGAME_ITEM_STATS {
     uint8_t num_pickup1;
     uint8_t num_pickup2;
@@ -49,25 +96,106 @@ typedef struct SAVEGAME_ITEM_STATS {
     uint8_t dummy;
 } SAVEGAME_ITEM_STATS;
 
-static int m_SGBufPos = 0;
-static char *m_SGBufPtr = NULL;
+// The index holds what the load/save requester needs to know about every
+// slot, so that the slots can be listed without opening each save file.
+typedef struct SAVEGAME_INDEX_ENTRY {
+    int32_t is_used;
+    int32_t counter;
+    int32_t level_num;
+    int32_t reserved;
+    int64_t timestamp;
+    // the save file as it was when the entry was made, to tell when it was
+    // changed outside the game
+    int64_t file_size;
+    int64_t file_mtime;
+    char title[SAVEGAME_TITLE_SIZE + 1];
+} SAVEGAME_INDEX_ENTRY;
+
+typedef struct SAVEGAME_INDEX {
+    uint32_t magic;
+    uint32_t version;
+    int32_t slot_count;
+    int32_t reserved;
+    SAVEGAME_INDEX_ENTRY entries[MAX_SAVE_SLOTS];
+} SAVEGAME_INDEX;
+
+typedef struct SAVEGAME_WRITE {
+    char *path;
+    char *data;
+    size_t size;
+    int32_t slot;
+    SAVEGAME_INDEX index;
+    bool result;
+    bool index_result;
+} SAVEGAME_WRITE;
+
+typedef struct SAVEGAME_STREAM {
+    char *data;
+    int32_t size;
+    int32_t capacity;
+    int32_t pos;
+} SAVEGAME_STREAM;
+
+// The records of every item as it was right after the level was loaded.
+typedef struct SAVEGAME_BASELINE {
+    char *data;
+    int32_t size;
+    int32_t *offsets;
+    int32_t item_count;
+    int32_t level_num;
+} SAVEGAME_BASELINE;
+
+static SAVEGAME_STREAM m_SG = { 0 };
+static bool m_SGIsLegacy = false;
+static SAVEGAME_BASELINE m_Baseline = { 0 };
+static SAVEGAME_INDEX m_Index = { 0 };
+static SAVEGAME_WRITE m_Write = { 0 };
+static S_JOB *m_WriteJob = NULL;
 
 static bool SaveGame_NeedsEvilLaraFix();
 
 static void SaveGame_ResetSG(GAME_INFO *game_info);
+static void SaveGame_SetSG(char *data, int32_t size);
 static void SaveGame_SkipSG(int size);
+static bool SaveGame_FindChunk(
+    char *data, int32_t size, SAVEGAME_CHUNK_TYPE type);
 
 static void SaveGame_ReadSG(void *pointer, int size);
+static void SaveGame_ReadSGStartInfo(START_INFO *start);
+static void SaveGame_ReadSGGame(GAME_INFO *game_info, int32_t level_count);
+static void SaveGame_ReadSGItem(int16_t item_num, bool skip_evil_lara);
+static void SaveGame_ReadSGItems(GAME_INFO *game_info);
 static void SaveGame_ReadSGARM(LARA_ARM *arm);
 static void SaveGame_ReadSGLara(LARA_INFO *lara);
 static void SaveGame_ReadSGLOT(LOT_INFO *lot);
 
 static void SaveGame_WriteSG(void *pointer, int size);
+static int32_t SaveGame_BeginChunk(SAVEGAME_CHUNK_TYPE type);
+static void SaveGame_EndChunk(int32_t chunk_pos);
+static void SaveGame_WriteSGStartInfo(START_INFO *start);
+static void SaveGame_WriteSGItem(int16_t item_num);
+static void SaveGame_WriteSGItems();
 static void SaveGame_WriteSGARM(LARA_ARM *arm);
 static void SaveGame_WriteSGLara(LARA_INFO *lara);
 static void SaveGame_WriteSGLOT(LOT_INFO *lot);
 
-static void SaveGame_FillSaveBuffer(GAME_INFO *game_info);
+static void SaveGame_ApplyLegacySaveBuffer(GAME_INFO *game_info);
+static void SaveGame_ApplyChunkedSaveBuffer(GAME_INFO *game_info);
+
+static bool SaveGame_LoadFile(
+    const char *path, char **out_data, int32_t *out_size, bool *out_is_legacy);
+static void SaveGame_ReadInfo(
+    char *data, int32_t size, bool is_legacy, SAVEGAME_INDEX_ENTRY *entry);
+static void SaveGame_GetIndexPath(char *path);
+static bool SaveGame_ReadIndex();
+static bool SaveGame_WriteIndex(const SAVEGAME_INDEX *index);
+static void SaveGame_DeleteIndex();
+static void SaveGame_ReadFileInfo(int32_t slot, SAVEGAME_INDEX_ENTRY *entry);
+static bool SaveGame_CheckIndex();
+static void SaveGame_RebuildIndex();
+
+static void SaveGame_WriteJob(void *arg);
+static void SaveGame_FinishWrite();
 
 static bool SaveGame_NeedsEvilLaraFix(GAME_INFO *game_info)
 {
@@ -276,7 +404,7 @@ void CreateStartInfo(int level_num)
     }
 }
 
-static void SaveGame_FillSaveBuffer(GAME_INFO *game_info)
+void SaveGame_FillSaveBuffer(GAME_INFO *game_info)
 {
     // Write current game information into the save buffer.
 
@@ -285,14 +413,18 @@ static void SaveGame_FillSaveBuffer(GAME_INFO *game_info)
     CreateStartInfo(g_CurrentLevel);
 
     SaveGame_ResetSG(game_info);
-    memset(m_SGBufPtr, 0, MAX_SAVEGAME_BUFFER);
+    m_SGIsLegacy = false;
 
-    char title[SAVEGAME_TITLE_SIZE];
+    int32_t chunk_pos = SaveGame_BeginChunk(SAVEGAME_CHUNK_INFO);
+    char title[SAVEGAME_TITLE_SIZE] = { 0 };
     snprintf(
         title, SAVEGAME_TITLE_SIZE, "%s",
         g_GameFlow.levels[g_CurrentLevel].level_title);
     SaveGame_WriteSG(title, SAVEGAME_TITLE_SIZE);
     SaveGame_WriteSG(&g_SaveCounter, sizeof(int32_t));
+    int32_t level_num = g_CurrentLevel;
+    SaveGame_WriteSG(&level_num, sizeof(int32_t));
+    SaveGame_EndChunk(chunk_pos);
 
     for (int i = 0; i < g_GameFlow.level_count; i++) {
         if (g_GameFlow.levels[i].level_type == GFL_CURRENT) {
@@ -300,19 +432,12 @@ static void SaveGame_FillSaveBuffer(GAME_INFO *game_info)
         }
     }
 
+    chunk_pos = SaveGame_BeginChunk(SAVEGAME_CHUNK_GAME);
+    int32_t level_count = g_GameFlow.level_count;
+    SaveGame_WriteSG(&level_count, sizeof(int32_t));
     assert(game_info->start);
     for (int i = 0; i < g_GameFlow.level_count; i++) {
-        START_INFO *start = &game_info->start[i];
-        SaveGame_WriteSG(&start->pistol_ammo, sizeof(uint16_t));
-        SaveGame_WriteSG(&start->magnum_ammo, sizeof(uint16_t));
-        SaveGame_WriteSG(&start->uzi_ammo, sizeof(uint16_t));
-        SaveGame_WriteSG(&start->shotgun_ammo, sizeof(uint16_t));
-        SaveGame_WriteSG(&start->num_medis, sizeof(uint8_t));
-        SaveGame_WriteSG(&start->num_big_medis, sizeof(uint8_t));
-        SaveGame_WriteSG(&start->num_scions, sizeof(uint8_t));
-        SaveGame_WriteSG(&start->gun_status, sizeof(int8_t));
-        SaveGame_WriteSG(&start->gun_type, sizeof(int8_t));
-        SaveGame_WriteSG(&start->flags, sizeof(uint16_t));
+        SaveGame_WriteSGStartInfo(&game_info->start[i]);
     }
 
     SaveGame_WriteSG(&game_info->timer, sizeof(uint32_t));
@@ -338,73 +463,44 @@ static void SaveGame_FillSaveBuffer(GAME_INFO *game_info)
     };
 
     SaveGame_WriteSG(&item_stats, sizeof(item_stats));
+    SaveGame_EndChunk(chunk_pos);
 
+    chunk_pos = SaveGame_BeginChunk(SAVEGAME_CHUNK_FLIPMAPS);
     SaveGame_WriteSG(&g_FlipStatus, sizeof(int32_t));
+    int32_t flip_map_count = MAX_FLIP_MAPS;
+    SaveGame_WriteSG(&flip_map_count, sizeof(int32_t));
     for (int i = 0; i < MAX_FLIP_MAPS; i++) {
         int8_t flag = g_FlipMapTable[i] >> 8;
         SaveGame_WriteSG(&flag, sizeof(int8_t));
     }
+    SaveGame_WriteSG(&g_FlipEffect, sizeof(int32_t));
+    SaveGame_WriteSG(&g_FlipTimer, sizeof(int32_t));
+    SaveGame_EndChunk(chunk_pos);
 
+    chunk_pos = SaveGame_BeginChunk(SAVEGAME_CHUNK_CAMERAS);
+    SaveGame_WriteSG(&g_NumberCameras, sizeof(int32_t));
     for (int i = 0; i < g_NumberCameras; i++) {
         SaveGame_WriteSG(&g_Camera.fixed[i].flags, sizeof(int16_t));
     }
+    SaveGame_EndChunk(chunk_pos);
 
-    for (int i = 0; i < g_LevelItemCount; i++) {
-        ITEM_INFO *item = &g_Items[i];
-        OBJECT_INFO *obj = &g_Objects[item->object_number];
-
-        if (obj->save_position) {
-            SaveGame_WriteSG(&item->pos, sizeof(PHD_3DPOS));
-            SaveGame_WriteSG(&item->room_number, sizeof(int16_t));
-            SaveGame_WriteSG(&item->speed, sizeof(int16_t));
-            SaveGame_WriteSG(&item->fall_speed, sizeof(int16_t));
-        }
-
-        if (obj->save_anim) {
-            SaveGame_WriteSG(&item->current_anim_state, sizeof(int16_t));
-            SaveGame_WriteSG(&item->goal_anim_state, sizeof(int16_t));
-            SaveGame_WriteSG(&item->required_anim_state, sizeof(int16_t));
-            SaveGame_WriteSG(&item->anim_number, sizeof(int16_t));
-            SaveGame_WriteSG(&item->frame_number, sizeof(int16_t));
-        }
-
-        if (obj->save_hitpoints) {
-            SaveGame_WriteSG(&item->hit_points, sizeof(int16_t));
-        }
-
-        if (obj->save_flags) {
-            uint16_t flags = item->flags + item->active + (item->status << 1)
-                + (item->gravity_status << 3) + (item->collidable << 4);
-            if (obj->intelligent && item->data) {
-                flags |= SAVE_CREATURE;
-            }
-            SaveGame_WriteSG(&flags, sizeof(uint16_t));
-            SaveGame_WriteSG(&item->timer, sizeof(int16_t));
-            if (flags & SAVE_CREATURE) {
-                CREATURE_INFO *creature = item->data;
-                SaveGame_WriteSG(&creature->head_rotation, sizeof(int16_t));
-                SaveGame_WriteSG(&creature->neck_rotation, sizeof(int16_t));
-                SaveGame_WriteSG(&creature->maximum_turn, sizeof(int16_t));
-                SaveGame_WriteSG(&creature->flags, sizeof(int16_t));
-                SaveGame_WriteSG(&creature->mood, sizeof(int32_t));
-            }
-        }
-    }
+    SaveGame_WriteSGItems();
 
+    chunk_pos = SaveGame_BeginChunk(SAVEGAME_CHUNK_LARA);
     SaveGame_WriteSGLara(&g_Lara);
+    SaveGame_EndChunk(chunk_pos);
 
-    SaveGame_WriteSG(&g_FlipEffect, sizeof(int32_t));
-    SaveGame_WriteSG(&g_FlipTimer, sizeof(int32_t));
+    chunk_pos = SaveGame_BeginChunk(SAVEGAME_CHUNK_LOT);
+    SaveGame_WriteSGLOT(&g_Lara.LOT);
+    SaveGame_EndChunk(chunk_pos);
+
+    game_info->savegame_buffer = m_SG.data;
+    game_info->savegame_buffer_size = m_SG.pos;
 }
 
-void SaveGame_ApplySaveBuffer(GAME_INFO *game_info)
+static void SaveGame_ApplyLegacySaveBuffer(GAME_INFO *game_info)
 {
-    // Write current game information into the save buffer.
-
-    assert(game_info);
-
     int8_t tmp8;
-    int16_t tmp16;
     int32_t tmp32;
 
     bool skip_reading_evil_lara = SaveGame_NeedsEvilLaraFix(game_info);
@@ -415,49 +511,7 @@ void SaveGame_ApplySaveBuffer(GAME_INFO *game_info)
     SaveGame_ResetSG(game_info);
     SaveGame_SkipSG(SAVEGAME_TITLE_SIZE); // level title
     SaveGame_SkipSG(sizeof(int32_t)); // save counter
-
-    assert(game_info->start);
-    for (int i = 0; i < g_GameFlow.level_count; i++) {
-        START_INFO *start = &game_info->start[i];
-        SaveGame_ReadSG(&start->pistol_ammo, sizeof(uint16_t));
-        SaveGame_ReadSG(&start->magnum_ammo, sizeof(uint16_t));
-        SaveGame_ReadSG(&start->uzi_ammo, sizeof(uint16_t));
-        SaveGame_ReadSG(&start->shotgun_ammo, sizeof(uint16_t));
-        SaveGame_ReadSG(&start->num_medis, sizeof(uint8_t));
-        SaveGame_ReadSG(&start->num_big_medis, sizeof(uint8_t));
-        SaveGame_ReadSG(&start->num_scions, sizeof(uint8_t));
-        SaveGame_ReadSG(&start->gun_status, sizeof(int8_t));
-        SaveGame_ReadSG(&start->gun_type, sizeof(int8_t));
-        SaveGame_ReadSG(&start->flags, sizeof(uint16_t));
-    }
-
-    SaveGame_ReadSG(&game_info->timer, sizeof(uint32_t));
-    SaveGame_ReadSG(&game_info->kills, sizeof(uint32_t));
-    SaveGame_ReadSG(&game_info->secrets, sizeof(uint16_t));
-    SaveGame_ReadSG(&g_CurrentLevel, sizeof(uint16_t));
-    SaveGame_ReadSG(&game_info->pickups, sizeof(uint8_t));
-    SaveGame_ReadSG(&game_info->bonus_flag, sizeof(uint8_t));
-
-    for (int i = 0; i < g_GameFlow.level_count; i++) {
-        if (g_GameFlow.levels[i].level_type == GFL_CURRENT) {
-            game_info->start[g_CurrentLevel] = game_info->start[i];
-        }
-    }
-
-    InitialiseLaraInventory(g_CurrentLevel);
-    SAVEGAME_ITEM_STATS item_stats = { 0 };
-    SaveGame_ReadSG(&item_stats, sizeof(item_stats));
-    Inv_AddItemNTimes(O_PICKUP_ITEM1, item_stats.num_pickup1);
-    Inv_AddItemNTimes(O_PICKUP_ITEM2, item_stats.num_pickup2);
-    Inv_AddItemNTimes(O_PUZZLE_ITEM1, item_stats.num_puzzle1);
-    Inv_AddItemNTimes(O_PUZZLE_ITEM2, item_stats.num_puzzle2);
-    Inv_AddItemNTimes(O_PUZZLE_ITEM3, item_stats.num_puzzle3);
-    Inv_AddItemNTimes(O_PUZZLE_ITEM4, item_stats.num_puzzle4);
-    Inv_AddItemNTimes(O_KEY_ITEM1, item_stats.num_key1);
-    Inv_AddItemNTimes(O_KEY_ITEM2, item_stats.num_key2);
-    Inv_AddItemNTimes(O_KEY_ITEM3, item_stats.num_key3);
-    Inv_AddItemNTimes(O_KEY_ITEM4, item_stats.num_key4);
-    Inv_AddItemNTimes(O_LEADBAR_ITEM, item_stats.num_leadbar);
+    SaveGame_ReadSGGame(game_info, g_GameFlow.level_count);
 
     SaveGame_ReadSG(&tmp32, sizeof(int32_t));
     if (tmp32) {
@@ -474,181 +528,292 @@ void SaveGame_ApplySaveBuffer(GAME_INFO *game_info)
     }
 
     for (int i = 0; i < g_LevelItemCount; i++) {
-        ITEM_INFO *item = &g_Items[i];
-        OBJECT_INFO *obj = &g_Objects[item->object_number];
+        SaveGame_ReadSGItem(i, skip_reading_evil_lara);
+    }
 
-        if (obj->control == MovableBlockControl) {
-            AlterFloorHeight(item, WALL_L);
-        }
-        if (obj->control == RollingBlockControl) {
-            AlterFloorHeight(item, WALL_L * 2);
-        }
+    SaveGame_ReadSGLara(&g_Lara);
+    SaveGame_ReadSGLOT(&g_Lara.LOT);
 
-        if (obj->save_position) {
-            SaveGame_ReadSG(&item->pos, sizeof(PHD_3DPOS));
-            SaveGame_ReadSG(&tmp16, sizeof(int16_t));
-            SaveGame_ReadSG(&item->speed, sizeof(int16_t));
-            SaveGame_ReadSG(&item->fall_speed, sizeof(int16_t));
+    SaveGame_ReadSG(&g_FlipEffect, sizeof(int32_t));
+    SaveGame_ReadSG(&g_FlipTimer, sizeof(int32_t));
+}
 
-            if (item->room_number != tmp16) {
-                ItemNewRoom(i, tmp16);
-            }
+static void SaveGame_ApplyChunkedSaveBuffer(GAME_INFO *game_info)
+{
+    char *data = game_info->savegame_buffer;
+    const int32_t size = game_info->savegame_buffer_size;
 
-            if (obj->shadow_size) {
-                FLOOR_INFO *floor =
-                    GetFloor(item->pos.x, item->pos.y, item->pos.z, &tmp16);
-                item->floor =
-                    GetHeight(floor, item->pos.x, item->pos.y, item->pos.z);
-            }
-        }
+    if (SaveGame_FindChunk(data, size, SAVEGAME_CHUNK_GAME)) {
+        int32_t level_count;
+        SaveGame_ReadSG(&level_count, sizeof(int32_t));
+        SaveGame_ReadSGGame(game_info, level_count);
+    }
 
-        if (obj->save_anim) {
-            SaveGame_ReadSG(&item->current_anim_state, sizeof(int16_t));
-            SaveGame_ReadSG(&item->goal_anim_state, sizeof(int16_t));
-            SaveGame_ReadSG(&item->required_anim_state, sizeof(int16_t));
-            SaveGame_ReadSG(&item->anim_number, sizeof(int16_t));
-            SaveGame_ReadSG(&item->frame_number, sizeof(int16_t));
+    if (SaveGame_FindChunk(data, size, SAVEGAME_CHUNK_FLIPMAPS)) {
+        int32_t flip_status;
+        SaveGame_ReadSG(&flip_status, sizeof(int32_t));
+        if (flip_status) {
+            FlipMap();
         }
 
-        if (obj->save_hitpoints) {
-            SaveGame_ReadSG(&item->hit_points, sizeof(int16_t));
+        int32_t flip_map_count;
+        SaveGame_ReadSG(&flip_map_count, sizeof(int32_t));
+        for (int i = 0; i < flip_map_count; i++) {
+            int8_t flag;
+            SaveGame_ReadSG(&flag, sizeof(int8_t));
+            if (i < MAX_FLIP_MAPS) {
+                g_FlipMapTable[i] = flag << 8;
+            }
         }
 
-        if (obj->save_flags
-            && (item->object_number != O_EVIL_LARA
-                || !skip_reading_evil_lara)) {
-            SaveGame_ReadSG(&item->flags, sizeof(int16_t));
-            SaveGame_ReadSG(&item->timer, sizeof(int16_t));
+        SaveGame_ReadSG(&g_FlipEffect, sizeof(int32_t));
+        SaveGame_ReadSG(&g_FlipTimer, sizeof(int32_t));
+    }
 
-            if (item->flags & IF_KILLED_ITEM) {
-                KillItem(i);
-                item->status = IS_DEACTIVATED;
-            } else {
-                if ((item->flags & 1) && !item->active) {
-                    AddActiveItem(i);
-                }
-                item->status = (item->flags & 6) >> 1;
-                if (item->flags & 8) {
-                    item->gravity_status = 1;
-                }
-                if (!(item->flags & 16)) {
-                    item->collidable = 0;
-                }
+    if (SaveGame_FindChunk(data, size, SAVEGAME_CHUNK_CAMERAS)) {
+        int32_t camera_count;
+        SaveGame_ReadSG(&camera_count, sizeof(int32_t));
+        for (int i = 0; i < camera_count; i++) {
+            int16_t flags;
+            SaveGame_ReadSG(&flags, sizeof(int16_t));
+            if (i < g_NumberCameras) {
+                g_Camera.fixed[i].flags = flags;
             }
+        }
+    }
 
-            if (item->flags & SAVE_CREATURE) {
-                EnableBaddieAI(i, 1);
-                CREATURE_INFO *creature = item->data;
-                if (creature) {
-                    SaveGame_ReadSG(&creature->head_rotation, sizeof(int16_t));
-                    SaveGame_ReadSG(&creature->neck_rotation, sizeof(int16_t));
-                    SaveGame_ReadSG(&creature->maximum_turn, sizeof(int16_t));
-                    SaveGame_ReadSG(&creature->flags, sizeof(int16_t));
-                    SaveGame_ReadSG(&creature->mood, sizeof(int32_t));
-                } else {
-                    SaveGame_SkipSG(4 * 2 + 4);
-                }
-            } else if (obj->intelligent) {
-                item->data = NULL;
-            }
+    SaveGame_ReadSGItems(game_info);
 
-            item->flags &= 0xFF00;
+    if (SaveGame_FindChunk(data, size, SAVEGAME_CHUNK_LARA)) {
+        SaveGame_ReadSGLara(&g_Lara);
+    }
 
-            if (obj->collision == PuzzleHoleCollision
-                && (item->status == IS_DEACTIVATED
-                    || item->status == IS_ACTIVE)) {
-                item->object_number += O_PUZZLE_DONE1 - O_PUZZLE_HOLE1;
-            }
+    if (SaveGame_FindChunk(data, size, SAVEGAME_CHUNK_LOT)) {
+        SaveGame_ReadSGLOT(&g_Lara.LOT);
+    }
+}
 
-            if (obj->control == PodControl && item->status == IS_DEACTIVATED) {
-                item->mesh_bits = 0x1FF;
-                item->collidable = 0;
-            }
+void SaveGame_ApplySaveBuffer(GAME_INFO *game_info)
+{
+    // Read the game information from the save buffer into the current game.
 
-            if (obj->collision == PickUpCollision
-                && item->status == IS_DEACTIVATED) {
-                RemoveDrawnItem(i);
-            }
-        }
+    assert(game_info);
 
-        if (obj->control == MovableBlockControl
-            && item->status == IS_NOT_ACTIVE) {
-            AlterFloorHeight(item, -WALL_L);
-        }
+    BOX_NODE *node = g_Lara.LOT.node;
+    if (m_SGIsLegacy) {
+        SaveGame_ApplyLegacySaveBuffer(game_info);
+    } else {
+        SaveGame_ApplyChunkedSaveBuffer(game_info);
+    }
+    g_Lara.LOT.node = node;
+    g_Lara.LOT.target_box = NO_BOX;
+}
 
-        if (obj->control == RollingBlockControl
-            && item->current_anim_state != RBS_MOVING) {
-            AlterFloorHeight(item, -WALL_L * 2);
-        }
+void SaveGame_SetSaveBuffer(
+    GAME_INFO *game_info, const char *data, int32_t size)
+{
+    assert(game_info);
+    assert(data);
+    game_info->savegame_buffer =
+        Memory_Realloc(game_info->savegame_buffer, size);
+    memcpy(game_info->savegame_buffer, data, size);
+    game_info->savegame_buffer_size = size;
+    m_SGIsLegacy = false;
+}
 
-        if (item->object_number == O_PIERRE && item->hit_points <= 0
-            && (item->flags & IF_ONESHOT)) {
-            if (Inv_RequestItem(O_SCION_ITEM) == 1) {
-                SpawnItem(item, O_MAGNUM_ITEM);
-                SpawnItem(item, O_SCION_ITEM2);
-                SpawnItem(item, O_KEY_ITEM1);
-            }
-            g_MusicTrackFlags[MX_PIERRE_SPEECH] |= IF_ONESHOT;
-        }
+void SaveGame_StoreItemBaseline()
+{
+    Memory_FreePointer(&m_Baseline.offsets);
+    m_Baseline.offsets = Memory_Alloc(sizeof(int32_t) * (g_LevelItemCount + 1));
 
-        if (item->object_number == O_MERCENARY1 && item->hit_points <= 0) {
-            if (!Inv_RequestItem(O_UZI_ITEM)) {
-                SpawnItem(item, O_UZI_ITEM);
-            }
-        }
+    SaveGame_SetSG(m_Baseline.data, m_Baseline.size);
+    for (int i = 0; i < g_LevelItemCount; i++) {
+        m_Baseline.offsets[i] = m_SG.pos;
+        SaveGame_WriteSGItem(i);
+    }
+    m_Baseline.offsets[g_LevelItemCount] = m_SG.pos;
 
-        if (item->object_number == O_MERCENARY2 && item->hit_points <= 0) {
-            if (!Inv_RequestItem(O_MAGNUM_ITEM)) {
-                SpawnItem(item, O_MAGNUM_ITEM);
-            }
-            g_MusicTrackFlags[MX_COWBOY_SPEECH] |= IF_ONESHOT;
-        }
+    m_Baseline.data = m_SG.data;
+    m_Baseline.size = m_SG.pos;
+    m_Baseline.item_count = g_LevelItemCount;
+    m_Baseline.level_num = g_CurrentLevel;
+}
 
-        if (item->object_number == O_MERCENARY3 && item->hit_points <= 0) {
-            if (!Inv_RequestItem(O_SHOTGUN_ITEM)) {
-                SpawnItem(item, O_SHOTGUN_ITEM);
-            }
-            g_MusicTrackFlags[MX_BALDY_SPEECH] |= IF_ONESHOT;
-        }
+static void SaveGame_ResetSG(GAME_INFO *game_info)
+{
+    assert(game_info);
+    SaveGame_SetSG(
+        game_info->savegame_buffer, game_info->savegame_buffer_size);
+}
+
+static void SaveGame_SetSG(char *data, int32_t size)
+{
+    m_SG.data = data;
+    m_SG.size = size;
+    m_SG.capacity = size;
+    m_SG.pos = 0;
+}
+
+static void SaveGame_SkipSG(int size)
+{
+    m_SG.pos += size;
+}
 
-        if (item->object_number == O_LARSON && item->hit_points <= 0) {
-            g_MusicTrackFlags[MX_BALDY_SPEECH] |= IF_ONESHOT;
+static bool SaveGame_FindChunk(
+    char *data, int32_t size, SAVEGAME_CHUNK_TYPE type)
+{
+    // Chunks only ever have new fields appended to them, and reading past the
+    // end of a chunk yields zeros, so chunks of any version can be read.
+    int32_t pos = 0;
+    while (pos + (int32_t)sizeof(SAVEGAME_CHUNK_HEADER) <= size) {
+        SAVEGAME_CHUNK_HEADER header;
+        memcpy(&header, &data[pos], sizeof(SAVEGAME_CHUNK_HEADER));
+        pos += sizeof(SAVEGAME_CHUNK_HEADER);
+        if (header.size > (uint32_t)(size - pos)) {
+            break;
         }
+        if (header.type == type) {
+            SaveGame_SetSG(&data[pos], header.size);
+            return true;
+        }
+        pos += header.size;
     }
 
-    BOX_NODE *node = g_Lara.LOT.node;
-    SaveGame_ReadSGLara(&g_Lara);
-    g_Lara.LOT.node = node;
-    g_Lara.LOT.target_box = NO_BOX;
+    LOG_ERROR("Savegame chunk %d is missing", type);
+    return false;
+}
 
-    SaveGame_ReadSG(&g_FlipEffect, sizeof(int32_t));
-    SaveGame_ReadSG(&g_FlipTimer, sizeof(int32_t));
+static void SaveGame_WriteSG(void *pointer, int size)
+{
+    if (m_SG.pos + size > m_SG.capacity) {
+        m_SG.capacity = MAX(m_SG.capacity * 2, m_SG.pos + size);
+        m_SG.capacity = MAX(m_SG.capacity, SAVEGAME_BUFFER_MIN_SIZE);
+        m_SG.data = Memory_Realloc(m_SG.data, m_SG.capacity);
+    }
+    memcpy(&m_SG.data[m_SG.pos], pointer, size);
+    m_SG.pos += size;
 }
 
-static void SaveGame_ResetSG(GAME_INFO *game_info)
+static int32_t SaveGame_BeginChunk(SAVEGAME_CHUNK_TYPE type)
 {
-    assert(game_info);
-    m_SGBufPos = 0;
-    m_SGBufPtr = game_info->savegame_buffer;
+    const int32_t chunk_pos = m_SG.pos;
+    SAVEGAME_CHUNK_HEADER header = {
+        .type = type,
+        .version = SAVEGAME_CHUNK_VERSION,
+        .size = 0,
+    };
+    SaveGame_WriteSG(&header, sizeof(SAVEGAME_CHUNK_HEADER));
+    return chunk_pos;
 }
 
-static void SaveGame_SkipSG(int size)
+static void SaveGame_EndChunk(int32_t chunk_pos)
 {
-    m_SGBufPtr += size;
-    m_SGBufPos += size; // missing from OG
+    // the size is only known once the whole chunk is written
+    const uint32_t size =
+        m_SG.pos - chunk_pos - sizeof(SAVEGAME_CHUNK_HEADER);
+    memcpy(
+        &m_SG.data[chunk_pos + offsetof(SAVEGAME_CHUNK_HEADER, size)], &size,
+        sizeof(uint32_t));
 }
 
-static void SaveGame_WriteSG(void *pointer, int size)
+static void SaveGame_WriteSGStartInfo(START_INFO *start)
 {
-    m_SGBufPos += size;
-    if (m_SGBufPos >= MAX_SAVEGAME_BUFFER) {
-        Shell_ExitSystem("FATAL: Savegame is too big to fit in buffer");
+    SaveGame_WriteSG(&start->pistol_ammo, sizeof(uint16_t));
+    SaveGame_WriteSG(&start->magnum_ammo, sizeof(uint16_t));
+    SaveGame_WriteSG(&start->uzi_ammo, sizeof(uint16_t));
+    SaveGame_WriteSG(&start->shotgun_ammo, sizeof(uint16_t));
+    SaveGame_WriteSG(&start->num_medis, sizeof(uint8_t));
+    SaveGame_WriteSG(&start->num_big_medis, sizeof(uint8_t));
+    SaveGame_WriteSG(&start->num_scions, sizeof(uint8_t));
+    SaveGame_WriteSG(&start->gun_status, sizeof(int8_t));
+    SaveGame_WriteSG(&start->gun_type, sizeof(int8_t));
+    SaveGame_WriteSG(&start->flags, sizeof(uint16_t));
+}
+
+static void SaveGame_WriteSGItem(int16_t item_num)
+{
+    ITEM_INFO *item = &g_Items[item_num];
+    OBJECT_INFO *obj = &g_Objects[item->object_number];
+
+    if (obj->save_position) {
+        SaveGame_WriteSG(&item->pos, sizeof(PHD_3DPOS));
+        SaveGame_WriteSG(&item->room_number, sizeof(int16_t));
+        SaveGame_WriteSG(&item->speed, sizeof(int16_t));
+        SaveGame_WriteSG(&item->fall_speed, sizeof(int16_t));
     }
 
-    char *data = (char *)pointer;
-    for (int i = 0; i < size; i++) {
-        *m_SGBufPtr++ = *data++;
+    if (obj->save_anim) {
+        SaveGame_WriteSG(&item->current_anim_state, sizeof(int16_t));
+        SaveGame_WriteSG(&item->goal_anim_state, sizeof(int16_t));
+        SaveGame_WriteSG(&item->required_anim_state, sizeof(int16_t));
+        SaveGame_WriteSG(&item->anim_number, sizeof(int16_t));
+        SaveGame_WriteSG(&item->frame_number, sizeof(int16_t));
     }
+
+    if (obj->save_hitpoints) {
+        SaveGame_WriteSG(&item->hit_points, sizeof(int16_t));
+    }
+
+    if (obj->save_flags) {
+        uint16_t flags = item->flags + item->active + (item->status << 1)
+            + (item->gravity_status << 3) + (item->collidable << 4);
+        if (obj->intelligent && item->data) {
+            flags |= SAVE_CREATURE;
+        }
+        SaveGame_WriteSG(&flags, sizeof(uint16_t));
+        SaveGame_WriteSG(&item->timer, sizeof(int16_t));
+        if (flags & SAVE_CREATURE) {
+            CREATURE_INFO *creature = item->data;
+            SaveGame_WriteSG(&creature->head_rotation, sizeof(int16_t));
+            SaveGame_WriteSG(&creature->neck_rotation, sizeof(int16_t));
+            SaveGame_WriteSG(&creature->maximum_turn, sizeof(int16_t));
+            SaveGame_WriteSG(&creature->flags, sizeof(int16_t));
+            SaveGame_WriteSG(&creature->mood, sizeof(int32_t));
+        }
+    }
+}
+
+static void SaveGame_WriteSGItems()
+{
+    // Only the items whose record differs from the one they had at the start
+    // of the level are written, each prefixed with its number and size.
+    const bool has_baseline = m_Baseline.level_num == g_CurrentLevel
+        && m_Baseline.item_count == g_LevelItemCount;
+
+    const int32_t chunk_pos = SaveGame_BeginChunk(SAVEGAME_CHUNK_ITEMS);
+    SaveGame_WriteSG(&g_LevelItemCount, sizeof(int32_t));
+    const int32_t changed_count_pos = m_SG.pos;
+    int32_t changed_count = 0;
+    SaveGame_WriteSG(&changed_count, sizeof(int32_t));
+
+    for (int i = 0; i < g_LevelItemCount; i++) {
+        const int32_t record_pos = m_SG.pos;
+        int16_t item_num = i;
+        uint16_t record_size = 0;
+        SaveGame_WriteSG(&item_num, sizeof(int16_t));
+        SaveGame_WriteSG(&record_size, sizeof(uint16_t));
+        const int32_t data_pos = m_SG.pos;
+        SaveGame_WriteSGItem(i);
+        record_size = m_SG.pos - data_pos;
+
+        if (has_baseline
+            && record_size
+                == m_Baseline.offsets[i + 1] - m_Baseline.offsets[i]
+            && !memcmp(
+                &m_SG.data[data_pos], &m_Baseline.data[m_Baseline.offsets[i]],
+                record_size)) {
+            m_SG.pos = record_pos;
+            continue;
+        }
+
+        memcpy(
+            &m_SG.data[record_pos + sizeof(int16_t)], &record_size,
+            sizeof(uint16_t));
+        changed_count++;
+    }
+
+    memcpy(&m_SG.data[changed_count_pos], &changed_count, sizeof(int32_t));
+    SaveGame_EndChunk(chunk_pos);
 }
 
 static void SaveGame_WriteSGLara(LARA_INFO *lara)
@@ -705,7 +870,6 @@ static void SaveGame_WriteSGLara(LARA_INFO *lara)
     SaveGame_WriteSG(&lara->magnums, sizeof(AMMO_INFO));
     SaveGame_WriteSG(&lara->uzis, sizeof(AMMO_INFO));
     SaveGame_WriteSG(&lara->shotgun, sizeof(AMMO_INFO));
-    SaveGame_WriteSGLOT(&lara->LOT);
 }
 
 static void SaveGame_WriteSGARM(LARA_ARM *arm)
@@ -740,10 +904,262 @@ static void SaveGame_WriteSGLOT(LOT_INFO *lot)
 
 static void SaveGame_ReadSG(void *pointer, int size)
 {
-    m_SGBufPos += size;
+    // reading past the end yields zeros, which is what the fields missing
+    // from older saves read as
     char *data = (char *)pointer;
-    for (int i = 0; i < size; i++)
-        *data++ = *m_SGBufPtr++;
+    for (int i = 0; i < size; i++) {
+        const int32_t pos = m_SG.pos + i;
+        *data++ = pos < m_SG.size ? m_SG.data[pos] : 0;
+    }
+    m_SG.pos += size;
+}
+
+static void SaveGame_ReadSGStartInfo(START_INFO *start)
+{
+    SaveGame_ReadSG(&start->pistol_ammo, sizeof(uint16_t));
+    SaveGame_ReadSG(&start->magnum_ammo, sizeof(uint16_t));
+    SaveGame_ReadSG(&start->uzi_ammo, sizeof(uint16_t));
+    SaveGame_ReadSG(&start->shotgun_ammo, sizeof(uint16_t));
+    SaveGame_ReadSG(&start->num_medis, sizeof(uint8_t));
+    SaveGame_ReadSG(&start->num_big_medis, sizeof(uint8_t));
+    SaveGame_ReadSG(&start->num_scions, sizeof(uint8_t));
+    SaveGame_ReadSG(&start->gun_status, sizeof(int8_t));
+    SaveGame_ReadSG(&start->gun_type, sizeof(int8_t));
+    SaveGame_ReadSG(&start->flags, sizeof(uint16_t));
+}
+
+static void SaveGame_ReadSGGame(GAME_INFO *game_info, int32_t level_count)
+{
+    assert(game_info->start);
+    for (int i = 0; i < level_count; i++) {
+        START_INFO dummy;
+        SaveGame_ReadSGStartInfo(
+            i < g_GameFlow.level_count ? &game_info->start[i] : &dummy);
+    }
+
+    SaveGame_ReadSG(&game_info->timer, sizeof(uint32_t));
+    SaveGame_ReadSG(&game_info->kills, sizeof(uint32_t));
+    SaveGame_ReadSG(&game_info->secrets, sizeof(uint16_t));
+    SaveGame_ReadSG(&g_CurrentLevel, sizeof(uint16_t));
+    SaveGame_ReadSG(&game_info->pickups, sizeof(uint8_t));
+    SaveGame_ReadSG(&game_info->bonus_flag, sizeof(uint8_t));
+
+    for (int i = 0; i < g_GameFlow.level_count; i++) {
+        if (g_GameFlow.levels[i].level_type == GFL_CURRENT) {
+            game_info->start[g_CurrentLevel] = game_info->start[i];
+        }
+    }
+
+    InitialiseLaraInventory(g_CurrentLevel);
+    SAVEGAME_ITEM_STATS item_stats = { 0 };
+    SaveGame_ReadSG(&item_stats, sizeof(item_stats));
+    Inv_AddItemNTimes(O_PICKUP_ITEM1, item_stats.num_pickup1);
+    Inv_AddItemNTimes(O_PICKUP_ITEM2, item_stats.num_pickup2);
+    Inv_AddItemNTimes(O_PUZZLE_ITEM1, item_stats.num_puzzle1);
+    Inv_AddItemNTimes(O_PUZZLE_ITEM2, item_stats.num_puzzle2);
+    Inv_AddItemNTimes(O_PUZZLE_ITEM3, item_stats.num_puzzle3);
+    Inv_AddItemNTimes(O_PUZZLE_ITEM4, item_stats.num_puzzle4);
+    Inv_AddItemNTimes(O_KEY_ITEM1, item_stats.num_key1);
+    Inv_AddItemNTimes(O_KEY_ITEM2, item_stats.num_key2);
+    Inv_AddItemNTimes(O_KEY_ITEM3, item_stats.num_key3);
+    Inv_AddItemNTimes(O_KEY_ITEM4, item_stats.num_key4);
+    Inv_AddItemNTimes(O_LEADBAR_ITEM, item_stats.num_leadbar);
+}
+
+static void SaveGame_ReadSGItem(int16_t item_num, bool skip_evil_lara)
+{
+    ITEM_INFO *item = &g_Items[item_num];
+    OBJECT_INFO *obj = &g_Objects[item->object_number];
+    int16_t tmp16;
+
+    if (obj->control == MovableBlockControl) {
+        AlterFloorHeight(item, WALL_L);
+    }
+    if (obj->control == RollingBlockControl) {
+        AlterFloorHeight(item, WALL_L * 2);
+    }
+
+    if (obj->save_position) {
+        SaveGame_ReadSG(&item->pos, sizeof(PHD_3DPOS));
+        SaveGame_ReadSG(&tmp16, sizeof(int16_t));
+        SaveGame_ReadSG(&item->speed, sizeof(int16_t));
+        SaveGame_ReadSG(&item->fall_speed, sizeof(int16_t));
+
+        if (item->room_number != tmp16) {
+            ItemNewRoom(item_num, tmp16);
+        }
+
+        if (obj->shadow_size) {
+            FLOOR_INFO *floor =
+                GetFloor(item->pos.x, item->pos.y, item->pos.z, &tmp16);
+            item->floor =
+                GetHeight(floor, item->pos.x, item->pos.y, item->pos.z);
+        }
+    }
+
+    if (obj->save_anim) {
+        SaveGame_ReadSG(&item->current_anim_state, sizeof(int16_t));
+        SaveGame_ReadSG(&item->goal_anim_state, sizeof(int16_t));
+        SaveGame_ReadSG(&item->required_anim_state, sizeof(int16_t));
+        SaveGame_ReadSG(&item->anim_number, sizeof(int16_t));
+        SaveGame_ReadSG(&item->frame_number, sizeof(int16_t));
+    }
+
+    if (obj->save_hitpoints) {
+        SaveGame_ReadSG(&item->hit_points, sizeof(int16_t));
+    }
+
+    if (obj->save_flags
+        && (item->object_number != O_EVIL_LARA || !skip_evil_lara)) {
+        SaveGame_ReadSG(&item->flags, sizeof(int16_t));
+        SaveGame_ReadSG(&item->timer, sizeof(int16_t));
+
+        if (item->flags & IF_KILLED_ITEM) {
+            KillItem(item_num);
+            item->status = IS_DEACTIVATED;
+        } else {
+            if ((item->flags & 1) && !item->active) {
+                AddActiveItem(item_num);
+            }
+            item->status = (item->flags & 6) >> 1;
+            if (item->flags & 8) {
+                item->gravity_status = 1;
+            }
+            if (!(item->flags & 16)) {
+                item->collidable = 0;
+            }
+        }
+
+        if (item->flags & SAVE_CREATURE) {
+            EnableBaddieAI(item_num, 1);
+            CREATURE_INFO *creature = item->data;
+            if (creature) {
+                SaveGame_ReadSG(&creature->head_rotation, sizeof(int16_t));
+                SaveGame_ReadSG(&creature->neck_rotation, sizeof(int16_t));
+                SaveGame_ReadSG(&creature->maximum_turn, sizeof(int16_t));
+                SaveGame_ReadSG(&creature->flags, sizeof(int16_t));
+                SaveGame_ReadSG(&creature->mood, sizeof(int32_t));
+            } else {
+                SaveGame_SkipSG(4 * 2 + 4);
+            }
+        } else if (obj->intelligent) {
+            item->data = NULL;
+        }
+
+        item->flags &= 0xFF00;
+
+        if (obj->collision == PuzzleHoleCollision
+            && (item->status == IS_DEACTIVATED || item->status == IS_ACTIVE)) {
+            item->object_number += O_PUZZLE_DONE1 - O_PUZZLE_HOLE1;
+        }
+
+        if (obj->control == PodControl && item->status == IS_DEACTIVATED) {
+            item->mesh_bits = 0x1FF;
+            item->collidable = 0;
+        }
+
+        if (obj->collision == PickUpCollision
+            && item->status == IS_DEACTIVATED) {
+            RemoveDrawnItem(item_num);
+        }
+    }
+
+    if (obj->control == MovableBlockControl && item->status == IS_NOT_ACTIVE) {
+        AlterFloorHeight(item, -WALL_L);
+    }
+
+    if (obj->control == RollingBlockControl
+        && item->current_anim_state != RBS_MOVING) {
+        AlterFloorHeight(item, -WALL_L * 2);
+    }
+
+    if (item->object_number == O_PIERRE && item->hit_points <= 0
+        && (item->flags & IF_ONESHOT)) {
+        if (Inv_RequestItem(O_SCION_ITEM) == 1) {
+            SpawnItem(item, O_MAGNUM_ITEM);
+            SpawnItem(item, O_SCION_ITEM2);
+            SpawnItem(item, O_KEY_ITEM1);
+        }
+        g_MusicTrackFlags[MX_PIERRE_SPEECH] |= IF_ONESHOT;
+    }
+
+    if (item->object_number == O_MERCENARY1 && item->hit_points <= 0) {
+        if (!Inv_RequestItem(O_UZI_ITEM)) {
+            SpawnItem(item, O_UZI_ITEM);
+        }
+    }
+
+    if (item->object_number == O_MERCENARY2 && item->hit_points <= 0) {
+        if (!Inv_RequestItem(O_MAGNUM_ITEM)) {
+            SpawnItem(item, O_MAGNUM_ITEM);
+        }
+        g_MusicTrackFlags[MX_COWBOY_SPEECH] |= IF_ONESHOT;
+    }
+
+    if (item->object_number == O_MERCENARY3 && item->hit_points <= 0) {
+        if (!Inv_RequestItem(O_SHOTGUN_ITEM)) {
+            SpawnItem(item, O_SHOTGUN_ITEM);
+        }
+        g_MusicTrackFlags[MX_BALDY_SPEECH] |= IF_ONESHOT;
+    }
+
+    if (item->object_number == O_LARSON && item->hit_points <= 0) {
+        g_MusicTrackFlags[MX_BALDY_SPEECH] |= IF_ONESHOT;
+    }
+}
+
+static void SaveGame_ReadSGItems(GAME_INFO *game_info)
+{
+    // The items missing from the save are still in the state they had at the
+    // start of the level, so their records are taken from the baseline.
+    char **records = Memory_Alloc(sizeof(char *) * g_LevelItemCount);
+    int32_t *record_sizes = Memory_Alloc(sizeof(int32_t) * g_LevelItemCount);
+
+    if (m_Baseline.level_num == g_CurrentLevel
+        && m_Baseline.item_count == g_LevelItemCount) {
+        for (int i = 0; i < g_LevelItemCount; i++) {
+            records[i] = &m_Baseline.data[m_Baseline.offsets[i]];
+            record_sizes[i] =
+                m_Baseline.offsets[i + 1] - m_Baseline.offsets[i];
+        }
+    }
+
+    if (SaveGame_FindChunk(
+            game_info->savegame_buffer, game_info->savegame_buffer_size,
+            SAVEGAME_CHUNK_ITEMS)) {
+        int32_t item_count;
+        int32_t changed_count;
+        SaveGame_ReadSG(&item_count, sizeof(int32_t));
+        SaveGame_ReadSG(&changed_count, sizeof(int32_t));
+        if (item_count != g_LevelItemCount) {
+            LOG_ERROR(
+                "Savegame has %d items, the level has %d", item_count,
+                g_LevelItemCount);
+        }
+
+        for (int i = 0; i < changed_count; i++) {
+            int16_t item_num;
+            uint16_t record_size;
+            SaveGame_ReadSG(&item_num, sizeof(int16_t));
+            SaveGame_ReadSG(&record_size, sizeof(uint16_t));
+            if (item_num >= 0 && item_num < g_LevelItemCount
+                && m_SG.pos + record_size <= m_SG.size) {
+                records[item_num] = &m_SG.data[m_SG.pos];
+                record_sizes[item_num] = record_size;
+            }
+            SaveGame_SkipSG(record_size);
+        }
+    }
+
+    for (int i = 0; i < g_LevelItemCount; i++) {
+        if (records[i]) {
+            SaveGame_SetSG(records[i], record_sizes[i]);
+            SaveGame_ReadSGItem(i, false);
+        }
+    }
+
+    Memory_FreePointer(&records);
+    Memory_FreePointer(&record_sizes);
 }
 
 static void SaveGame_ReadSGLara(LARA_INFO *lara)
@@ -794,7 +1210,6 @@ static void SaveGame_ReadSGLara(LARA_INFO *lara)
     SaveGame_ReadSG(&lara->magnums, sizeof(AMMO_INFO));
     SaveGame_ReadSG(&lara->uzis, sizeof(AMMO_INFO));
     SaveGame_ReadSG(&lara->shotgun, sizeof(AMMO_INFO));
-    SaveGame_ReadSGLOT(&lara->LOT);
 }
 
 static void SaveGame_ReadSGARM(LARA_ARM *arm)
@@ -829,99 +1244,385 @@ static void SaveGame_ReadSGLOT(LOT_INFO *lot)
     SaveGame_ReadSG(&lot->target, sizeof(PHD_VECTOR));
 }
 
+static bool SaveGame_LoadFile(
+    const char *path, char **out_data, int32_t *out_size, bool *out_is_legacy)
+{
+    MYFILE *fp = File_Open(path, FILE_OPEN_READ);
+    if (!fp) {
+        return false;
+    }
+    const size_t size = File_Size(fp);
+    char *data = Memory_Alloc(size);
+    File_Read(data, sizeof(char), size, fp);
+    File_Close(fp);
+
+    // the legacy saves start right away with the level title
+    SAVEGAME_FILE_HEADER header = { 0 };
+    if (size >= sizeof(SAVEGAME_FILE_HEADER)) {
+        memcpy(&header, data, sizeof(SAVEGAME_FILE_HEADER));
+    }
+    if (header.magic != SAVEGAME_FILE_MAGIC) {
+        *out_data = data;
+        *out_size = size;
+        *out_is_legacy = true;
+        return true;
+    }
+
+    const char *payload = &data[sizeof(SAVEGAME_FILE_HEADER)];
+    const size_t payload_size = size - sizeof(SAVEGAME_FILE_HEADER);
+    char *output = NULL;
+    bool result = header.version <= SAVEGAME_FILE_VERSION
+        && header.compressed_size <= payload_size;
+    if (result) {
+        output = Memory_Alloc(header.size);
+        switch (header.compression) {
+        case SAVEGAME_COMPRESSION_NONE:
+            result = header.compressed_size == header.size;
+            if (result) {
+                memcpy(output, payload, header.size);
+            }
+            break;
+        case SAVEGAME_COMPRESSION_LZSS:
+            result = Compress_Decode(
+                payload, header.compressed_size, output, header.size);
+            break;
+        default:
+            result = false;
+            break;
+        }
+    }
+    Memory_FreePointer(&data);
+
+    if (!result) {
+        LOG_ERROR("Savegame %s is corrupted", path);
+        Memory_FreePointer(&output);
+        return false;
+    }
+
+    *out_data = output;
+    *out_size = header.size;
+    *out_is_legacy = false;
+    return true;
+}
+
+static void SaveGame_ReadInfo(
+    char *data, int32_t size, bool is_legacy, SAVEGAME_INDEX_ENTRY *entry)
+{
+    entry->level_num = -1;
+
+    if (is_legacy) {
+        SaveGame_SetSG(data, size);
+        SaveGame_ReadSG(entry->title, SAVEGAME_TITLE_SIZE);
+        SaveGame_ReadSG(&entry->counter, sizeof(int32_t));
+        for (int i = 0; i < g_GameFlow.level_count; i++) {
+            SaveGame_SkipSG(sizeof(uint16_t)); // pistol ammo
+            SaveGame_SkipSG(sizeof(uint16_t)); // magnum ammo
+            SaveGame_SkipSG(sizeof(uint16_t)); // uzi ammo
+            SaveGame_SkipSG(sizeof(uint16_t)); // shotgun ammo
+            SaveGame_SkipSG(sizeof(uint8_t)); // small medis
+            SaveGame_SkipSG(sizeof(uint8_t)); // big medis
+            SaveGame_SkipSG(sizeof(uint8_t)); // scions
+            SaveGame_SkipSG(sizeof(int8_t)); // gun status
+            SaveGame_SkipSG(sizeof(int8_t)); // gun type
+            SaveGame_SkipSG(sizeof(uint16_t)); // flags
+        }
+        SaveGame_SkipSG(sizeof(uint32_t)); // timer
+        SaveGame_SkipSG(sizeof(uint32_t)); // kills
+        SaveGame_SkipSG(sizeof(uint16_t)); // secrets
+
+        uint16_t level_num;
+        SaveGame_ReadSG(&level_num, sizeof(int16_t));
+        entry->level_num = (int16_t)level_num;
+    } else if (SaveGame_FindChunk(data, size, SAVEGAME_CHUNK_INFO)) {
+        SaveGame_ReadSG(entry->title, SAVEGAME_TITLE_SIZE);
+        SaveGame_ReadSG(&entry->counter, sizeof(int32_t));
+        SaveGame_ReadSG(&entry->level_num, sizeof(int32_t));
+    }
+
+    entry->title[SAVEGAME_TITLE_SIZE] = '\0';
+}
+
+static void SaveGame_GetIndexPath(char *path)
+{
+    // the index sits next to the saves, e.g. saveati.idx for saveati.%d
+    const char *fmt = g_GameFlow.save_game_fmt;
+    const char *spec = strstr(fmt, "%d");
+    if (spec) {
+        sprintf(path, "%.*sidx%s", (int)(spec - fmt), fmt, spec + 2);
+    } else {
+        sprintf(path, "%s.idx", fmt);
+    }
+}
+
+static bool SaveGame_ReadIndex()
+{
+    char path[80];
+    SaveGame_GetIndexPath(path);
+
+    MYFILE *fp = File_Open(path, FILE_OPEN_READ);
+    if (!fp) {
+        return false;
+    }
+    const bool result =
+        File_Read(&m_Index, sizeof(SAVEGAME_INDEX), 1, fp) == 1
+        && m_Index.magic == SAVEGAME_INDEX_MAGIC
+        && m_Index.version == SAVEGAME_INDEX_VERSION
+        && m_Index.slot_count == MAX_SAVE_SLOTS;
+    File_Close(fp);
+
+    if (!result) {
+        LOG_INFO("%s is out of date", path);
+    }
+    return result;
+}
+
+static bool SaveGame_WriteIndex(const SAVEGAME_INDEX *index)
+{
+    char path[80];
+    SaveGame_GetIndexPath(path);
+    return File_WriteAtomic(path, index, sizeof(SAVEGAME_INDEX));
+}
+
+static void SaveGame_DeleteIndex()
+{
+    char path[80];
+    SaveGame_GetIndexPath(path);
+    File_Delete(path);
+}
+
+static void SaveGame_ReadFileInfo(int32_t slot, SAVEGAME_INDEX_ENTRY *entry)
+{
+    char filename[80];
+    sprintf(filename, g_GameFlow.save_game_fmt, slot);
+    size_t size = 0;
+    int64_t mtime = 0;
+    if (File_GetInfo(filename, &size, &mtime)) {
+        entry->file_size = size;
+        entry->file_mtime = mtime;
+    } else {
+        entry->file_size = -1;
+        entry->file_mtime = 0;
+    }
+}
+
+static bool SaveGame_CheckIndex()
+{
+    for (int i = 0; i < MAX_SAVE_SLOTS; i++) {
+        const SAVEGAME_INDEX_ENTRY *entry = &m_Index.entries[i];
+        SAVEGAME_INDEX_ENTRY info = { 0 };
+        SaveGame_ReadFileInfo(i, &info);
+        if (info.file_size != entry->file_size
+            || info.file_mtime != entry->file_mtime) {
+            LOG_INFO("save slot %d changed since it was indexed", i);
+            return false;
+        }
+    }
+    return true;
+}
+
+static void SaveGame_RebuildIndex()
+{
+    LOG_INFO("rebuilding the savegame index");
+
+    memset(&m_Index, 0, sizeof(SAVEGAME_INDEX));
+    m_Index.magic = SAVEGAME_INDEX_MAGIC;
+    m_Index.version = SAVEGAME_INDEX_VERSION;
+    m_Index.slot_count = MAX_SAVE_SLOTS;
+
+    for (int i = 0; i < MAX_SAVE_SLOTS; i++) {
+        char filename[80];
+        sprintf(filename, g_GameFlow.save_game_fmt, i);
+
+        // a file that cannot be loaded is still recorded, so that the index
+        // only gets rebuilt again once it changes
+        SAVEGAME_INDEX_ENTRY *entry = &m_Index.entries[i];
+        SaveGame_ReadFileInfo(i, entry);
+
+        char *data = NULL;
+        int32_t size = 0;
+        bool is_legacy = false;
+        if (!SaveGame_LoadFile(filename, &data, &size, &is_legacy)) {
+            continue;
+        }
+
+        entry->is_used = 1;
+        SaveGame_ReadInfo(data, size, is_legacy, entry);
+        Memory_FreePointer(&data);
+    }
+
+    if (!SaveGame_WriteIndex(&m_Index)) {
+        SaveGame_DeleteIndex();
+    }
+}
+
+static void SaveGame_WriteJob(void *arg)
+{
+    SAVEGAME_WRITE *write = arg;
+
+    // the compression is done here so that it stays off the main thread; the
+    // data is stored as it is in the unlikely case that it does not shrink
+    SAVEGAME_FILE_HEADER header = {
+        .magic = SAVEGAME_FILE_MAGIC,
+        .version = SAVEGAME_FILE_VERSION,
+        .compression = SAVEGAME_COMPRESSION_LZSS,
+        .size = write->size,
+    };
+    char *output = Memory_Alloc(
+        sizeof(SAVEGAME_FILE_HEADER) + Compress_Bound(write->size));
+    char *payload = &output[sizeof(SAVEGAME_FILE_HEADER)];
+    header.compressed_size = Compress_Encode(write->data, write->size, payload);
+    if (header.compressed_size >= write->size) {
+        header.compression = SAVEGAME_COMPRESSION_NONE;
+        header.compressed_size = write->size;
+        memcpy(payload, write->data, write->size);
+    }
+    memcpy(output, &header, sizeof(SAVEGAME_FILE_HEADER));
+
+    write->result = File_WriteAtomic(
+        write->path, output,
+        sizeof(SAVEGAME_FILE_HEADER) + header.compressed_size);
+    Memory_FreePointer(&output);
+
+    // the index only changes once the save itself is safely in place; if
+    // it cannot be updated, it is removed so that it gets rebuilt rather
+    // than trusted
+    write->index_result = false;
+    if (write->result) {
+        SaveGame_ReadFileInfo(write->slot, &write->index.entries[write->slot]);
+        write->index_result = SaveGame_WriteIndex(&write->index);
+        if (!write->index_result) {
+            SaveGame_DeleteIndex();
+        }
+    }
+}
+
+static void SaveGame_FinishWrite()
+{
+    S_Job_Wait(m_WriteJob);
+    m_WriteJob = NULL;
+
+    if (m_Write.result) {
+        const SAVEGAME_INDEX_ENTRY *entry =
+            &m_Write.index.entries[m_Write.slot];
+        REQUEST_INFO *req = &g_LoadSaveGameRequester;
+        if (req->item_flags[m_Write.slot] & RIF_BLOCKED) {
+            g_SavedGamesCount++;
+        }
+        req->item_flags[m_Write.slot] &= ~RIF_BLOCKED;
+        sprintf(
+            &req->item_texts[req->item_text_len * m_Write.slot], "%s %d",
+            entry->title, entry->counter);
+        m_Index = m_Write.index;
+        // the save number is only used up by a save that made it to disk
+        g_SaveCounter = MAX(g_SaveCounter, entry->counter + 1);
+        if (!m_Write.index_result) {
+            LOG_ERROR("Failed to update the savegame index");
+        }
+    } else {
+        LOG_ERROR("Failed to save the game to %s", m_Write.path);
+    }
+
+    Memory_FreePointer(&m_Write.path);
+    Memory_FreePointer(&m_Write.data);
+}
+
 int16_t SaveGame_LoadSaveBufferFromFile(GAME_INFO *game_info, int32_t slot)
 {
     assert(game_info);
+    SaveGame_WaitForWrite();
 
     char filename[80];
     sprintf(filename, g_GameFlow.save_game_fmt, slot);
     LOG_DEBUG("%s", filename);
 
-    MYFILE *fp = File_Open(filename, FILE_OPEN_READ);
-    if (!fp) {
+    char *data = NULL;
+    int32_t size = 0;
+    bool is_legacy = false;
+    if (!SaveGame_LoadFile(filename, &data, &size, &is_legacy)) {
         return -1;
     }
-    File_Read(
-        &game_info->savegame_buffer[0], sizeof(char), MAX_SAVEGAME_BUFFER, fp);
-    File_Close(fp);
 
-    SaveGame_ResetSG(game_info);
-    SaveGame_SkipSG(SAVEGAME_TITLE_SIZE); // level title
-    SaveGame_SkipSG(sizeof(int32_t)); // save counter
-    for (int i = 0; i < g_GameFlow.level_count; i++) {
-        SaveGame_SkipSG(sizeof(uint16_t)); // pistol ammo
-        SaveGame_SkipSG(sizeof(uint16_t)); // magnum ammo
-        SaveGame_SkipSG(sizeof(uint16_t)); // uzi ammo
-        SaveGame_SkipSG(sizeof(uint16_t)); // shotgun ammo
-        SaveGame_SkipSG(sizeof(uint8_t)); // small medis
-        SaveGame_SkipSG(sizeof(uint8_t)); // big medis
-        SaveGame_SkipSG(sizeof(uint8_t)); // scions
-        SaveGame_SkipSG(sizeof(int8_t)); // gun status
-        SaveGame_SkipSG(sizeof(int8_t)); // gun type
-        SaveGame_SkipSG(sizeof(uint16_t)); // flags
-    }
-    SaveGame_SkipSG(sizeof(uint32_t)); // timer
-    SaveGame_SkipSG(sizeof(uint32_t)); // kills
-    SaveGame_SkipSG(sizeof(uint16_t)); // secrets
-
-    uint16_t level_num;
-    SaveGame_ReadSG(&level_num, sizeof(int16_t));
+    Memory_FreePointer(&game_info->savegame_buffer);
+    game_info->savegame_buffer = data;
+    game_info->savegame_buffer_size = size;
+    m_SGIsLegacy = is_legacy;
 
-    return level_num;
+    SAVEGAME_INDEX_ENTRY info = { 0 };
+    SaveGame_ReadInfo(data, size, is_legacy, &info);
+    return info.level_num;
 }
 
 bool SaveGame_SaveToFile(GAME_INFO *game_info, int32_t slot)
 {
     assert(game_info);
+    SaveGame_WaitForWrite();
     SaveGame_FillSaveBuffer(game_info);
 
     char filename[80];
     sprintf(filename, g_GameFlow.save_game_fmt, slot);
     LOG_DEBUG("%s", filename);
 
-    MYFILE *fp = File_Open(filename, FILE_OPEN_WRITE);
-    if (!fp) {
-        return false;
+    // the buffer is copied, so that the game can carry on while the save is
+    // written in the background
+    m_Write.path = Memory_Dup(filename);
+    m_Write.size = game_info->savegame_buffer_size;
+    m_Write.data = Memory_Alloc(m_Write.size);
+    memcpy(m_Write.data, game_info->savegame_buffer, m_Write.size);
+    m_Write.slot = slot;
+    m_Write.result = false;
+
+    m_Write.index = m_Index;
+    SAVEGAME_INDEX_ENTRY *entry = &m_Write.index.entries[slot];
+    entry->is_used = 1;
+    entry->counter = g_SaveCounter;
+    entry->level_num = g_CurrentLevel;
+    entry->timestamp = time(NULL);
+    strncpy(
+        entry->title, g_GameFlow.levels[g_CurrentLevel].level_title,
+        SAVEGAME_TITLE_SIZE);
+    entry->title[SAVEGAME_TITLE_SIZE] = '\0';
+
+    m_WriteJob = S_Job_Start(SaveGame_WriteJob, &m_Write, "savegame_write");
+    return true;
+}
+
+void SaveGame_UpdateWrite()
+{
+    if (m_WriteJob && S_Job_IsDone(m_WriteJob)) {
+        SaveGame_FinishWrite();
     }
-    File_Write(&game_info->savegame_buffer[0], sizeof(char), m_SGBufPos, fp);
-    File_Close(fp);
+}
 
-    REQUEST_INFO *req = &g_LoadSaveGameRequester;
-    req->item_flags[slot] &= ~RIF_BLOCKED;
-    sprintf(
-        &req->item_texts[req->item_text_len * slot], "%s %d",
-        g_GameFlow.levels[g_CurrentLevel].level_title, g_SaveCounter);
-    g_SavedGamesCount++;
-    g_SaveCounter++;
-    return true;
+void SaveGame_WaitForWrite()
+{
+    if (m_WriteJob) {
+        SaveGame_FinishWrite();
+    }
 }
 
 void SaveGame_ScanSavedGames()
 {
+    SaveGame_WaitForWrite();
+    if (!SaveGame_ReadIndex() || !SaveGame_CheckIndex()) {
+        SaveGame_RebuildIndex();
+    }
+
     REQUEST_INFO *req = &g_LoadSaveGameRequester;
 
     req->items = 0;
     g_SaveCounter = 0;
     g_SavedGamesCount = 0;
     for (int i = 0; i < MAX_SAVE_SLOTS; i++) {
-        char filename[80];
-        sprintf(filename, g_GameFlow.save_game_fmt, i);
-
-        MYFILE *fp = File_Open(filename, FILE_OPEN_READ);
-        if (fp) {
-            File_Read(filename, sizeof(char), SAVEGAME_TITLE_SIZE, fp);
-            int32_t counter;
-            File_Read(&counter, sizeof(int32_t), 1, fp);
-            File_Close(fp);
-
+        const SAVEGAME_INDEX_ENTRY *entry = &m_Index.entries[i];
+        if (entry->is_used) {
             req->item_flags[req->items] &= ~RIF_BLOCKED;
 
             sprintf(
                 &req->item_texts[req->items * req->item_text_len], "%s %d",
-                filename, counter);
+                entry->title, entry->counter);
 
-            if (counter > g_SaveCounter) {
-                g_SaveCounter = counter;
+            if (entry->counter > g_SaveCounter) {
+                g_SaveCounter = entry->counter;
                 req->requested = i;
             }
 
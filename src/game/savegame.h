@@ -2,6 +2,7 @@
 
 #include "global/types.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
 void InitialiseStartInfo();
@@ -11,5 +12,19 @@ void CreateStartInfo(int level_num);
 int16_t SaveGame_LoadSaveBufferFromFile(GAME_INFO *save, int32_t slot);
 void SaveGame_ApplySaveBuffer(GAME_INFO *save);
 
+// Serializes the current game into the save buffer, or replaces the save
+// buffer contents, for the saves that are kept in memory only.
+void SaveGame_FillSaveBuffer(GAME_INFO *save);
+void SaveGame_SetSaveBuffer(GAME_INFO *save, const char *data, int32_t size);
+
+// Remembers the state of the level items right after the level is loaded.
+// The saves only store the items that differ from it.
+void SaveGame_StoreItemBaseline();
+
+// Saves are written in the background. The load/save requester and the save
+// counter are updated once the write finishes, which SaveGame_UpdateWrite
+// checks for; a failed write is logged and leaves both as they were.
 bool SaveGame_SaveToFile(GAME_INFO *save, int32_t slot);
+void SaveGame_UpdateWrite();
+void SaveGame_WaitForWrite();
 void SaveGame_ScanSavedGames();
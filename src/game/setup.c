@@ -26,6 +26,9 @@
 #include "game/ai/statue.h"
 #include "game/ai/vole.h"
 #include "game/ai/wolf.h"
+#include "game/ai_scheduler.h"
+#include "game/box_cluster.h"
+#include "game/box_field.h"
 #include "game/cinema.h"
 #include "game/draw.h"
 #include "game/effects/blood.h"
@@ -65,6 +68,7 @@
 #include "game/savegame.h"
 #include "game/screen.h"
 #include "game/sound.h"
+#include "game/spatial_hash.h"
 #include "game/text.h"
 #include "game/traps/damocles_sword.h"
 #include "game/traps/dart.h"
@@ -111,7 +115,11 @@ bool InitialiseLevel(int32_t level_num)
 
     g_Effects = GameBuf_Alloc(NUM_EFFECTS * sizeof(FX_INFO), GBUF_EFFECTS);
     InitialiseFXArray();
+    SpatialHash_Init();
     InitialiseLOTArray();
+    BoxField_Init();
+    BoxCluster_Init();
+    AIScheduler_Init();
 
     Overlay_Init();
     Overlay_BarSetHealthTimer(100);
@@ -48,6 +48,9 @@ void Shell_Main()
 {
     T1MInit();
     Config_Read();
+    if (g_Config.enable_json_log) {
+        Log_EnableJSONLines();
+    }
 
     const char *gameflow_path = m_T1MGameflowPath;
 
@@ -158,6 +161,7 @@ void Shell_Main()
         }
     }
 
+    SaveGame_WaitForWrite();
     Settings_Write();
     S_Shell_Shutdown();
 }
@@ -521,10 +521,29 @@ void Sound_StopAmbientSounds()
     }
 }
 
-void Sound_LoadSamples(
+bool Sound_PrepareSamples(size_t num_samples)
+{
+    return S_Audio_SamplesPrepare(num_samples);
+}
+
+bool Sound_LoadSamples(
     size_t num_samples, const char **sample_pointers, size_t *sizes)
 {
-    S_Audio_SamplesLoad(num_samples, sample_pointers, sizes);
+    return S_Audio_SamplesLoad(num_samples, sample_pointers, sizes);
+}
+
+bool Sound_GetSampleData(
+    int32_t sample_id, const float **data, int32_t *channels,
+    int32_t *num_samples)
+{
+    return S_Audio_SampleGetData(sample_id, data, channels, num_samples);
+}
+
+bool Sound_LoadSampleData(
+    size_t num_samples, const float **data, const int32_t *channels,
+    const int32_t *sample_counts)
+{
+    return S_Audio_SamplesLoadData(num_samples, data, channels, sample_counts);
 }
 
 void Sound_StopAllSamples()
@@ -15,5 +15,12 @@ void Sound_ResetAmbientLoudness();
 void Sound_StopAmbientSounds();
 void Sound_StopAllSamples();
 void Sound_SetMasterVolume(int8_t volume);
-void Sound_LoadSamples(
+bool Sound_PrepareSamples(size_t num_samples);
+bool Sound_LoadSamples(
     size_t num_samples, const char **sample_pointers, size_t *sizes);
+bool Sound_GetSampleData(
+    int32_t sample_id, const float **data, int32_t *channels,
+    int32_t *num_samples);
+bool Sound_LoadSampleData(
+    size_t num_samples, const float **data, const int32_t *channels,
+    const int32_t *sample_counts);
@@ -0,0 +1,239 @@
+#include "game/spatial_hash.h"
+
+#include "game/gamebuf.h"
+#include "global/const.h"
+#include "global/types.h"
+#include "global/vars.h"
+#include "util.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// the cells start out 4 by 4 sectors large and double in size until the
+// grid fits into this many of them
+#define SPATIAL_HASH_MAX_CELLS 4096
+// things can end up a little outside the room they are listed in until
+// their room gets updated
+#define SPATIAL_HASH_MARGIN WALL_L
+
+static int32_t m_MinX = 0;
+static int32_t m_MinZ = 0;
+static int32_t m_CellShift = 0;
+static int32_t m_CellsX = 0;
+static int32_t m_CellsZ = 0;
+// rooms in compressed rows: the rooms reaching into cell i are
+// m_CellRooms[m_CellStart[i]] up to m_CellRooms[m_CellStart[i + 1]]
+static int32_t *m_CellStart = NULL;
+static int16_t *m_CellRooms = NULL;
+static uint32_t *m_RoomStamps = NULL;
+static uint32_t m_Stamp = 0;
+static int16_t *m_Rooms = NULL;
+static int16_t m_Results[MAX_ITEMS];
+
+static void SpatialHash_GetCells(
+    int32_t min_x, int32_t max_x, int32_t min_z, int32_t max_z,
+    int32_t *cell_x0, int32_t *cell_z0, int32_t *cell_x1, int32_t *cell_z1);
+static bool SpatialHash_IsRoomClose(
+    const ROOM_INFO *r, int32_t x, int32_t y, int32_t z, int32_t radius);
+static void SpatialHash_AddRoom(int16_t room_num, bool store);
+static int32_t SpatialHash_FindRooms(
+    int32_t x, int32_t y, int32_t z, int32_t radius);
+static bool SpatialHash_IsInRadius(
+    const PHD_3DPOS *pos, int32_t x, int32_t y, int32_t z, int32_t radius);
+
+static void SpatialHash_GetCells(
+    int32_t min_x, int32_t max_x, int32_t min_z, int32_t max_z,
+    int32_t *cell_x0, int32_t *cell_z0, int32_t *cell_x1, int32_t *cell_z1)
+{
+    *cell_x0 = (min_x - m_MinX) >> m_CellShift;
+    *cell_x1 = (max_x - m_MinX) >> m_CellShift;
+    *cell_z0 = (min_z - m_MinZ) >> m_CellShift;
+    *cell_z1 = (max_z - m_MinZ) >> m_CellShift;
+    CLAMP(*cell_x0, 0, m_CellsX - 1);
+    CLAMP(*cell_x1, 0, m_CellsX - 1);
+    CLAMP(*cell_z0, 0, m_CellsZ - 1);
+    CLAMP(*cell_z1, 0, m_CellsZ - 1);
+}
+
+static bool SpatialHash_IsRoomClose(
+    const ROOM_INFO *r, int32_t x, int32_t y, int32_t z, int32_t radius)
+{
+    const int32_t margin = radius + SPATIAL_HASH_MARGIN;
+    return x > r->x - margin && x < r->x + (r->y_size << WALL_SHIFT) + margin
+        && z > r->z - margin && z < r->z + (r->x_size << WALL_SHIFT) + margin
+        && y > r->max_ceiling - margin && y < r->min_floor + margin;
+}
+
+static void SpatialHash_AddRoom(int16_t room_num, bool store)
+{
+    const ROOM_INFO *r = &g_RoomInfo[room_num];
+    int32_t cell_x0;
+    int32_t cell_z0;
+    int32_t cell_x1;
+    int32_t cell_z1;
+    SpatialHash_GetCells(
+        r->x - SPATIAL_HASH_MARGIN,
+        r->x + (r->y_size << WALL_SHIFT) + SPATIAL_HASH_MARGIN,
+        r->z - SPATIAL_HASH_MARGIN,
+        r->z + (r->x_size << WALL_SHIFT) + SPATIAL_HASH_MARGIN, &cell_x0,
+        &cell_z0, &cell_x1, &cell_z1);
+
+    for (int cell_z = cell_z0; cell_z <= cell_z1; cell_z++) {
+        for (int cell_x = cell_x0; cell_x <= cell_x1; cell_x++) {
+            const int32_t cell = cell_z * m_CellsX + cell_x;
+            if (store) {
+                m_CellRooms[m_CellStart[cell]++] = room_num;
+            } else {
+                m_CellStart[cell]++;
+            }
+        }
+    }
+}
+
+static int32_t SpatialHash_FindRooms(
+    int32_t x, int32_t y, int32_t z, int32_t radius)
+{
+    if (!m_CellStart) {
+        return 0;
+    }
+
+    int32_t cell_x0;
+    int32_t cell_z0;
+    int32_t cell_x1;
+    int32_t cell_z1;
+    SpatialHash_GetCells(
+        x - radius, x + radius, z - radius, z + radius, &cell_x0, &cell_z0,
+        &cell_x1, &cell_z1);
+
+    // a room reaching into several cells is only listed once
+    m_Stamp++;
+    int32_t count = 0;
+    for (int cell_z = cell_z0; cell_z <= cell_z1; cell_z++) {
+        for (int cell_x = cell_x0; cell_x <= cell_x1; cell_x++) {
+            const int32_t cell = cell_z * m_CellsX + cell_x;
+            for (int i = m_CellStart[cell]; i < m_CellStart[cell + 1]; i++) {
+                const int16_t room_num = m_CellRooms[i];
+                if (m_RoomStamps[room_num] == m_Stamp) {
+                    continue;
+                }
+                m_RoomStamps[room_num] = m_Stamp;
+                if (SpatialHash_IsRoomClose(
+                        &g_RoomInfo[room_num], x, y, z, radius)) {
+                    m_Rooms[count++] = room_num;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+static bool SpatialHash_IsInRadius(
+    const PHD_3DPOS *pos, int32_t x, int32_t y, int32_t z, int32_t radius)
+{
+    const int32_t dx = pos->x - x;
+    const int32_t dy = pos->y - y;
+    const int32_t dz = pos->z - z;
+    if (ABS(dx) >= radius || ABS(dy) >= radius || ABS(dz) >= radius) {
+        return false;
+    }
+    return (int64_t)dx * dx + (int64_t)dy * dy + (int64_t)dz * dz
+        < (int64_t)radius * radius;
+}
+
+void SpatialHash_Init()
+{
+    m_CellStart = NULL;
+    if (!g_RoomCount) {
+        return;
+    }
+
+    int32_t min_x = g_RoomInfo[0].x;
+    int32_t min_z = g_RoomInfo[0].z;
+    int32_t max_x = min_x;
+    int32_t max_z = min_z;
+    for (int i = 0; i < g_RoomCount; i++) {
+        const ROOM_INFO *r = &g_RoomInfo[i];
+        min_x = MIN(min_x, r->x);
+        min_z = MIN(min_z, r->z);
+        max_x = MAX(max_x, r->x + (r->y_size << WALL_SHIFT));
+        max_z = MAX(max_z, r->z + (r->x_size << WALL_SHIFT));
+    }
+    m_MinX = min_x - SPATIAL_HASH_MARGIN;
+    m_MinZ = min_z - SPATIAL_HASH_MARGIN;
+
+    m_CellShift = WALL_SHIFT + 2;
+    while (true) {
+        m_CellsX = ((max_x + SPATIAL_HASH_MARGIN - m_MinX) >> m_CellShift) + 1;
+        m_CellsZ = ((max_z + SPATIAL_HASH_MARGIN - m_MinZ) >> m_CellShift) + 1;
+        if (m_CellsX * m_CellsZ <= SPATIAL_HASH_MAX_CELLS) {
+            break;
+        }
+        m_CellShift++;
+    }
+
+    const int32_t cell_count = m_CellsX * m_CellsZ;
+    m_CellStart =
+        GameBuf_Alloc(sizeof(int32_t) * (cell_count + 1), GBUF_ROOM_INFOS);
+    for (int i = 0; i < g_RoomCount; i++) {
+        SpatialHash_AddRoom(i, false);
+    }
+
+    int32_t offset = 0;
+    for (int i = 0; i <= cell_count; i++) {
+        const int32_t size = m_CellStart[i];
+        m_CellStart[i] = offset;
+        offset += size;
+    }
+
+    m_CellRooms = GameBuf_Alloc(sizeof(int16_t) * offset, GBUF_ROOM_INFOS);
+    for (int i = 0; i < g_RoomCount; i++) {
+        SpatialHash_AddRoom(i, true);
+    }
+    // filling in the rooms moved each start up to where the next cell
+    // starts, so move them back
+    for (int i = cell_count; i > 0; i--) {
+        m_CellStart[i] = m_CellStart[i - 1];
+    }
+    m_CellStart[0] = 0;
+
+    m_RoomStamps =
+        GameBuf_Alloc(sizeof(uint32_t) * g_RoomCount, GBUF_ROOM_INFOS);
+    m_Rooms = GameBuf_Alloc(sizeof(int16_t) * g_RoomCount, GBUF_ROOM_INFOS);
+    m_Stamp = 0;
+}
+
+int32_t SpatialHash_FindItems(
+    int32_t x, int32_t y, int32_t z, int32_t radius, const int16_t **items)
+{
+    const int32_t room_count = SpatialHash_FindRooms(x, y, z, radius);
+    int32_t count = 0;
+    for (int i = 0; i < room_count; i++) {
+        for (int16_t item_num = g_RoomInfo[m_Rooms[i]].item_number;
+             item_num != NO_ITEM; item_num = g_Items[item_num].next_item) {
+            if (SpatialHash_IsInRadius(
+                    &g_Items[item_num].pos, x, y, z, radius)) {
+                m_Results[count++] = item_num;
+            }
+        }
+    }
+    *items = m_Results;
+    return count;
+}
+
+int32_t SpatialHash_FindEffects(
+    int32_t x, int32_t y, int32_t z, int32_t radius, const int16_t **effects)
+{
+    const int32_t room_count = SpatialHash_FindRooms(x, y, z, radius);
+    int32_t count = 0;
+    for (int i = 0; i < room_count; i++) {
+        for (int16_t fx_num = g_RoomInfo[m_Rooms[i]].fx_number;
+             fx_num != NO_ITEM; fx_num = g_Effects[fx_num].next_fx) {
+            if (SpatialHash_IsInRadius(
+                    &g_Effects[fx_num].pos, x, y, z, radius)) {
+                m_Results[count++] = fx_num;
+            }
+        }
+    }
+    *effects = m_Results;
+    return count;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+// A uniform grid over the level that lists the rooms reaching into each
+// cell, built when the level loads. The rooms never move, so the grid does
+// not need updating; the items and effects are found through the item and
+// effect lists of the rooms, which ItemNewRoom and EffectNewRoom already
+// keep up to date as things move around. A query only looks at the rooms
+// near the given point, so its cost depends on how crowded that part of the
+// level is rather than on how many items there are in total.
+
+// Builds the grid for the current level.
+void SpatialHash_Init();
+
+// Finds the items closer than radius to the given point. Returns their
+// number and sets items to a list of their item numbers that stays valid
+// until the next query.
+int32_t SpatialHash_FindItems(
+    int32_t x, int32_t y, int32_t z, int32_t radius, const int16_t **items);
+
+// Same as SpatialHash_FindItems, for the effects.
+int32_t SpatialHash_FindEffects(
+    int32_t x, int32_t y, int32_t z, int32_t radius, const int16_t **effects);
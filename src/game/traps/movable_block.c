@@ -1,5 +1,6 @@
 #include "game/traps/movable_block.h"
 
+#include "game/box_field.h"
 #include "game/collide.h"
 #include "game/control.h"
 #include "game/draw.h"
@@ -372,5 +373,6 @@ void AlterFloorHeight(ITEM_INFO *item, int32_t height)
         } else {
             g_Boxes[floor->box].overlap_index &= ~BLOCKED;
         }
+        BoxField_Invalidate();
     }
 }
@@ -0,0 +1,385 @@
+#include "game/visibility.h"
+
+#include "game/clock.h"
+#include "game/viewport.h"
+#include "global/types.h"
+#include "global/vars.h"
+#include "log.h"
+#include "memory.h"
+#include "util.h"
+
+#include <assert.h>
+#include <string.h>
+
+#define VISIBILITY_CAMERA_DELTA 4
+#define VISIBILITY_BOUNDS_MARGIN 16
+#define VISIBILITY_PVS_MAX_DEPTH 64
+// the number of doors that may be tested while working out the PVS of the
+// whole level
+#define VISIBILITY_PVS_BUDGET 4000000
+
+typedef struct VISIBILITY_ROOM {
+    int16_t room_num;
+    int16_t left;
+    int16_t right;
+    int16_t top;
+    int16_t bottom;
+} VISIBILITY_ROOM;
+
+// A door in world coordinates.
+typedef struct VISIBILITY_PORTAL {
+    int16_t room_num;
+    int32_t normal[3];
+    int32_t vertex[4][3];
+} VISIBILITY_PORTAL;
+
+typedef struct VISIBILITY_PVS_CONTEXT {
+    const VISIBILITY_PORTAL *portals;
+    const int32_t *room_portals;
+    const int16_t *flip_rooms;
+    const VISIBILITY_PORTAL *chain[VISIBILITY_PVS_MAX_DEPTH];
+    uint32_t *row;
+    int32_t budget;
+} VISIBILITY_PVS_CONTEXT;
+
+static int32_t m_RoomsToDrawCapacity = 0;
+
+static bool m_IsCacheValid = false;
+static int16_t m_CachedCurrentRoom = -1;
+static int32_t m_CachedFlipStatus = 0;
+static PHD_MATRIX m_CachedW2VMatrix = { 0 };
+static int32_t m_CachedPersp = 0;
+static int32_t m_CachedViewPort[4] = { 0 };
+static VISIBILITY_ROOM *m_CachedRooms = NULL;
+static int32_t m_CachedRoomCount = 0;
+static int32_t m_CachedRoomCapacity = 0;
+
+static uint32_t *m_PVS = NULL;
+static int32_t m_PVSRoomCount = 0;
+static int32_t m_PVSStride = 0;
+
+static void Visibility_GetViewPort(int32_t viewport[4]);
+static bool Visibility_IsCameraMatching(bool *is_exact);
+static int32_t Visibility_AddPortals(
+    VISIBILITY_PORTAL *portals, const ROOM_INFO *r);
+static bool Visibility_IsPortalBeyond(
+    const VISIBILITY_PORTAL *portal, const VISIBILITY_PORTAL *plane);
+static void Visibility_MarkRoom(
+    VISIBILITY_PVS_CONTEXT *ctx, int16_t room_num);
+static bool Visibility_TracePVS(
+    VISIBILITY_PVS_CONTEXT *ctx, int16_t room_num, int32_t depth);
+static void Visibility_MarkAllRooms(VISIBILITY_PVS_CONTEXT *ctx);
+
+static void Visibility_GetViewPort(int32_t viewport[4])
+{
+    viewport[0] = ViewPort_GetMinX();
+    viewport[1] = ViewPort_GetMinY();
+    viewport[2] = ViewPort_GetMaxX();
+    viewport[3] = ViewPort_GetMaxY();
+}
+
+static bool Visibility_IsCameraMatching(bool *is_exact)
+{
+    const PHD_MATRIX *old = &m_CachedW2VMatrix;
+    const PHD_MATRIX *new = &g_W2VMatrix;
+
+    // even the slightest rotation moves the far away portals by many pixels
+    if (old->_00 != new->_00 || old->_01 != new->_01 || old->_02 != new->_02
+        || old->_10 != new->_10 || old->_11 != new->_11
+        || old->_12 != new->_12 || old->_20 != new->_20
+        || old->_21 != new->_21 || old->_22 != new->_22) {
+        return false;
+    }
+
+    // the translation holds the camera position in the world
+    const int32_t dx = ABS(new->_03 - old->_03);
+    const int32_t dy = ABS(new->_13 - old->_13);
+    const int32_t dz = ABS(new->_23 - old->_23);
+    if (dx > VISIBILITY_CAMERA_DELTA || dy > VISIBILITY_CAMERA_DELTA
+        || dz > VISIBILITY_CAMERA_DELTA) {
+        return false;
+    }
+
+    *is_exact = !dx && !dy && !dz;
+    return true;
+}
+
+static int32_t Visibility_AddPortals(
+    VISIBILITY_PORTAL *portals, const ROOM_INFO *r)
+{
+    if (!r->doors) {
+        return 0;
+    }
+
+    for (int i = 0; i < r->doors->count; i++) {
+        const DOOR_INFO *door = &r->doors->door[i];
+        VISIBILITY_PORTAL *portal = &portals[i];
+        portal->room_num = door->room_num;
+        portal->normal[0] = door->x;
+        portal->normal[1] = door->y;
+        portal->normal[2] = door->z;
+        for (int j = 0; j < 4; j++) {
+            portal->vertex[j][0] = r->x + door->vertex[j].x;
+            portal->vertex[j][1] = r->y + door->vertex[j].y;
+            portal->vertex[j][2] = r->z + door->vertex[j].z;
+        }
+    }
+    return r->doors->count;
+}
+
+static bool Visibility_IsPortalBeyond(
+    const VISIBILITY_PORTAL *portal, const VISIBILITY_PORTAL *plane)
+{
+    // the door normals point back towards the room the camera looks from,
+    // so a line of sight that went through the plane portal stays on its
+    // negative side and can only go on through the part of the portal
+    // that lies there
+    for (int i = 0; i < 4; i++) {
+        int64_t dist = 0;
+        for (int j = 0; j < 3; j++) {
+            dist += (int64_t)plane->normal[j]
+                * (portal->vertex[i][j] - plane->vertex[0][j]);
+        }
+        if (dist < 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void Visibility_MarkRoom(VISIBILITY_PVS_CONTEXT *ctx, int16_t room_num)
+{
+    ctx->row[room_num / 32] |= 1u << (room_num % 32);
+    const int16_t flip_room = ctx->flip_rooms[room_num];
+    if (flip_room != -1) {
+        ctx->row[flip_room / 32] |= 1u << (flip_room % 32);
+    }
+}
+
+static bool Visibility_TracePVS(
+    VISIBILITY_PVS_CONTEXT *ctx, int16_t room_num, int32_t depth)
+{
+    if (depth >= VISIBILITY_PVS_MAX_DEPTH) {
+        return false;
+    }
+
+    for (int i = ctx->room_portals[room_num];
+         i < ctx->room_portals[room_num + 1]; i++) {
+        if (--ctx->budget < 0) {
+            return false;
+        }
+
+        // every door on the way must be at least partly beyond all of the
+        // doors passed before it; this also stops the same door from being
+        // passed twice
+        const VISIBILITY_PORTAL *portal = &ctx->portals[i];
+        bool is_visible = true;
+        for (int j = 0; j < depth; j++) {
+            if (!Visibility_IsPortalBeyond(portal, ctx->chain[j])) {
+                is_visible = false;
+                break;
+            }
+        }
+        if (!is_visible) {
+            continue;
+        }
+
+        Visibility_MarkRoom(ctx, portal->room_num);
+        ctx->chain[depth] = portal;
+        if (!Visibility_TracePVS(ctx, portal->room_num, depth + 1)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void Visibility_MarkAllRooms(VISIBILITY_PVS_CONTEXT *ctx)
+{
+    for (int i = 0; i < g_RoomCount; i++) {
+        ctx->row[i / 32] |= 1u << (i % 32);
+    }
+}
+
+void Visibility_ClearRoomsToDraw()
+{
+    g_RoomsToDrawCount = 0;
+}
+
+void Visibility_AddRoomToDraw(int16_t room_num)
+{
+    if (g_RoomsToDrawCount + 1 > m_RoomsToDrawCapacity) {
+        m_RoomsToDrawCapacity += 64;
+        g_RoomsToDraw = Memory_Realloc(
+            g_RoomsToDraw, m_RoomsToDrawCapacity * sizeof(int16_t));
+    }
+    g_RoomsToDraw[g_RoomsToDrawCount++] = room_num;
+}
+
+void Visibility_Invalidate()
+{
+    m_IsCacheValid = false;
+}
+
+bool Visibility_RestoreRooms(int16_t current_room)
+{
+    if (!m_IsCacheValid || current_room != m_CachedCurrentRoom
+        || g_FlipStatus != m_CachedFlipStatus || g_PhdPersp != m_CachedPersp) {
+        return false;
+    }
+
+    int32_t viewport[4];
+    Visibility_GetViewPort(viewport);
+    for (int i = 0; i < 4; i++) {
+        if (viewport[i] != m_CachedViewPort[i]) {
+            return false;
+        }
+    }
+
+    bool is_exact;
+    if (!Visibility_IsCameraMatching(&is_exact)) {
+        return false;
+    }
+
+    // after a small camera move the portals might have shifted a little,
+    // so the bounds are widened to not cut off anything that is visible
+    const int32_t margin = is_exact ? 0 : VISIBILITY_BOUNDS_MARGIN;
+
+    Visibility_ClearRoomsToDraw();
+    for (int i = 0; i < m_CachedRoomCount; i++) {
+        const VISIBILITY_ROOM *cached = &m_CachedRooms[i];
+        ROOM_INFO *r = &g_RoomInfo[cached->room_num];
+        r->left = MAX(cached->left - margin, viewport[0]);
+        r->top = MAX(cached->top - margin, viewport[1]);
+        r->right = MIN(cached->right + margin, viewport[2]);
+        r->bottom = MIN(cached->bottom + margin, viewport[3]);
+        r->bound_active = 1;
+        Visibility_AddRoomToDraw(cached->room_num);
+    }
+
+    return true;
+}
+
+void Visibility_StoreRooms(int16_t current_room)
+{
+    if (g_RoomsToDrawCount > m_CachedRoomCapacity) {
+        m_CachedRoomCapacity = g_RoomsToDrawCount;
+        m_CachedRooms = Memory_Realloc(
+            m_CachedRooms, m_CachedRoomCapacity * sizeof(VISIBILITY_ROOM));
+    }
+
+    m_CachedRoomCount = g_RoomsToDrawCount;
+    for (int i = 0; i < g_RoomsToDrawCount; i++) {
+        const ROOM_INFO *r = &g_RoomInfo[g_RoomsToDraw[i]];
+        VISIBILITY_ROOM *cached = &m_CachedRooms[i];
+        cached->room_num = g_RoomsToDraw[i];
+        cached->left = r->left;
+        cached->right = r->right;
+        cached->top = r->top;
+        cached->bottom = r->bottom;
+    }
+
+    m_CachedCurrentRoom = current_room;
+    m_CachedFlipStatus = g_FlipStatus;
+    m_CachedW2VMatrix = g_W2VMatrix;
+    m_CachedPersp = g_PhdPersp;
+    Visibility_GetViewPort(m_CachedViewPort);
+    m_IsCacheValid = true;
+}
+
+void Visibility_ComputePVS()
+{
+    const int32_t start_time = Clock_GetMS();
+
+    Memory_FreePointer(&m_PVS);
+    m_PVSRoomCount = g_RoomCount;
+    m_PVSStride = (g_RoomCount + 31) / 32;
+    m_PVS = Memory_Alloc(g_RoomCount * m_PVSStride * sizeof(uint32_t));
+
+    // flipping swaps the contents of two rooms, so their doors are followed
+    // together and seeing either of them means seeing both
+    int16_t *flip_rooms = Memory_Alloc(g_RoomCount * sizeof(int16_t));
+    for (int i = 0; i < g_RoomCount; i++) {
+        flip_rooms[i] = -1;
+    }
+    for (int i = 0; i < g_RoomCount; i++) {
+        const int16_t flip_room = g_RoomInfo[i].flipped_room;
+        if (flip_room >= 0 && flip_room < g_RoomCount) {
+            flip_rooms[i] = flip_room;
+            flip_rooms[flip_room] = i;
+        }
+    }
+
+    int32_t portal_count = 0;
+    for (int i = 0; i < g_RoomCount; i++) {
+        if (g_RoomInfo[i].doors) {
+            portal_count += g_RoomInfo[i].doors->count;
+        }
+    }
+    portal_count *= 2;
+
+    VISIBILITY_PORTAL *portals =
+        Memory_Alloc(MAX(portal_count, 1) * sizeof(VISIBILITY_PORTAL));
+    int32_t *room_portals = Memory_Alloc((g_RoomCount + 1) * sizeof(int32_t));
+    int32_t count = 0;
+    for (int i = 0; i < g_RoomCount; i++) {
+        room_portals[i] = count;
+        count += Visibility_AddPortals(&portals[count], &g_RoomInfo[i]);
+        if (flip_rooms[i] != -1) {
+            count += Visibility_AddPortals(
+                &portals[count], &g_RoomInfo[flip_rooms[i]]);
+        }
+    }
+    room_portals[g_RoomCount] = count;
+    assert(count <= portal_count);
+
+    VISIBILITY_PVS_CONTEXT ctx = {
+        .portals = portals,
+        .room_portals = room_portals,
+        .flip_rooms = flip_rooms,
+    };
+
+    // each room gets an even share of what is left of the budget, so the
+    // rooms that need less leave more for the rest
+    int32_t budget = VISIBILITY_PVS_BUDGET;
+    int32_t fallback_count = 0;
+    int32_t visible_count = 0;
+    for (int i = 0; i < g_RoomCount; i++) {
+        ctx.row = &m_PVS[i * m_PVSStride];
+        ctx.budget = budget / (g_RoomCount - i);
+        budget -= ctx.budget;
+        Visibility_MarkRoom(&ctx, i);
+        if (!Visibility_TracePVS(&ctx, i, 0)) {
+            // too many door chains to follow, so rather than keep what was
+            // found so far, treat every room as visible
+            Visibility_MarkAllRooms(&ctx);
+            fallback_count++;
+        } else {
+            budget += ctx.budget;
+        }
+
+        for (int j = 0; j < m_PVSStride; j++) {
+            visible_count += __builtin_popcount(ctx.row[j]);
+        }
+    }
+
+    Memory_FreePointer(&room_portals);
+    Memory_FreePointer(&portals);
+    Memory_FreePointer(&flip_rooms);
+
+    LOG_INFO(
+        "computed PVS for %d rooms in %d ms, %d rooms visible on average, "
+        "%d rooms over budget",
+        g_RoomCount, Clock_GetMS() - start_time,
+        g_RoomCount ? visible_count / g_RoomCount : 0, fallback_count);
+}
+
+bool Visibility_IsRoomPotentiallyVisible(int16_t from_room, int16_t to_room)
+{
+    if (!m_PVS || from_room < 0 || from_room >= m_PVSRoomCount || to_room < 0
+        || to_room >= m_PVSRoomCount) {
+        return true;
+    }
+    const uint32_t *row = &m_PVS[from_room * m_PVSStride];
+    return row[to_room / 32] & (1u << (to_room % 32));
+}
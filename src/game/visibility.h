@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// The list of rooms to draw grows as needed, so it is no longer capped.
+void Visibility_ClearRoomsToDraw();
+void Visibility_AddRoomToDraw(int16_t room_num);
+
+// Makes the next frame run the portal traversal again. Needs to be called
+// whenever the rooms are reloaded.
+void Visibility_Invalidate();
+
+// Fills the list of rooms to draw along with their screen bounds from the
+// last traversal, as long as the camera did not move since then by more than
+// a few units. Returns false if the portals need to be traversed again.
+bool Visibility_RestoreRooms(int16_t current_room);
+
+// Remembers the rooms to draw and their screen bounds after a traversal.
+void Visibility_StoreRooms(int16_t current_room);
+
+// Works out which rooms can possibly be seen from each room by following the
+// chains of doors. Needs to be called after the rooms are loaded.
+void Visibility_ComputePVS();
+
+// Returns false if no part of the room can be seen from the other room, no
+// matter where the camera is.
+bool Visibility_IsRoomPotentiallyVisible(int16_t from_room, int16_t to_room);
@@ -3,16 +3,49 @@
 #include "config.h"
 #include "gfx/context.h"
 #include "gfx/gl/utils.h"
+#include "log.h"
+#include "memory.h"
 
 #include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+// negate Z axis so the model is rendered behind the viewport, which is
+// better than having a negative z_near in the ortho matrix, which seems
+// to mess up depth testing
+static const GLfloat m_ModelView[4][4] = {
+    { +1.0f, +0.0f, +0.0f, +0.0f },
+    { +0.0f, +1.0f, +0.0f, +0.0f },
+    { +0.0f, +0.0f, -1.0f, +0.0f },
+    { +0.0f, +0.0f, +0.0f, +1.0f },
+};
 
 static void GFX_3D_Renderer_SelectTextureImpl(
     GFX_3D_Renderer *renderer, int texture_num);
+static bool GFX_3D_Renderer_IsSameState(
+    const GFX_3D_RenderState *a, const GFX_3D_RenderState *b);
+static void GFX_3D_Renderer_ApplyState(
+    GFX_3D_Renderer *renderer, const GFX_3D_RenderState *state);
+static void GFX_3D_Renderer_ChangeState(
+    GFX_3D_Renderer *renderer, const GFX_3D_RenderState *state);
+static void GFX_3D_Renderer_BeginBatch(GFX_3D_Renderer *renderer);
+static void GFX_3D_Renderer_EndBatch(GFX_3D_Renderer *renderer);
+static int GFX_3D_Renderer_CompareBatches(const void *a, const void *b);
 
 static void GFX_3D_Renderer_SelectTextureImpl(
     GFX_3D_Renderer *renderer, int texture_num)
 {
     assert(renderer);
+    if (texture_num == GFX_TEXTURE_ARRAY) {
+        // the array texture lives on its own texture unit, so that the
+        // regular textures bound to the first unit stay untouched
+        assert(renderer->texture_array);
+        glActiveTexture(GL_TEXTURE1);
+        GFX_GL_Texture_Bind(renderer->texture_array);
+        glActiveTexture(GL_TEXTURE0);
+        return;
+    }
+
     if (texture_num == GFX_NO_TEXTURE) {
         glBindTexture(GL_TEXTURE_2D, 0);
         return;
@@ -25,18 +58,167 @@ static void GFX_3D_Renderer_SelectTextureImpl(
     GFX_GL_Texture_Bind(texture);
 }
 
+static bool GFX_3D_Renderer_IsSameState(
+    const GFX_3D_RenderState *a, const GFX_3D_RenderState *b)
+{
+    return a->texture_num == b->texture_num
+        && a->texturing_enabled == b->texturing_enabled
+        && a->blending_enabled == b->blending_enabled
+        && a->prim_type == b->prim_type;
+}
+
+static void GFX_3D_Renderer_ApplyState(
+    GFX_3D_Renderer *renderer, const GFX_3D_RenderState *state)
+{
+    const GFX_3D_RenderState *applied = &renderer->applied_state;
+    const bool force = !renderer->is_applied_state_valid;
+
+    if (force || state->texturing_enabled != applied->texturing_enabled) {
+        GFX_GL_Program_Uniform1i(
+            &renderer->program, renderer->loc_texturing_enabled,
+            state->texturing_enabled);
+    }
+
+    if (state->texturing_enabled
+        && (force || state->texture_num != applied->texture_num)) {
+        GFX_GL_Program_Uniform1i(
+            &renderer->program, renderer->loc_texture_array_enabled,
+            state->texture_num == GFX_TEXTURE_ARRAY);
+        GFX_3D_Renderer_SelectTextureImpl(renderer, state->texture_num);
+    }
+
+    if (force || state->blending_enabled != applied->blending_enabled) {
+        if (state->blending_enabled) {
+            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        } else {
+            glBlendFunc(GL_ONE, GL_ZERO);
+        }
+    }
+
+    renderer->applied_state = *state;
+    renderer->is_applied_state_valid = true;
+}
+
+static void GFX_3D_Renderer_ChangeState(
+    GFX_3D_Renderer *renderer, const GFX_3D_RenderState *state)
+{
+    if (GFX_3D_Renderer_IsSameState(&renderer->state, state)) {
+        return;
+    }
+
+    // without batching, every state change submits what has been pushed so
+    // far, exactly like the original renderer did
+    if (!renderer->batching) {
+        GFX_3D_Renderer_Flush(renderer);
+    }
+
+    renderer->state = *state;
+}
+
+static void GFX_3D_Renderer_BeginBatch(GFX_3D_Renderer *renderer)
+{
+    GFX_3D_RenderState state = renderer->state;
+    if (!state.texturing_enabled) {
+        // the bound texture does not matter for untextured primitives
+        state.texture_num = GFX_NO_TEXTURE;
+    }
+
+    if (renderer->batches.count) {
+        GFX_3D_Batch *batch =
+            &renderer->batches.data[renderer->batches.count - 1];
+        if (GFX_3D_Renderer_IsSameState(&batch->state, &state)) {
+            return;
+        }
+    }
+
+    if (renderer->batches.count + 1 > renderer->batches.capacity) {
+        renderer->batches.capacity += 256;
+        renderer->batches.data = Memory_Realloc(
+            renderer->batches.data,
+            renderer->batches.capacity * sizeof(GFX_3D_Batch));
+        renderer->batches.ranges = Memory_Realloc(
+            renderer->batches.ranges,
+            renderer->batches.capacity * sizeof(GFX_3D_IndexRange));
+    }
+
+    GFX_3D_Batch *batch = &renderer->batches.data[renderer->batches.count];
+    batch->state = state;
+    batch->range.start =
+        GFX_3D_VertexStream_GetPendingIndexCount(&renderer->vertex_stream);
+    batch->range.count = 0;
+    batch->draw_list = renderer->batches.draw_list;
+    batch->seq = renderer->batches.count;
+    renderer->batches.count++;
+}
+
+static void GFX_3D_Renderer_EndBatch(GFX_3D_Renderer *renderer)
+{
+    assert(renderer->batches.count);
+    GFX_3D_Batch *batch = &renderer->batches.data[renderer->batches.count - 1];
+    batch->range.count =
+        GFX_3D_VertexStream_GetPendingIndexCount(&renderer->vertex_stream)
+        - batch->range.start;
+}
+
+static int GFX_3D_Renderer_CompareBatches(const void *a, const void *b)
+{
+    const GFX_3D_Batch *batch_a = a;
+    const GFX_3D_Batch *batch_b = b;
+    const GFX_3D_RenderState *state_a = &batch_a->state;
+    const GFX_3D_RenderState *state_b = &batch_b->state;
+
+    // opaque primitives go first; translucent primitives are drawn on top of
+    // them in the order they were submitted
+    if (state_a->blending_enabled != state_b->blending_enabled) {
+        return state_a->blending_enabled ? 1 : -1;
+    }
+
+    if (!state_a->blending_enabled) {
+        // on a depth tie the primitive drawn last wins, so the meshes keep
+        // their order and only the faces of each mesh are sorted by state
+        if (batch_a->draw_list != batch_b->draw_list) {
+            return batch_a->draw_list - batch_b->draw_list;
+        }
+        if (state_a->prim_type != state_b->prim_type) {
+            return state_a->prim_type - state_b->prim_type;
+        }
+        if (state_a->texturing_enabled != state_b->texturing_enabled) {
+            return state_a->texturing_enabled - state_b->texturing_enabled;
+        }
+        if (state_a->texture_num != state_b->texture_num) {
+            return state_a->texture_num - state_b->texture_num;
+        }
+    }
+
+    return batch_a->seq - batch_b->seq;
+}
+
 void GFX_3D_Renderer_Init(GFX_3D_Renderer *renderer)
 {
     assert(renderer);
     // TODO: make me configurable
     renderer->wireframe = false;
-    renderer->selected_texture_num = GFX_NO_TEXTURE;
+    renderer->batching = false;
     for (int i = 0; i < GFX_MAX_TEXTURES; i++) {
         renderer->textures[i] = NULL;
     }
+    renderer->texture_array = NULL;
+
+    renderer->state.texture_num = GFX_NO_TEXTURE;
+    renderer->state.texturing_enabled = false;
+    renderer->state.blending_enabled = false;
+    renderer->state.prim_type = GFX_3D_PRIM_TRI;
+    renderer->is_applied_state_valid = false;
+
+    renderer->batches.data = NULL;
+    renderer->batches.ranges = NULL;
+    renderer->batches.count = 0;
+    renderer->batches.capacity = 0;
+    renderer->batches.draw_list = 0;
 
     GFX_GL_Sampler_Init(&renderer->sampler);
     GFX_GL_Sampler_Bind(&renderer->sampler, 0);
+    GFX_GL_Sampler_Bind(&renderer->sampler, 1);
     GFX_GL_Sampler_Parameterf(
         &renderer->sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT,
         g_Config.rendering.anisotropy_filter);
@@ -56,24 +238,25 @@ void GFX_3D_Renderer_Init(GFX_3D_Renderer *renderer)
         GFX_GL_Program_UniformLocation(&renderer->program, "texturingEnabled");
     renderer->loc_smoothing_enabled =
         GFX_GL_Program_UniformLocation(&renderer->program, "smoothingEnabled");
+    renderer->loc_texture_array_enabled = GFX_GL_Program_UniformLocation(
+        &renderer->program, "textureArrayEnabled");
 
     GFX_GL_Program_FragmentData(&renderer->program, "fragColor");
     GFX_GL_Program_Bind(&renderer->program);
 
-    // negate Z axis so the model is rendered behind the viewport, which is
-    // better than having a negative z_near in the ortho matrix, which seems
-    // to mess up depth testing
-    GLfloat model_view[4][4] = {
-        { +1.0f, +0.0f, +0.0f, +0.0f },
-        { +0.0f, +1.0f, +0.0f, +0.0f },
-        { +0.0f, +0.0f, -1.0f, +0.0f },
-        { +0.0f, +0.0f, +0.0f, +1.0f },
-    };
+    GFX_GL_Program_Uniform1i(
+        &renderer->program,
+        GFX_GL_Program_UniformLocation(&renderer->program, "tex0"), 0);
+    GFX_GL_Program_Uniform1i(
+        &renderer->program,
+        GFX_GL_Program_UniformLocation(&renderer->program, "texArray"), 1);
+
     GFX_GL_Program_UniformMatrix4fv(
         &renderer->program, renderer->loc_mat_model_view, 1, GL_FALSE,
-        &model_view[0][0]);
+        &m_ModelView[0][0]);
 
     GFX_3D_VertexStream_Init(&renderer->vertex_stream);
+    GFX_3D_RoomCache_Init(&renderer->room_cache);
 
     GFX_GL_CheckError();
 }
@@ -81,9 +264,14 @@ void GFX_3D_Renderer_Init(GFX_3D_Renderer *renderer)
 void GFX_3D_Renderer_Close(GFX_3D_Renderer *renderer)
 {
     assert(renderer);
+    GFX_3D_Renderer_TextureArrayUnreg(renderer);
+    GFX_3D_RoomCache_Close(&renderer->room_cache);
     GFX_3D_VertexStream_Close(&renderer->vertex_stream);
     GFX_GL_Program_Close(&renderer->program);
     GFX_GL_Sampler_Close(&renderer->sampler);
+
+    Memory_FreePointer(&renderer->batches.data);
+    Memory_FreePointer(&renderer->batches.ranges);
 }
 
 void GFX_3D_Renderer_RenderBegin(GFX_3D_Renderer *renderer)
@@ -95,11 +283,12 @@ void GFX_3D_Renderer_RenderBegin(GFX_3D_Renderer *renderer)
         glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     }
 
-    GFX_GL_Program_Bind(&renderer->program);
     GFX_3D_VertexStream_Bind(&renderer->vertex_stream);
     GFX_GL_Sampler_Bind(&renderer->sampler, 0);
+    GFX_GL_Sampler_Bind(&renderer->sampler, 1);
 
-    GFX_3D_Renderer_RestoreTexture(renderer);
+    // other renderers might have changed the GL state in the meantime
+    renderer->is_applied_state_valid = false;
 
     const float left = 0.0f;
     const float top = 0.0f;
@@ -115,6 +304,10 @@ void GFX_3D_Renderer_RenderBegin(GFX_3D_Renderer *renderer)
           -(z_far + z_near) / (z_far - z_near), 1.0f }
     };
 
+    GFX_3D_RoomCache_SetMatrices(
+        &renderer->room_cache, &projection[0][0], &m_ModelView[0][0]);
+
+    GFX_GL_Program_Bind(&renderer->program);
     GFX_GL_Program_UniformMatrix4fv(
         &renderer->program, renderer->loc_mat_projection, 1, GL_FALSE,
         &projection[0][0]);
@@ -129,7 +322,7 @@ void GFX_3D_Renderer_RenderBegin(GFX_3D_Renderer *renderer)
 void GFX_3D_Renderer_RenderEnd(GFX_3D_Renderer *renderer)
 {
     assert(renderer);
-    GFX_3D_VertexStream_RenderPending(&renderer->vertex_stream);
+    GFX_3D_Renderer_Flush(renderer);
 
     if (renderer->wireframe) {
         glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
@@ -138,6 +331,22 @@ void GFX_3D_Renderer_RenderEnd(GFX_3D_Renderer *renderer)
     GFX_GL_CheckError();
 }
 
+void GFX_3D_Renderer_EndFrame(GFX_3D_Renderer *renderer)
+{
+    assert(renderer);
+    GFX_3D_VertexStream_EndFrame(&renderer->vertex_stream);
+    GFX_3D_RoomCache_EndFrame(&renderer->room_cache);
+}
+
+void GFX_3D_Renderer_GetStreamStats(
+    GFX_3D_Renderer *renderer, GFX_3D_VertexStreamStats *stats)
+{
+    assert(renderer);
+    assert(stats);
+    GFX_3D_VertexStream_GetStats(&renderer->vertex_stream, stats);
+    stats->draw_calls += renderer->room_cache.last_frame_draw_calls;
+}
+
 int GFX_3D_Renderer_TextureReg(
     GFX_3D_Renderer *renderer, const void *data, int width, int height)
 {
@@ -174,10 +383,14 @@ bool GFX_3D_Renderer_TextureUnreg(GFX_3D_Renderer *renderer, int texture_num)
         return false;
     }
 
+    // the pending primitives might still refer to the texture
+    GFX_3D_Renderer_Flush(renderer);
+
     // unbind texture if currently bound
-    if (texture_num == renderer->selected_texture_num) {
+    if (texture_num == renderer->state.texture_num) {
         GFX_3D_Renderer_SelectTextureImpl(renderer, GFX_NO_TEXTURE);
-        renderer->selected_texture_num = GFX_NO_TEXTURE;
+        renderer->state.texture_num = GFX_NO_TEXTURE;
+        renderer->is_applied_state_valid = false;
     }
 
     GFX_GL_Texture_Free(texture);
@@ -185,14 +398,135 @@ bool GFX_3D_Renderer_TextureUnreg(GFX_3D_Renderer *renderer, int texture_num)
     return true;
 }
 
+bool GFX_3D_Renderer_TextureArrayReg(
+    GFX_3D_Renderer *renderer, const void *data, int width, int height,
+    int layers)
+{
+    assert(renderer);
+    assert(data);
+
+    GLint max_layers;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers);
+    if (layers > max_layers) {
+        LOG_ERROR(
+            "Too many texture pages for an array texture: %d (max %d)", layers,
+            max_layers);
+        return false;
+    }
+
+    GFX_3D_Renderer_TextureArrayUnreg(renderer);
+
+    glActiveTexture(GL_TEXTURE1);
+    renderer->texture_array = GFX_GL_Texture_Create(GL_TEXTURE_2D_ARRAY);
+    GFX_GL_Texture_LoadArray(
+        renderer->texture_array, data, width, height, layers);
+    glActiveTexture(GL_TEXTURE0);
+
+    GFX_GL_CheckError();
+    return true;
+}
+
+void GFX_3D_Renderer_TextureArrayUpdate(
+    GFX_3D_Renderer *renderer, const void *data, int width, int height,
+    int first_layer, int layer_count)
+{
+    assert(renderer);
+    assert(data);
+    assert(renderer->texture_array);
+
+    // the pending primitives must be drawn with the old contents
+    GFX_3D_Renderer_Flush(renderer);
+
+    glActiveTexture(GL_TEXTURE1);
+    GFX_GL_Texture_LoadArrayLayers(
+        renderer->texture_array, data, width, height, first_layer,
+        layer_count);
+    glActiveTexture(GL_TEXTURE0);
+
+    GFX_GL_CheckError();
+}
+
+void GFX_3D_Renderer_TextureArrayUnreg(GFX_3D_Renderer *renderer)
+{
+    assert(renderer);
+    if (!renderer->texture_array) {
+        return;
+    }
+
+    // the pending primitives might still refer to the texture
+    GFX_3D_Renderer_Flush(renderer);
+
+    if (renderer->state.texture_num == GFX_TEXTURE_ARRAY) {
+        renderer->state.texture_num = GFX_NO_TEXTURE;
+    }
+    renderer->is_applied_state_valid = false;
+
+    GFX_GL_Texture_Free(renderer->texture_array);
+    renderer->texture_array = NULL;
+
+    GFX_3D_RoomCache_Unload(&renderer->room_cache);
+}
+
+void GFX_3D_Renderer_RoomCacheReg(
+    GFX_3D_Renderer *renderer, const GFX_3D_RoomVertex *vertices,
+    size_t vertex_count, const GLuint *indices, size_t index_count,
+    const GFX_3D_IndexRange *rooms, int room_count, const int32_t *wibble_table,
+    const int32_t *shade_table)
+{
+    assert(renderer);
+    assert(renderer->texture_array);
+    GFX_3D_RoomCache_Load(
+        &renderer->room_cache, vertices, vertex_count, indices, index_count,
+        rooms, room_count, wibble_table, shade_table);
+    GFX_GL_Program_Bind(&renderer->program);
+}
+
+void GFX_3D_Renderer_RoomCacheUnreg(GFX_3D_Renderer *renderer)
+{
+    assert(renderer);
+    GFX_3D_RoomCache_Unload(&renderer->room_cache);
+}
+
+void GFX_3D_Renderer_DrawRoom(
+    GFX_3D_Renderer *renderer, int room_num, const GFX_3D_RoomParams *params)
+{
+    assert(renderer);
+    GFX_Context_SetRendered();
+
+    // the rooms are opaque and depth tested, so they do not need to wait for
+    // the batched primitives; they only need the array texture to be bound
+    GFX_3D_Renderer_SelectTextureImpl(renderer, GFX_TEXTURE_ARRAY);
+    GFX_3D_RoomCache_Draw(&renderer->room_cache, room_num, params);
+    GFX_GL_Program_Bind(&renderer->program);
+}
+
+void GFX_3D_Renderer_BeginDrawList(GFX_3D_Renderer *renderer)
+{
+    assert(renderer);
+    renderer->batches.draw_list++;
+}
+
 void GFX_3D_Renderer_RenderPrimStrip(
     GFX_3D_Renderer *renderer, GFX_3D_Vertex *vertices, int count)
 {
     assert(renderer);
     assert(vertices);
     GFX_Context_SetRendered();
+    GFX_3D_Renderer_BeginBatch(renderer);
     GFX_3D_VertexStream_PushPrimStrip(
         &renderer->vertex_stream, vertices, count);
+    GFX_3D_Renderer_EndBatch(renderer);
+}
+
+void GFX_3D_Renderer_RenderPrimFan(
+    GFX_3D_Renderer *renderer, GFX_3D_Vertex *vertices, int count)
+{
+    assert(renderer);
+    assert(vertices);
+    GFX_Context_SetRendered();
+    GFX_3D_Renderer_BeginBatch(renderer);
+    GFX_3D_VertexStream_PushPrimFan(&renderer->vertex_stream, vertices, count);
+    GFX_3D_Renderer_EndBatch(renderer);
 }
 
 void GFX_3D_Renderer_RenderPrimList(
@@ -201,28 +535,47 @@ void GFX_3D_Renderer_RenderPrimList(
     assert(renderer);
     assert(vertices);
     GFX_Context_SetRendered();
+    GFX_3D_Renderer_BeginBatch(renderer);
     GFX_3D_VertexStream_PushPrimList(&renderer->vertex_stream, vertices, count);
+    GFX_3D_Renderer_EndBatch(renderer);
 }
 
 void GFX_3D_Renderer_SelectTexture(GFX_3D_Renderer *renderer, int texture_num)
 {
     assert(renderer);
-    GFX_3D_VertexStream_RenderPending(&renderer->vertex_stream);
-    renderer->selected_texture_num = texture_num;
-    GFX_3D_Renderer_SelectTextureImpl(renderer, texture_num);
+    GFX_3D_RenderState state = renderer->state;
+    state.texture_num = texture_num;
+    GFX_3D_Renderer_ChangeState(renderer, &state);
+}
+
+void GFX_3D_Renderer_SelectTextureLayer(GFX_3D_Renderer *renderer, int layer)
+{
+    assert(renderer);
+    assert(renderer->texture_array);
+    // the layer is a part of the vertex data, so unlike switching between
+    // regular textures this does not break the current batch
+    GFX_3D_RenderState state = renderer->state;
+    state.texture_num = GFX_TEXTURE_ARRAY;
+    GFX_3D_Renderer_ChangeState(renderer, &state);
+    GFX_3D_VertexStream_SetTextureLayer(&renderer->vertex_stream, layer);
 }
 
 void GFX_3D_Renderer_RestoreTexture(GFX_3D_Renderer *renderer)
 {
     assert(renderer);
-    GFX_3D_Renderer_SelectTextureImpl(renderer, renderer->selected_texture_num);
+    GFX_3D_Renderer_SelectTextureImpl(
+        renderer,
+        renderer->is_applied_state_valid ? renderer->applied_state.texture_num
+                                         : renderer->state.texture_num);
 }
 
 void GFX_3D_Renderer_SetPrimType(
     GFX_3D_Renderer *renderer, GFX_3D_PrimType value)
 {
     assert(renderer);
-    GFX_3D_VertexStream_RenderPending(&renderer->vertex_stream);
+    GFX_3D_RenderState state = renderer->state;
+    state.prim_type = value;
+    GFX_3D_Renderer_ChangeState(renderer, &state);
     GFX_3D_VertexStream_SetPrimType(&renderer->vertex_stream, value);
 }
 
@@ -230,7 +583,9 @@ void GFX_3D_Renderer_SetSmoothingEnabled(
     GFX_3D_Renderer *renderer, bool is_enabled)
 {
     assert(renderer);
-    GFX_3D_VertexStream_RenderPending(&renderer->vertex_stream);
+    GFX_3D_Renderer_Flush(renderer);
+    GFX_3D_RoomCache_SetSmoothingEnabled(&renderer->room_cache, is_enabled);
+    GFX_GL_Program_Bind(&renderer->program);
     GFX_GL_Sampler_Parameteri(
         &renderer->sampler, GL_TEXTURE_MAG_FILTER,
         is_enabled ? GL_LINEAR : GL_NEAREST);
@@ -245,21 +600,73 @@ void GFX_3D_Renderer_SetBlendingEnabled(
     GFX_3D_Renderer *renderer, bool is_enabled)
 {
     assert(renderer);
-    GFX_3D_VertexStream_RenderPending(&renderer->vertex_stream);
-    if (is_enabled) {
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    } else {
-        glBlendFunc(GL_ONE, GL_ZERO);
-    }
+    GFX_3D_RenderState state = renderer->state;
+    state.blending_enabled = is_enabled;
+    GFX_3D_Renderer_ChangeState(renderer, &state);
 }
 
 void GFX_3D_Renderer_SetTexturingEnabled(
     GFX_3D_Renderer *renderer, bool is_enabled)
 {
     assert(renderer);
-    GFX_3D_VertexStream_RenderPending(&renderer->vertex_stream);
-    GFX_GL_Program_Uniform1i(
-        &renderer->program, renderer->loc_texturing_enabled, is_enabled);
+    GFX_3D_RenderState state = renderer->state;
+    state.texturing_enabled = is_enabled;
+    GFX_3D_Renderer_ChangeState(renderer, &state);
+}
+
+void GFX_3D_Renderer_SetBatchingEnabled(
+    GFX_3D_Renderer *renderer, bool is_enabled)
+{
+    assert(renderer);
+    GFX_3D_Renderer_Flush(renderer);
+    renderer->batching = is_enabled;
+}
+
+void GFX_3D_Renderer_Flush(GFX_3D_Renderer *renderer)
+{
+    assert(renderer);
+    if (!renderer->batches.count) {
+        return;
+    }
+
+    if (renderer->batching) {
+        qsort(
+            renderer->batches.data, renderer->batches.count,
+            sizeof(GFX_3D_Batch), GFX_3D_Renderer_CompareBatches);
+        for (int i = 0; i < renderer->batches.count; i++) {
+            renderer->batches.ranges[i] = renderer->batches.data[i].range;
+        }
+        GFX_3D_VertexStream_ReorderPending(
+            &renderer->vertex_stream, renderer->batches.ranges,
+            renderer->batches.count);
+    }
+
+    if (GFX_3D_VertexStream_UploadPending(&renderer->vertex_stream)) {
+        // the batches are contiguous now, so the ones sharing the same state
+        // can be merged into a single draw call
+        size_t first = 0;
+        int i = 0;
+        while (i < renderer->batches.count) {
+            const GFX_3D_RenderState *state = &renderer->batches.data[i].state;
+            size_t count = 0;
+            while (i < renderer->batches.count
+                   && GFX_3D_Renderer_IsSameState(
+                       state, &renderer->batches.data[i].state)) {
+                count += renderer->batches.data[i].range.count;
+                i++;
+            }
+
+            if (count) {
+                GFX_3D_Renderer_ApplyState(renderer, state);
+                GFX_3D_VertexStream_Draw(
+                    &renderer->vertex_stream, state->prim_type, first, count);
+            }
+            first += count;
+        }
+    }
+
+    renderer->batches.count = 0;
+    renderer->batches.draw_list = 0;
 }
 
 void GFX_3D_Renderer_RenderEmpty()
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "gfx/3d/room_cache.h"
 #include "gfx/3d/vertex_stream.h"
 #include "gfx/gl/program.h"
 #include "gfx/gl/sampler.h"
@@ -7,23 +8,55 @@
 
 #define GFX_MAX_TEXTURES 128
 #define GFX_NO_TEXTURE (-1)
+#define GFX_TEXTURE_ARRAY (-2)
 
 #include <stdint.h>
 
+typedef struct GFX_3D_RenderState {
+    int texture_num;
+    bool texturing_enabled;
+    bool blending_enabled;
+    GFX_3D_PrimType prim_type;
+} GFX_3D_RenderState;
+
+typedef struct GFX_3D_Batch {
+    GFX_3D_RenderState state;
+    GFX_3D_IndexRange range;
+    int32_t draw_list;
+    int32_t seq;
+} GFX_3D_Batch;
+
 typedef struct GFX_3D_Renderer {
     bool wireframe;
+    bool batching;
     GFX_GL_Program program;
     GFX_GL_Sampler sampler;
     GFX_3D_VertexStream vertex_stream;
+    GFX_3D_RoomCache room_cache;
 
     GFX_GL_Texture *textures[GFX_MAX_TEXTURES];
-    int selected_texture_num;
+    GFX_GL_Texture *texture_array;
+
+    // state of the primitives being pushed, and the state that was last
+    // sent to GL
+    GFX_3D_RenderState state;
+    GFX_3D_RenderState applied_state;
+    bool is_applied_state_valid;
+
+    struct {
+        GFX_3D_Batch *data;
+        GFX_3D_IndexRange *ranges;
+        int count;
+        int capacity;
+        int32_t draw_list;
+    } batches;
 
     // shader variable locations
     GLint loc_mat_projection;
     GLint loc_mat_model_view;
     GLint loc_texturing_enabled;
     GLint loc_smoothing_enabled;
+    GLint loc_texture_array_enabled;
 } GFX_3D_Renderer;
 
 void GFX_3D_Renderer_Init(GFX_3D_Renderer *renderer);
@@ -31,16 +64,50 @@ void GFX_3D_Renderer_Close(GFX_3D_Renderer *renderer);
 
 void GFX_3D_Renderer_RenderBegin(GFX_3D_Renderer *renderer);
 void GFX_3D_Renderer_RenderEnd(GFX_3D_Renderer *renderer);
+void GFX_3D_Renderer_EndFrame(GFX_3D_Renderer *renderer);
+void GFX_3D_Renderer_GetStreamStats(
+    GFX_3D_Renderer *renderer, GFX_3D_VertexStreamStats *stats);
 
 int GFX_3D_Renderer_TextureReg(
     GFX_3D_Renderer *renderer, const void *data, int width, int height);
 bool GFX_3D_Renderer_TextureUnreg(GFX_3D_Renderer *renderer, int texture_num);
 
+// Uploads all the given pages, stored one after another, as layers of a
+// single array texture.
+bool GFX_3D_Renderer_TextureArrayReg(
+    GFX_3D_Renderer *renderer, const void *data, int width, int height,
+    int layers);
+// Replaces the contents of a range of layers of the registered array
+// texture.
+void GFX_3D_Renderer_TextureArrayUpdate(
+    GFX_3D_Renderer *renderer, const void *data, int width, int height,
+    int first_layer, int layer_count);
+void GFX_3D_Renderer_TextureArrayUnreg(GFX_3D_Renderer *renderer);
+
+// The room geometry is drawn with the array texture, so it can only be
+// registered after the texture array.
+void GFX_3D_Renderer_RoomCacheReg(
+    GFX_3D_Renderer *renderer, const GFX_3D_RoomVertex *vertices,
+    size_t vertex_count, const GLuint *indices, size_t index_count,
+    const GFX_3D_IndexRange *rooms, int room_count, const int32_t *wibble_table,
+    const int32_t *shade_table);
+void GFX_3D_Renderer_RoomCacheUnreg(GFX_3D_Renderer *renderer);
+void GFX_3D_Renderer_DrawRoom(
+    GFX_3D_Renderer *renderer, int room_num, const GFX_3D_RoomParams *params);
+
 void GFX_3D_Renderer_SelectTexture(GFX_3D_Renderer *renderer, int texture_num);
+void GFX_3D_Renderer_SelectTextureLayer(GFX_3D_Renderer *renderer, int layer);
 void GFX_3D_Renderer_RestoreTexture(GFX_3D_Renderer *renderer);
 
+// Starts the primitives of another mesh. The opaque primitives are only
+// sorted by state within a mesh, so that faces of different meshes that end
+// up at the same depth are still drawn in the order they were submitted.
+void GFX_3D_Renderer_BeginDrawList(GFX_3D_Renderer *renderer);
+
 void GFX_3D_Renderer_RenderPrimStrip(
     GFX_3D_Renderer *renderer, GFX_3D_Vertex *vertices, int count);
+void GFX_3D_Renderer_RenderPrimFan(
+    GFX_3D_Renderer *renderer, GFX_3D_Vertex *vertices, int count);
 void GFX_3D_Renderer_RenderPrimList(
     GFX_3D_Renderer *renderer, GFX_3D_Vertex *vertices, int count);
 
@@ -52,4 +119,7 @@ void GFX_3D_Renderer_SetBlendingEnabled(
     GFX_3D_Renderer *renderer, bool is_enabled);
 void GFX_3D_Renderer_SetTexturingEnabled(
     GFX_3D_Renderer *renderer, bool is_enabled);
+void GFX_3D_Renderer_SetBatchingEnabled(
+    GFX_3D_Renderer *renderer, bool is_enabled);
+void GFX_3D_Renderer_Flush(GFX_3D_Renderer *renderer);
 void GFX_3D_Renderer_RenderEmpty();
@@ -0,0 +1,279 @@
+#include "gfx/3d/room_cache.h"
+
+#include "gfx/context.h"
+#include "gfx/gl/utils.h"
+#include "memory.h"
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+static void GFX_3D_RoomCache_SetScissor(const GFX_3D_RoomParams *params);
+
+static void GFX_3D_RoomCache_SetScissor(const GFX_3D_RoomParams *params)
+{
+    // the screen coordinates span the display size, which is scaled into
+    // the viewport; the scissor box is in window pixels from the bottom
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    const float scale_x = (float)viewport[2] / GFX_Context_GetDisplayWidth();
+    const float scale_y = (float)viewport[3] / GFX_Context_GetDisplayHeight();
+    const int32_t display_height = GFX_Context_GetDisplayHeight();
+
+    const GLint x0 = viewport[0] + floorf(params->clip_left * scale_x);
+    const GLint x1 = viewport[0] + ceilf((params->clip_right + 1) * scale_x);
+    const GLint y0 = viewport[1]
+        + floorf((display_height - params->clip_bottom - 1) * scale_y);
+    const GLint y1 =
+        viewport[1] + ceilf((display_height - params->clip_top) * scale_y);
+    glScissor(x0, y0, x1 > x0 ? x1 - x0 : 0, y1 > y0 ? y1 - y0 : 0);
+}
+
+void GFX_3D_RoomCache_Init(GFX_3D_RoomCache *cache)
+{
+    assert(cache);
+    cache->is_loaded = false;
+    cache->rooms = NULL;
+    cache->room_count = 0;
+    cache->draw_calls = 0;
+    cache->last_frame_draw_calls = 0;
+
+    GFX_GL_Program_Init(&cache->program);
+    GFX_GL_Program_AttachShader(
+        &cache->program, GL_VERTEX_SHADER, "shaders\\3d_room.vsh");
+    GFX_GL_Program_AttachShader(
+        &cache->program, GL_FRAGMENT_SHADER, "shaders\\3d.fsh");
+    GFX_GL_Program_Link(&cache->program);
+
+    cache->loc_mat_projection =
+        GFX_GL_Program_UniformLocation(&cache->program, "matProjection");
+    cache->loc_mat_model_view =
+        GFX_GL_Program_UniformLocation(&cache->program, "matModelView");
+    cache->loc_mat_view =
+        GFX_GL_Program_UniformLocation(&cache->program, "matView");
+    cache->loc_center =
+        GFX_GL_Program_UniformLocation(&cache->program, "viewCenter");
+    cache->loc_perspective =
+        GFX_GL_Program_UniformLocation(&cache->program, "perspective");
+    cache->loc_near_z =
+        GFX_GL_Program_UniformLocation(&cache->program, "nearZ");
+    cache->loc_fog_begin =
+        GFX_GL_Program_UniformLocation(&cache->program, "fogBegin");
+    cache->loc_fog_end =
+        GFX_GL_Program_UniformLocation(&cache->program, "fogEnd");
+    cache->loc_draw_dist_max =
+        GFX_GL_Program_UniformLocation(&cache->program, "drawDistMax");
+    cache->loc_brightness =
+        GFX_GL_Program_UniformLocation(&cache->program, "brightness");
+    cache->loc_tint = GFX_GL_Program_UniformLocation(&cache->program, "tint");
+    cache->loc_water_effect =
+        GFX_GL_Program_UniformLocation(&cache->program, "waterEffect");
+    cache->loc_wibble_effect =
+        GFX_GL_Program_UniformLocation(&cache->program, "wibbleEffect");
+    cache->loc_wibble_offset =
+        GFX_GL_Program_UniformLocation(&cache->program, "wibbleOffset");
+    cache->loc_wibble_table =
+        GFX_GL_Program_UniformLocation(&cache->program, "wibbleTable");
+    cache->loc_shade_table =
+        GFX_GL_Program_UniformLocation(&cache->program, "shadeTable");
+    cache->loc_smoothing_enabled =
+        GFX_GL_Program_UniformLocation(&cache->program, "smoothingEnabled");
+
+    GFX_GL_Program_FragmentData(&cache->program, "fragColor");
+    GFX_GL_Program_Bind(&cache->program);
+
+    // rooms are always textured, and always with the texture array
+    GFX_GL_Program_Uniform1i(
+        &cache->program,
+        GFX_GL_Program_UniformLocation(&cache->program, "texturingEnabled"),
+        1);
+    GFX_GL_Program_Uniform1i(
+        &cache->program,
+        GFX_GL_Program_UniformLocation(&cache->program, "textureArrayEnabled"),
+        1);
+    GFX_GL_Program_Uniform1i(
+        &cache->program,
+        GFX_GL_Program_UniformLocation(&cache->program, "texArray"), 1);
+
+    GFX_GL_Buffer_Init(&cache->vertex_buffer, GL_ARRAY_BUFFER);
+    GFX_GL_Buffer_Bind(&cache->vertex_buffer);
+
+    GFX_GL_VertexArray_Init(&cache->vertex_format);
+    GFX_GL_VertexArray_Bind(&cache->vertex_format);
+    GFX_GL_VertexArray_Attribute(
+        &cache->vertex_format, 0, 3, GL_FLOAT, GL_FALSE, 32, 0);
+    GFX_GL_VertexArray_Attribute(
+        &cache->vertex_format, 1, 2, GL_FLOAT, GL_FALSE, 32, 12);
+    GFX_GL_VertexArray_Attribute(
+        &cache->vertex_format, 2, 1, GL_FLOAT, GL_FALSE, 32, 20);
+    GFX_GL_VertexArray_Attribute(
+        &cache->vertex_format, 3, 1, GL_FLOAT, GL_FALSE, 32, 24);
+    GFX_GL_VertexArray_Attribute(
+        &cache->vertex_format, 4, 1, GL_FLOAT, GL_FALSE, 32, 28);
+
+    // the element array binding is a part of the vertex array state
+    GFX_GL_Buffer_Init(&cache->index_buffer, GL_ELEMENT_ARRAY_BUFFER);
+    GFX_GL_Buffer_Bind(&cache->index_buffer);
+
+    GFX_GL_CheckError();
+}
+
+void GFX_3D_RoomCache_Close(GFX_3D_RoomCache *cache)
+{
+    assert(cache);
+    GFX_3D_RoomCache_Unload(cache);
+    GFX_GL_VertexArray_Close(&cache->vertex_format);
+    GFX_GL_Buffer_Close(&cache->index_buffer);
+    GFX_GL_Buffer_Close(&cache->vertex_buffer);
+    GFX_GL_Program_Close(&cache->program);
+}
+
+void GFX_3D_RoomCache_SetMatrices(
+    GFX_3D_RoomCache *cache, const GLfloat *projection,
+    const GLfloat *model_view)
+{
+    assert(cache);
+    GFX_GL_Program_Bind(&cache->program);
+    GFX_GL_Program_UniformMatrix4fv(
+        &cache->program, cache->loc_mat_projection, 1, GL_FALSE, projection);
+    GFX_GL_Program_UniformMatrix4fv(
+        &cache->program, cache->loc_mat_model_view, 1, GL_FALSE, model_view);
+}
+
+void GFX_3D_RoomCache_SetSmoothingEnabled(
+    GFX_3D_RoomCache *cache, bool is_enabled)
+{
+    assert(cache);
+    GFX_GL_Program_Bind(&cache->program);
+    GFX_GL_Program_Uniform1i(
+        &cache->program, cache->loc_smoothing_enabled, is_enabled);
+}
+
+void GFX_3D_RoomCache_Load(
+    GFX_3D_RoomCache *cache, const GFX_3D_RoomVertex *vertices,
+    size_t vertex_count, const GLuint *indices, size_t index_count,
+    const GFX_3D_IndexRange *rooms, int room_count, const int32_t *wibble_table,
+    const int32_t *shade_table)
+{
+    assert(cache);
+    assert(vertices);
+    assert(indices);
+    assert(rooms);
+
+    GFX_3D_RoomCache_Unload(cache);
+
+    GFX_GL_VertexArray_Bind(&cache->vertex_format);
+    GFX_GL_Buffer_Bind(&cache->vertex_buffer);
+    GFX_GL_Buffer_Data(
+        &cache->vertex_buffer, vertex_count * sizeof(GFX_3D_RoomVertex),
+        vertices, GL_STATIC_DRAW);
+    GFX_GL_Buffer_Bind(&cache->index_buffer);
+    GFX_GL_Buffer_Data(
+        &cache->index_buffer, index_count * sizeof(GLuint), indices,
+        GL_STATIC_DRAW);
+
+    cache->room_count = room_count;
+    cache->rooms = Memory_Alloc(room_count * sizeof(GFX_3D_IndexRange));
+    memcpy(cache->rooms, rooms, room_count * sizeof(GFX_3D_IndexRange));
+
+    GFX_GL_Program_Bind(&cache->program);
+    GFX_GL_Program_Uniform1iv(
+        &cache->program, cache->loc_wibble_table, GFX_3D_ROOM_WIBBLE_SIZE,
+        wibble_table);
+    GFX_GL_Program_Uniform1iv(
+        &cache->program, cache->loc_shade_table, GFX_3D_ROOM_WIBBLE_SIZE,
+        shade_table);
+
+    cache->is_loaded = true;
+
+    GFX_GL_CheckError();
+}
+
+void GFX_3D_RoomCache_Unload(GFX_3D_RoomCache *cache)
+{
+    assert(cache);
+    Memory_FreePointer(&cache->rooms);
+    cache->room_count = 0;
+    cache->is_loaded = false;
+}
+
+void GFX_3D_RoomCache_Draw(
+    GFX_3D_RoomCache *cache, int room_num, const GFX_3D_RoomParams *params)
+{
+    assert(cache);
+    assert(params);
+    assert(cache->is_loaded);
+    assert(room_num >= 0 && room_num < cache->room_count);
+
+    const GFX_3D_IndexRange *range = &cache->rooms[room_num];
+    if (!range->count) {
+        return;
+    }
+
+    GFX_GL_Program_Bind(&cache->program);
+
+    const GLfloat view[4][4] = {
+        { params->matrix[0][0], params->matrix[0][1], params->matrix[0][2],
+          params->matrix[0][3] },
+        { params->matrix[1][0], params->matrix[1][1], params->matrix[1][2],
+          params->matrix[1][3] },
+        { params->matrix[2][0], params->matrix[2][1], params->matrix[2][2],
+          params->matrix[2][3] },
+        { 0.0f, 0.0f, 0.0f, 1.0f },
+    };
+    GFX_GL_Program_UniformMatrix4fv(
+        &cache->program, cache->loc_mat_view, 1, GL_TRUE, &view[0][0]);
+    GFX_GL_Program_Uniform2f(
+        &cache->program, cache->loc_center, params->center_x,
+        params->center_y);
+    GFX_GL_Program_Uniform1f(
+        &cache->program, cache->loc_perspective, params->perspective);
+    GFX_GL_Program_Uniform1f(&cache->program, cache->loc_near_z, params->near_z);
+    GFX_GL_Program_Uniform1i(
+        &cache->program, cache->loc_fog_begin, params->fog_begin);
+    GFX_GL_Program_Uniform1i(
+        &cache->program, cache->loc_fog_end, params->fog_end);
+    GFX_GL_Program_Uniform1i(
+        &cache->program, cache->loc_draw_dist_max, params->draw_dist_max);
+    GFX_GL_Program_Uniform1f(
+        &cache->program, cache->loc_brightness, params->brightness);
+    GFX_GL_Program_Uniform3f(
+        &cache->program, cache->loc_tint, params->tint_r, params->tint_g,
+        params->tint_b);
+    GFX_GL_Program_Uniform1i(
+        &cache->program, cache->loc_water_effect, params->water_effect);
+    GFX_GL_Program_Uniform1i(
+        &cache->program, cache->loc_wibble_effect, params->wibble_effect);
+    GFX_GL_Program_Uniform1i(
+        &cache->program, cache->loc_wibble_offset, params->wibble_offset);
+
+    // faces facing away from the camera are culled on the CPU for all the
+    // other geometry; the winding matches the test used there
+    glEnable(GL_CULL_FACE);
+    glFrontFace(GL_CW);
+    glCullFace(GL_BACK);
+    glEnable(GL_CLIP_DISTANCE0);
+    // the CPU path never draws a room outside the portal it is seen
+    // through, and the depth test does not stop it either
+    glEnable(GL_SCISSOR_TEST);
+    GFX_3D_RoomCache_SetScissor(params);
+
+    GFX_GL_VertexArray_Bind(&cache->vertex_format);
+    glDrawElements(
+        GL_TRIANGLES, range->count, GL_UNSIGNED_INT,
+        (void *)(range->start * sizeof(GLuint)));
+    cache->draw_calls++;
+
+    glDisable(GL_SCISSOR_TEST);
+    glDisable(GL_CLIP_DISTANCE0);
+    glDisable(GL_CULL_FACE);
+
+    GFX_GL_CheckError();
+}
+
+void GFX_3D_RoomCache_EndFrame(GFX_3D_RoomCache *cache)
+{
+    assert(cache);
+    cache->last_frame_draw_calls = cache->draw_calls;
+    cache->draw_calls = 0;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "gfx/3d/vertex_stream.h"
+#include "gfx/gl/buffer.h"
+#include "gfx/gl/program.h"
+#include "gfx/gl/vertex_array.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define GFX_3D_ROOM_WIBBLE_SIZE 32
+
+// A room vertex as it was loaded from the level file, expanded for every
+// face it belongs to so that it can carry the texture coordinates.
+typedef struct GFX_3D_RoomVertex {
+    float x, y, z;
+    float u, v;
+    float layer;
+    float shade;
+    float water_rand;
+} GFX_3D_RoomVertex;
+
+// Everything that changes between frames, ie. the view matrix, the fog and
+// the water effects, and the portal window the room is seen through in
+// screen coordinates, with the right and bottom edges included.
+typedef struct GFX_3D_RoomParams {
+    float matrix[3][4];
+    int32_t clip_left;
+    int32_t clip_top;
+    int32_t clip_right;
+    int32_t clip_bottom;
+    float center_x;
+    float center_y;
+    float perspective;
+    float near_z;
+    int32_t fog_begin;
+    int32_t fog_end;
+    int32_t draw_dist_max;
+    float brightness;
+    float tint_r, tint_g, tint_b;
+    bool water_effect;
+    bool wibble_effect;
+    int32_t wibble_offset;
+} GFX_3D_RoomParams;
+
+typedef struct GFX_3D_RoomCache {
+    bool is_loaded;
+    GFX_GL_Program program;
+    GFX_GL_VertexArray vertex_format;
+    GFX_GL_Buffer vertex_buffer;
+    GFX_GL_Buffer index_buffer;
+
+    GFX_3D_IndexRange *rooms;
+    int room_count;
+
+    int32_t draw_calls;
+    int32_t last_frame_draw_calls;
+
+    // shader variable locations
+    GLint loc_mat_projection;
+    GLint loc_mat_model_view;
+    GLint loc_mat_view;
+    GLint loc_center;
+    GLint loc_perspective;
+    GLint loc_near_z;
+    GLint loc_fog_begin;
+    GLint loc_fog_end;
+    GLint loc_draw_dist_max;
+    GLint loc_brightness;
+    GLint loc_tint;
+    GLint loc_water_effect;
+    GLint loc_wibble_effect;
+    GLint loc_wibble_offset;
+    GLint loc_wibble_table;
+    GLint loc_shade_table;
+    GLint loc_smoothing_enabled;
+} GFX_3D_RoomCache;
+
+void GFX_3D_RoomCache_Init(GFX_3D_RoomCache *cache);
+void GFX_3D_RoomCache_Close(GFX_3D_RoomCache *cache);
+
+void GFX_3D_RoomCache_SetMatrices(
+    GFX_3D_RoomCache *cache, const GLfloat *projection,
+    const GLfloat *model_view);
+void GFX_3D_RoomCache_SetSmoothingEnabled(
+    GFX_3D_RoomCache *cache, bool is_enabled);
+
+// Uploads the geometry of all rooms. Each room is drawn as the given range
+// of the index array.
+void GFX_3D_RoomCache_Load(
+    GFX_3D_RoomCache *cache, const GFX_3D_RoomVertex *vertices,
+    size_t vertex_count, const GLuint *indices, size_t index_count,
+    const GFX_3D_IndexRange *rooms, int room_count, const int32_t *wibble_table,
+    const int32_t *shade_table);
+void GFX_3D_RoomCache_Unload(GFX_3D_RoomCache *cache);
+
+void GFX_3D_RoomCache_Draw(
+    GFX_3D_RoomCache *cache, int room_num, const GFX_3D_RoomParams *params);
+void GFX_3D_RoomCache_EndFrame(GFX_3D_RoomCache *cache);
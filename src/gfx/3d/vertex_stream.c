@@ -4,48 +4,93 @@
 #include "log.h"
 #include "memory.h"
 
+#include <assert.h>
+#include <string.h>
+
 static const GLenum GL_PRIM_MODES[] = {
     GL_LINES, // GFX_3D_PRIM_LINE
     GL_TRIANGLES, // GFX_3D_PRIM_TRI
 };
 
-static void GFX_3D_VertexStream_PushVertex(
-    GFX_3D_VertexStream *vertex_stream, GFX_3D_Vertex *vertex);
+static GLuint GFX_3D_VertexStream_PushVertices(
+    GFX_3D_VertexStream *vertex_stream, GFX_3D_Vertex *vertices, int count);
+static void GFX_3D_VertexStream_PushIndex(
+    GFX_3D_VertexStream *vertex_stream, GLuint index);
 
-static void GFX_3D_VertexStream_PushVertex(
-    GFX_3D_VertexStream *vertex_stream, GFX_3D_Vertex *vertex)
+static GLuint GFX_3D_VertexStream_PushVertices(
+    GFX_3D_VertexStream *vertex_stream, GFX_3D_Vertex *vertices, int count)
 {
-    if (vertex_stream->pending_vertices.count + 1
-        >= vertex_stream->pending_vertices.capacity) {
-        vertex_stream->pending_vertices.capacity += 1000;
+    size_t capacity = vertex_stream->pending_vertices.capacity;
+    while (vertex_stream->pending_vertices.count + count >= capacity) {
+        capacity += 1000;
+    }
+    if (capacity != vertex_stream->pending_vertices.capacity) {
+        vertex_stream->pending_vertices.capacity = capacity;
         vertex_stream->pending_vertices.data = Memory_Realloc(
             vertex_stream->pending_vertices.data,
             vertex_stream->pending_vertices.capacity * sizeof(GFX_3D_Vertex));
     }
 
-    vertex_stream->pending_vertices
-        .data[vertex_stream->pending_vertices.count++] = *vertex;
+    GLuint base = vertex_stream->pending_vertices.count;
+    GFX_3D_Vertex *target = &vertex_stream->pending_vertices.data[base];
+    memcpy(target, vertices, count * sizeof(GFX_3D_Vertex));
+    for (int i = 0; i < count; i++) {
+        target[i].layer = vertex_stream->texture_layer;
+    }
+    vertex_stream->pending_vertices.count += count;
+    return base;
+}
+
+static void GFX_3D_VertexStream_PushIndex(
+    GFX_3D_VertexStream *vertex_stream, GLuint index)
+{
+    if (vertex_stream->pending_indices.count + 1
+        >= vertex_stream->pending_indices.capacity) {
+        vertex_stream->pending_indices.capacity += 3000;
+        vertex_stream->pending_indices.data = Memory_Realloc(
+            vertex_stream->pending_indices.data,
+            vertex_stream->pending_indices.capacity * sizeof(GLuint));
+    }
+
+    vertex_stream->pending_indices
+        .data[vertex_stream->pending_indices.count++] = index;
 }
 
 void GFX_3D_VertexStream_Init(GFX_3D_VertexStream *vertex_stream)
 {
     vertex_stream->prim_type = GFX_3D_PRIM_TRI;
-    vertex_stream->buffer_size = 0;
+    vertex_stream->texture_layer = 0.0f;
     vertex_stream->pending_vertices.data = NULL;
     vertex_stream->pending_vertices.count = 0;
     vertex_stream->pending_vertices.capacity = 0;
+    vertex_stream->pending_indices.data = NULL;
+    vertex_stream->pending_indices.count = 0;
+    vertex_stream->pending_indices.capacity = 0;
+    vertex_stream->scratch_indices.data = NULL;
+    vertex_stream->scratch_indices.capacity = 0;
+    vertex_stream->uploaded.vertex_offset = 0;
+    vertex_stream->uploaded.index_offset = 0;
+    vertex_stream->draw_calls = 0;
+    vertex_stream->last_frame_draw_calls = 0;
 
-    GFX_GL_Buffer_Init(&vertex_stream->buffer, GL_ARRAY_BUFFER);
-    GFX_GL_Buffer_Bind(&vertex_stream->buffer);
+    GFX_GL_RingBuffer_Init(&vertex_stream->buffer, GL_ARRAY_BUFFER);
+    GFX_GL_RingBuffer_Bind(&vertex_stream->buffer);
 
     GFX_GL_VertexArray_Init(&vertex_stream->vtc_format);
     GFX_GL_VertexArray_Bind(&vertex_stream->vtc_format);
     GFX_GL_VertexArray_Attribute(
-        &vertex_stream->vtc_format, 0, 3, GL_FLOAT, GL_FALSE, 40, 0);
+        &vertex_stream->vtc_format, 0, 3, GL_FLOAT, GL_FALSE, 44, 0);
+    GFX_GL_VertexArray_Attribute(
+        &vertex_stream->vtc_format, 1, 3, GL_FLOAT, GL_FALSE, 44, 12);
     GFX_GL_VertexArray_Attribute(
-        &vertex_stream->vtc_format, 1, 3, GL_FLOAT, GL_FALSE, 40, 12);
+        &vertex_stream->vtc_format, 2, 4, GL_FLOAT, GL_FALSE, 44, 24);
     GFX_GL_VertexArray_Attribute(
-        &vertex_stream->vtc_format, 2, 4, GL_FLOAT, GL_FALSE, 40, 24);
+        &vertex_stream->vtc_format, 3, 1, GL_FLOAT, GL_FALSE, 44, 40);
+
+    // the element array binding is a part of the vertex array state
+    GFX_GL_RingBuffer_Init(
+        &vertex_stream->index_buffer, GL_ELEMENT_ARRAY_BUFFER);
+    GFX_GL_RingBuffer_Bind(&vertex_stream->index_buffer);
 
     GFX_GL_CheckError();
 }
@@ -53,14 +98,17 @@ void GFX_3D_VertexStream_Init(GFX_3D_VertexStream *vertex_stream)
 void GFX_3D_VertexStream_Close(GFX_3D_VertexStream *vertex_stream)
 {
     GFX_GL_VertexArray_Close(&vertex_stream->vtc_format);
-    GFX_GL_Buffer_Close(&vertex_stream->buffer);
+    GFX_GL_RingBuffer_Close(&vertex_stream->index_buffer);
+    GFX_GL_RingBuffer_Close(&vertex_stream->buffer);
 
     Memory_FreePointer(&vertex_stream->pending_vertices.data);
+    Memory_FreePointer(&vertex_stream->pending_indices.data);
+    Memory_FreePointer(&vertex_stream->scratch_indices.data);
 }
 
 void GFX_3D_VertexStream_Bind(GFX_3D_VertexStream *vertex_stream)
 {
-    GFX_GL_Buffer_Bind(&vertex_stream->buffer);
+    GFX_GL_RingBuffer_Bind(&vertex_stream->buffer);
 }
 
 void GFX_3D_VertexStream_SetPrimType(
@@ -69,6 +117,12 @@ void GFX_3D_VertexStream_SetPrimType(
     vertex_stream->prim_type = prim_type;
 }
 
+void GFX_3D_VertexStream_SetTextureLayer(
+    GFX_3D_VertexStream *vertex_stream, int layer)
+{
+    vertex_stream->texture_layer = layer;
+}
+
 bool GFX_3D_VertexStream_PushPrimStrip(
     GFX_3D_VertexStream *vertex_stream, GFX_3D_Vertex *vertices, int count)
 {
@@ -77,59 +131,157 @@ bool GFX_3D_VertexStream_PushPrimStrip(
         return false;
     }
 
+    GLuint base =
+        GFX_3D_VertexStream_PushVertices(vertex_stream, vertices, count);
     if (count <= 2) {
         for (int i = 0; i < count; i++) {
-            GFX_3D_VertexStream_PushVertex(vertex_stream, &vertices[i]);
+            GFX_3D_VertexStream_PushIndex(vertex_stream, base + i);
         }
     } else {
         for (int i = 2; i < count; i++) {
-            GFX_3D_VertexStream_PushVertex(vertex_stream, &vertices[i - 2]);
-            GFX_3D_VertexStream_PushVertex(vertex_stream, &vertices[i - 1]);
-            GFX_3D_VertexStream_PushVertex(vertex_stream, &vertices[i]);
+            GFX_3D_VertexStream_PushIndex(vertex_stream, base + i - 2);
+            GFX_3D_VertexStream_PushIndex(vertex_stream, base + i - 1);
+            GFX_3D_VertexStream_PushIndex(vertex_stream, base + i);
         }
     }
 
     return true;
 }
 
+bool GFX_3D_VertexStream_PushPrimFan(
+    GFX_3D_VertexStream *vertex_stream, GFX_3D_Vertex *vertices, int count)
+{
+    if (vertex_stream->prim_type != GFX_3D_PRIM_TRI) {
+        LOG_ERROR("Unsupported prim type: %d", vertex_stream->prim_type);
+        return false;
+    }
+
+    if (count < 3) {
+        return true;
+    }
+
+    GLuint base =
+        GFX_3D_VertexStream_PushVertices(vertex_stream, vertices, count);
+    for (int i = 2; i < count; i++) {
+        GFX_3D_VertexStream_PushIndex(vertex_stream, base);
+        GFX_3D_VertexStream_PushIndex(vertex_stream, base + i - 1);
+        GFX_3D_VertexStream_PushIndex(vertex_stream, base + i);
+    }
+
+    return true;
+}
+
 bool GFX_3D_VertexStream_PushPrimList(
     GFX_3D_VertexStream *vertex_stream, GFX_3D_Vertex *vertices, int count)
 {
+    GLuint base =
+        GFX_3D_VertexStream_PushVertices(vertex_stream, vertices, count);
     for (int i = 0; i < count; i++) {
-        GFX_3D_VertexStream_PushVertex(vertex_stream, &vertices[i]);
+        GFX_3D_VertexStream_PushIndex(vertex_stream, base + i);
     }
     return true;
 }
 
-void GFX_3D_VertexStream_RenderPending(GFX_3D_VertexStream *vertex_stream)
+size_t GFX_3D_VertexStream_GetPendingIndexCount(
+    GFX_3D_VertexStream *vertex_stream)
 {
-    if (!vertex_stream->pending_vertices.count) {
-        return;
+    return vertex_stream->pending_indices.count;
+}
+
+void GFX_3D_VertexStream_ReorderPending(
+    GFX_3D_VertexStream *vertex_stream, const GFX_3D_IndexRange *ranges,
+    int count)
+{
+    if (vertex_stream->scratch_indices.capacity
+        < vertex_stream->pending_indices.capacity) {
+        vertex_stream->scratch_indices.capacity =
+            vertex_stream->pending_indices.capacity;
+        vertex_stream->scratch_indices.data = Memory_Realloc(
+            vertex_stream->scratch_indices.data,
+            vertex_stream->scratch_indices.capacity * sizeof(GLuint));
     }
 
-    GFX_GL_VertexArray_Bind(&vertex_stream->vtc_format);
+    size_t total = 0;
+    for (int i = 0; i < count; i++) {
+        assert(
+            ranges[i].start + ranges[i].count
+            <= vertex_stream->pending_indices.count);
+        memcpy(
+            &vertex_stream->scratch_indices.data[total],
+            &vertex_stream->pending_indices.data[ranges[i].start],
+            ranges[i].count * sizeof(GLuint));
+        total += ranges[i].count;
+    }
+    assert(total == vertex_stream->pending_indices.count);
+
+    // swap the buffers rather than copying the result back
+    GLuint *data = vertex_stream->pending_indices.data;
+    size_t capacity = vertex_stream->pending_indices.capacity;
+    vertex_stream->pending_indices.data = vertex_stream->scratch_indices.data;
+    vertex_stream->pending_indices.capacity =
+        vertex_stream->scratch_indices.capacity;
+    vertex_stream->scratch_indices.data = data;
+    vertex_stream->scratch_indices.capacity = capacity;
+}
 
-    // resize GPU buffer if required
-    size_t buffer_size =
-        sizeof(GFX_3D_Vertex) * vertex_stream->pending_vertices.count;
-    if (buffer_size > vertex_stream->buffer_size) {
-        LOG_INFO(
-            "Vertex buffer resize: %d -> %d", vertex_stream->buffer_size,
-            buffer_size);
-        GFX_GL_Buffer_Data(
-            &vertex_stream->buffer, buffer_size, NULL, GL_STREAM_DRAW);
-        vertex_stream->buffer_size = buffer_size;
+bool GFX_3D_VertexStream_UploadPending(GFX_3D_VertexStream *vertex_stream)
+{
+    if (!vertex_stream->pending_indices.count) {
+        vertex_stream->pending_vertices.count = 0;
+        return false;
     }
 
-    GFX_GL_Buffer_SubData(
-        &vertex_stream->buffer, 0, buffer_size,
-        vertex_stream->pending_vertices.data);
+    GFX_GL_VertexArray_Bind(&vertex_stream->vtc_format);
 
-    glDrawArrays(
-        GL_PRIM_MODES[vertex_stream->prim_type], 0,
-        vertex_stream->pending_vertices.count);
+    // uploading only appends to the current frame segment of the ring
+    // buffers rather than respecifying a buffer the GPU might still be
+    // reading from
+    vertex_stream->uploaded.vertex_offset = GFX_GL_RingBuffer_Push(
+        &vertex_stream->buffer, vertex_stream->pending_vertices.data,
+        sizeof(GFX_3D_Vertex) * vertex_stream->pending_vertices.count,
+        sizeof(GFX_3D_Vertex));
+    vertex_stream->uploaded.index_offset = GFX_GL_RingBuffer_Push(
+        &vertex_stream->index_buffer, vertex_stream->pending_indices.data,
+        sizeof(GLuint) * vertex_stream->pending_indices.count, sizeof(GLuint));
+
+    vertex_stream->pending_vertices.count = 0;
+    vertex_stream->pending_indices.count = 0;
+    return true;
+}
+
+void GFX_3D_VertexStream_Draw(
+    GFX_3D_VertexStream *vertex_stream, GFX_3D_PrimType prim_type,
+    size_t first, size_t count)
+{
+    GFX_GL_VertexArray_Bind(&vertex_stream->vtc_format);
+
+    glDrawElementsBaseVertex(
+        GL_PRIM_MODES[prim_type], count, GL_UNSIGNED_INT,
+        (void *)(vertex_stream->uploaded.index_offset + first * sizeof(GLuint)),
+        vertex_stream->uploaded.vertex_offset / sizeof(GFX_3D_Vertex));
+    vertex_stream->draw_calls++;
 
     GFX_GL_CheckError();
+}
 
-    vertex_stream->pending_vertices.count = 0;
+void GFX_3D_VertexStream_EndFrame(GFX_3D_VertexStream *vertex_stream)
+{
+    GFX_GL_RingBuffer_Advance(&vertex_stream->buffer);
+    GFX_GL_RingBuffer_Advance(&vertex_stream->index_buffer);
+    vertex_stream->last_frame_draw_calls = vertex_stream->draw_calls;
+    vertex_stream->draw_calls = 0;
+}
+
+void GFX_3D_VertexStream_GetStats(
+    GFX_3D_VertexStream *vertex_stream, GFX_3D_VertexStreamStats *stats)
+{
+    const GFX_GL_RingBufferStats *vertex_stats =
+        &vertex_stream->buffer.last_frame_stats;
+    const GFX_GL_RingBufferStats *index_stats =
+        &vertex_stream->index_buffer.last_frame_stats;
+    stats->bytes_streamed =
+        vertex_stats->bytes_streamed + index_stats->bytes_streamed;
+    stats->stalls = vertex_stats->stalls + index_stats->stalls;
+    stats->orphans = vertex_stats->orphans + index_stats->orphans;
+    stats->draw_calls = vertex_stream->last_frame_draw_calls;
 }
@@ -1,9 +1,11 @@
 #pragma once
 
-#include "gfx/gl/buffer.h"
+#include "gfx/gl/ring_buffer.h"
 #include "gfx/gl/vertex_array.h"
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 typedef enum {
     GFX_3D_PRIM_LINE = 0,
@@ -14,18 +16,47 @@ typedef struct {
     float x, y, z;
     float s, t, w;
     float r, g, b, a;
+    float layer;
 } GFX_3D_Vertex;
 
+typedef struct GFX_3D_IndexRange {
+    size_t start;
+    size_t count;
+} GFX_3D_IndexRange;
+
+typedef struct GFX_3D_VertexStreamStats {
+    size_t bytes_streamed;
+    int32_t stalls;
+    int32_t orphans;
+    int32_t draw_calls;
+} GFX_3D_VertexStreamStats;
+
 typedef struct GFX_3D_VertexStream {
     GFX_3D_PrimType prim_type;
-    size_t buffer_size;
-    GFX_GL_Buffer buffer;
+    float texture_layer;
+    GFX_GL_RingBuffer buffer;
+    GFX_GL_RingBuffer index_buffer;
     GFX_GL_VertexArray vtc_format;
     struct {
         GFX_3D_Vertex *data;
         size_t count;
         size_t capacity;
     } pending_vertices;
+    struct {
+        GLuint *data;
+        size_t count;
+        size_t capacity;
+    } pending_indices;
+    struct {
+        GLuint *data;
+        size_t capacity;
+    } scratch_indices;
+    struct {
+        GLintptr vertex_offset;
+        GLintptr index_offset;
+    } uploaded;
+    int32_t draw_calls;
+    int32_t last_frame_draw_calls;
 } GFX_3D_VertexStream;
 
 void GFX_3D_VertexStream_Init(GFX_3D_VertexStream *vertex_stream);
@@ -35,10 +66,32 @@ void GFX_3D_VertexStream_Bind(GFX_3D_VertexStream *vertex_stream);
 
 void GFX_3D_VertexStream_SetPrimType(
     GFX_3D_VertexStream *vertex_stream, GFX_3D_PrimType prim_type);
+void GFX_3D_VertexStream_SetTextureLayer(
+    GFX_3D_VertexStream *vertex_stream, int layer);
 
 bool GFX_3D_VertexStream_PushPrimStrip(
     GFX_3D_VertexStream *vertex_stream, GFX_3D_Vertex *vertices, int count);
+bool GFX_3D_VertexStream_PushPrimFan(
+    GFX_3D_VertexStream *vertex_stream, GFX_3D_Vertex *vertices, int count);
 bool GFX_3D_VertexStream_PushPrimList(
     GFX_3D_VertexStream *vertex_stream, GFX_3D_Vertex *vertices, int count);
 
-void GFX_3D_VertexStream_RenderPending(GFX_3D_VertexStream *vertex_stream);
+size_t GFX_3D_VertexStream_GetPendingIndexCount(
+    GFX_3D_VertexStream *vertex_stream);
+
+// Rearranges the pending indices so that the given ranges, which must cover
+// all of them, follow each other in the given order.
+void GFX_3D_VertexStream_ReorderPending(
+    GFX_3D_VertexStream *vertex_stream, const GFX_3D_IndexRange *ranges,
+    int count);
+
+// Sends the pending vertices and indices to the GPU. The uploaded data can
+// then be drawn in parts with GFX_3D_VertexStream_Draw.
+bool GFX_3D_VertexStream_UploadPending(GFX_3D_VertexStream *vertex_stream);
+void GFX_3D_VertexStream_Draw(
+    GFX_3D_VertexStream *vertex_stream, GFX_3D_PrimType prim_type,
+    size_t first, size_t count);
+
+void GFX_3D_VertexStream_EndFrame(GFX_3D_VertexStream *vertex_stream);
+void GFX_3D_VertexStream_GetStats(
+    GFX_3D_VertexStream *vertex_stream, GFX_3D_VertexStreamStats *stats);
@@ -207,6 +207,8 @@ void GFX_Context_SetupViewport()
 
 void GFX_Context_SwapBuffers()
 {
+    GFX_3D_Renderer_EndFrame(&m_Context.renderer_3d);
+
     glFinish();
 
     if (m_Context.scheduled_screenshot_path) {
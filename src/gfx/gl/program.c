@@ -98,6 +98,17 @@ GLint GFX_GL_Program_UniformLocation(GFX_GL_Program *program, const char *name)
     return location;
 }
 
+void GFX_GL_Program_Uniform1f(GFX_GL_Program *program, GLint loc, GLfloat v0)
+{
+    glUniform1f(loc, v0);
+}
+
+void GFX_GL_Program_Uniform2f(
+    GFX_GL_Program *program, GLint loc, GLfloat v0, GLfloat v1)
+{
+    glUniform2f(loc, v0, v1);
+}
+
 void GFX_GL_Program_Uniform3f(
     GFX_GL_Program *program, GLint loc, GLfloat v0, GLfloat v1, GLfloat v2)
 {
@@ -116,6 +127,12 @@ void GFX_GL_Program_Uniform1i(GFX_GL_Program *program, GLint loc, GLint v0)
     glUniform1i(loc, v0);
 }
 
+void GFX_GL_Program_Uniform1iv(
+    GFX_GL_Program *program, GLint loc, GLsizei count, const GLint *value)
+{
+    glUniform1iv(loc, count, value);
+}
+
 void GFX_GL_Program_UniformMatrix4fv(
     GFX_GL_Program *program, GLint loc, GLsizei count, GLboolean transpose,
     const GLfloat *value)
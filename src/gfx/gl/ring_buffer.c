@@ -0,0 +1,166 @@
+#include "gfx/gl/ring_buffer.h"
+
+#include "gfx/gl/utils.h"
+#include "log.h"
+
+#include <assert.h>
+#include <string.h>
+
+#define GFX_GL_RING_BUFFER_WAIT_TIMEOUT 1000000000 // 1 second, in nanoseconds
+
+static void GFX_GL_RingBuffer_Orphan(
+    GFX_GL_RingBuffer *ring, GLsizeiptr segment_size);
+static void GFX_GL_RingBuffer_WaitSegment(GFX_GL_RingBuffer *ring);
+
+static void GFX_GL_RingBuffer_Orphan(
+    GFX_GL_RingBuffer *ring, GLsizeiptr segment_size)
+{
+    LOG_INFO(
+        "Ring buffer resize: %d -> %d",
+        ring->segment_size * GFX_GL_RING_BUFFER_SEGMENTS,
+        segment_size * GFX_GL_RING_BUFFER_SEGMENTS);
+
+    // the old storage stays alive until the GPU is done with it, so none of
+    // the pending fences are relevant anymore
+    for (int i = 0; i < GFX_GL_RING_BUFFER_SEGMENTS; i++) {
+        if (ring->fences[i]) {
+            glDeleteSync(ring->fences[i]);
+            ring->fences[i] = NULL;
+        }
+    }
+
+    GFX_GL_Buffer_Data(
+        &ring->buffer, segment_size * GFX_GL_RING_BUFFER_SEGMENTS, NULL,
+        GL_STREAM_DRAW);
+    ring->segment_size = segment_size;
+    ring->segment = 0;
+    ring->offset = 0;
+    ring->segment_ready = true;
+    ring->stats.orphans++;
+}
+
+static void GFX_GL_RingBuffer_WaitSegment(GFX_GL_RingBuffer *ring)
+{
+    ring->segment_ready = true;
+
+    GLsync fence = ring->fences[ring->segment];
+    if (!fence) {
+        return;
+    }
+
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        ring->stats.stalls++;
+        do {
+            result = glClientWaitSync(
+                fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+                GFX_GL_RING_BUFFER_WAIT_TIMEOUT);
+        } while (result == GL_TIMEOUT_EXPIRED);
+    }
+    if (result == GL_WAIT_FAILED) {
+        LOG_ERROR("Failed to wait for the ring buffer fence");
+    }
+
+    glDeleteSync(fence);
+    ring->fences[ring->segment] = NULL;
+}
+
+void GFX_GL_RingBuffer_Init(GFX_GL_RingBuffer *ring, GLenum target)
+{
+    assert(ring);
+    GFX_GL_Buffer_Init(&ring->buffer, target);
+    ring->segment_size = 0;
+    ring->segment = 0;
+    ring->offset = 0;
+    ring->segment_ready = true;
+    for (int i = 0; i < GFX_GL_RING_BUFFER_SEGMENTS; i++) {
+        ring->fences[i] = NULL;
+    }
+    memset(&ring->stats, 0, sizeof(ring->stats));
+    memset(&ring->last_frame_stats, 0, sizeof(ring->last_frame_stats));
+}
+
+void GFX_GL_RingBuffer_Close(GFX_GL_RingBuffer *ring)
+{
+    assert(ring);
+    for (int i = 0; i < GFX_GL_RING_BUFFER_SEGMENTS; i++) {
+        if (ring->fences[i]) {
+            glDeleteSync(ring->fences[i]);
+            ring->fences[i] = NULL;
+        }
+    }
+    GFX_GL_Buffer_Close(&ring->buffer);
+}
+
+void GFX_GL_RingBuffer_Bind(GFX_GL_RingBuffer *ring)
+{
+    assert(ring);
+    GFX_GL_Buffer_Bind(&ring->buffer);
+}
+
+GLintptr GFX_GL_RingBuffer_Push(
+    GFX_GL_RingBuffer *ring, const void *data, GLsizeiptr size,
+    GLsizeiptr alignment)
+{
+    assert(ring);
+    assert(data);
+    assert(alignment > 0);
+
+    GFX_GL_Buffer_Bind(&ring->buffer);
+
+    GLintptr offset = (ring->offset + alignment - 1) / alignment * alignment;
+    GLintptr segment_end = (ring->segment + 1) * ring->segment_size;
+    if (offset + size > segment_end) {
+        // the frame outgrew its segment - orphan the storage and start over
+        // with bigger segments
+        GLsizeiptr segment_size = ring->segment_size * 2;
+        if (segment_size < size + alignment) {
+            segment_size = size + alignment;
+        }
+        GFX_GL_RingBuffer_Orphan(ring, segment_size);
+        offset = 0;
+    }
+
+    if (!ring->segment_ready) {
+        GFX_GL_RingBuffer_WaitSegment(ring);
+    }
+
+    // the segment is known to be unused by the GPU at this point, so there is
+    // no need for the driver to synchronize the mapping
+    void *ptr = glMapBufferRange(
+        ring->buffer.target, offset, size,
+        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+            | GL_MAP_INVALIDATE_RANGE_BIT);
+    if (ptr) {
+        memcpy(ptr, data, size);
+        GFX_GL_Buffer_Unmap(&ring->buffer);
+    } else {
+        GFX_GL_Buffer_SubData(&ring->buffer, offset, size, data);
+    }
+
+    GFX_GL_CheckError();
+
+    ring->offset = offset + size;
+    ring->stats.bytes_streamed += size;
+    return offset;
+}
+
+void GFX_GL_RingBuffer_Advance(GFX_GL_RingBuffer *ring)
+{
+    assert(ring);
+
+    if (ring->segment_size) {
+        if (ring->fences[ring->segment]) {
+            glDeleteSync(ring->fences[ring->segment]);
+        }
+        ring->fences[ring->segment] =
+            glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+        ring->segment = (ring->segment + 1) % GFX_GL_RING_BUFFER_SEGMENTS;
+        ring->offset = ring->segment * ring->segment_size;
+        ring->segment_ready = false;
+    }
+
+    ring->last_frame_stats = ring->stats;
+    memset(&ring->stats, 0, sizeof(ring->stats));
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "gfx/gl/buffer.h"
+#include "gfx/gl/gl_core_3_3.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Number of frames that can be in flight before the CPU has to wait for the
+// GPU to release a segment of the ring.
+#define GFX_GL_RING_BUFFER_SEGMENTS 3
+
+typedef struct GFX_GL_RingBufferStats {
+    size_t bytes_streamed;
+    int32_t stalls;
+    int32_t orphans;
+} GFX_GL_RingBufferStats;
+
+typedef struct GFX_GL_RingBuffer {
+    GFX_GL_Buffer buffer;
+    GLsizeiptr segment_size;
+    int segment;
+    GLintptr offset;
+    bool segment_ready;
+    GLsync fences[GFX_GL_RING_BUFFER_SEGMENTS];
+    GFX_GL_RingBufferStats stats;
+    GFX_GL_RingBufferStats last_frame_stats;
+} GFX_GL_RingBuffer;
+
+void GFX_GL_RingBuffer_Init(GFX_GL_RingBuffer *ring, GLenum target);
+void GFX_GL_RingBuffer_Close(GFX_GL_RingBuffer *ring);
+
+void GFX_GL_RingBuffer_Bind(GFX_GL_RingBuffer *ring);
+
+// Copies the data to the current frame segment and returns its offset within
+// the underlying GL buffer, suitable for passing to draw calls.
+GLintptr GFX_GL_RingBuffer_Push(
+    GFX_GL_RingBuffer *ring, const void *data, GLsizeiptr size,
+    GLsizeiptr alignment);
+
+// Fences the current segment and moves on to the next one.
+void GFX_GL_RingBuffer_Advance(GFX_GL_RingBuffer *ring);
@@ -54,3 +54,37 @@ void GFX_GL_Texture_Load(
 
     GFX_GL_CheckError();
 }
+
+void GFX_GL_Texture_LoadArray(
+    GFX_GL_Texture *texture, const void *data, int width, int height,
+    int layers)
+{
+    assert(texture);
+    assert(data);
+    assert(texture->target == GL_TEXTURE_2D_ARRAY);
+
+    GFX_GL_Texture_Bind(texture);
+    glTexImage3D(
+        GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, width, height, layers, 0, GL_BGRA,
+        GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    GFX_GL_CheckError();
+}
+
+void GFX_GL_Texture_LoadArrayLayers(
+    GFX_GL_Texture *texture, const void *data, int width, int height,
+    int first_layer, int layer_count)
+{
+    assert(texture);
+    assert(data);
+    assert(texture->target == GL_TEXTURE_2D_ARRAY);
+
+    GFX_GL_Texture_Bind(texture);
+    glTexSubImage3D(
+        GL_TEXTURE_2D_ARRAY, 0, 0, 0, first_layer, width, height, layer_count,
+        GL_BGRA, GL_UNSIGNED_BYTE, data);
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    GFX_GL_CheckError();
+}
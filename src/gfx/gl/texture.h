@@ -15,3 +15,9 @@ void GFX_GL_Texture_Close(GFX_GL_Texture *texture);
 void GFX_GL_Texture_Bind(GFX_GL_Texture *texture);
 void GFX_GL_Texture_Load(
     GFX_GL_Texture *texture, const void *data, int width, int height);
+void GFX_GL_Texture_LoadArray(
+    GFX_GL_Texture *texture, const void *data, int width, int height,
+    int layers);
+void GFX_GL_Texture_LoadArrayLayers(
+    GFX_GL_Texture *texture, const void *data, int width, int height,
+    int first_layer, int layer_count);
@@ -29,17 +29,16 @@
 #define MAX_SAVE_SLOTS 16
 #define MAX_LEVEL_NAME_LENGTH 48
 #define NUM_SLOTS 8
+#define MAX_CREATURE_SLOTS 64
 #define MAX_FRAMES 10
 #define MAX_CD_TRACKS 64
 #define MAX_TEXTURES 8192
 #define MAX_TEXTPAGES 128
 #define MAX_SPRITES 512
 #define MAX_FLIP_MAPS 10
-#define MAX_ROOMS_TO_DRAW 100
 #define DEMO_COUNT_MAX 9000
 #define MAX_ITEMS 10240
 #define MAX_SECRETS 16
-#define MAX_SAVEGAME_BUFFER (20 * 1024)
 #define GRAVITY 6
 #define FASTFALL_SPEED 128
 #define LARA_HITPOINTS 1000
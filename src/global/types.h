@@ -1386,6 +1386,10 @@ typedef struct LOT_INFO {
     int16_t target_box;
     int16_t required_box;
     PHD_VECTOR target;
+    struct BOX_FIELD *field;
+    uint32_t field_id;
+    uint8_t *cluster_mask;
+    uint16_t cluster_search_number;
 } LOT_INFO;
 
 typedef struct FX_INFO {
@@ -1468,7 +1472,8 @@ typedef struct GAME_INFO {
     uint16_t secrets;
     uint8_t pickups;
     uint8_t bonus_flag;
-    char savegame_buffer[MAX_SAVEGAME_BUFFER];
+    char *savegame_buffer;
+    int32_t savegame_buffer_size;
 } GAME_INFO;
 
 typedef struct CREATURE_INFO {
@@ -1891,6 +1896,8 @@ typedef union INPUT_STATE {
         uint32_t camera_left : 1;
         uint32_t camera_right : 1;
         uint32_t camera_reset : 1;
+        uint32_t quick_save : 1;
+        uint32_t quick_load : 1;
     };
 } INPUT_STATE;
 
@@ -102,7 +102,7 @@ PHD_3DPOS g_CinePosition = { 0 };
 int32_t g_NumberCameras = 0;
 int32_t g_NumberSoundEffects = 0;
 OBJECT_VECTOR *g_SoundEffectsTable = NULL;
-int16_t g_RoomsToDraw[MAX_ROOMS_TO_DRAW] = { -1 };
+int16_t *g_RoomsToDraw = NULL;
 int16_t g_RoomsToDrawCount = 0;
 bool g_IsWibbleEffect = false;
 bool g_IsWaterEffect = false;
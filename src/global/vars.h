@@ -92,7 +92,7 @@ extern PHD_3DPOS g_CinePosition;
 extern int32_t g_NumberCameras;
 extern int32_t g_NumberSoundEffects;
 extern OBJECT_VECTOR *g_SoundEffectsTable;
-extern int16_t g_RoomsToDraw[MAX_ROOMS_TO_DRAW];
+extern int16_t *g_RoomsToDraw;
 extern int16_t g_RoomsToDrawCount;
 extern bool g_IsWibbleEffect;
 extern bool g_IsWaterEffect;
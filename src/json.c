@@ -581,9 +581,37 @@ int json_get_object_size(struct json_parse_state_s *state, int is_global_object)
 
     state->dom_size += sizeof(struct json_object_element_s) * elements;
 
+    if (json_parse_flags_build_object_index & flags_bitset) {
+        state->dom_size += sizeof(struct json_object_element_s *)
+            * json_get_object_index_size(elements);
+    }
+
     return 0;
 }
 
+size_t json_get_object_index_size(size_t elements)
+{
+    /* keep the table at most half full, so that the probes stay short and
+     * always reach an empty slot. */
+    size_t index_size = 1;
+    if (!elements) {
+        return 0;
+    }
+    while (index_size < elements * 2) {
+        index_size *= 2;
+    }
+    return index_size;
+}
+
+size_t json_hash_key(const char *key, size_t key_size)
+{
+    size_t hash = 2166136261u;
+    for (size_t i = 0; i < key_size; i++) {
+        hash = (hash ^ (unsigned char)key[i]) * 16777619u;
+    }
+    return hash;
+}
+
 int json_get_array_size(struct json_parse_state_s *state)
 {
     const size_t flags_bitset = state->flags_bitset;
@@ -1292,6 +1320,34 @@ void json_parse_object(
         object->start = json_null;
     }
 
+    object->index = json_null;
+    object->index_size = 0;
+    if ((json_parse_flags_build_object_index & flags_bitset) && elements) {
+        const size_t index_size = json_get_object_index_size(elements);
+        struct json_object_element_s **index =
+            (struct json_object_element_s **)state->dom;
+        state->dom += sizeof(struct json_object_element_s *) * index_size;
+        memset(index, 0, sizeof(struct json_object_element_s *) * index_size);
+
+        for (struct json_object_element_s *element = object->start; element;
+             element = element->next) {
+            size_t i = json_hash_key(
+                           element->name->string, element->name->string_size)
+                & (index_size - 1);
+            /* the first of the duplicate keys wins, same as with the scan. */
+            while (index[i]
+                   && strcmp(index[i]->name->string, element->name->string)) {
+                i = (i + 1) & (index_size - 1);
+            }
+            if (!index[i]) {
+                index[i] = element;
+            }
+        }
+
+        object->index = index;
+        object->index_size = index_size;
+    }
+
     object->ref_count = 1;
     object->length = elements;
 }
@@ -2945,6 +3001,8 @@ struct json_object_s *json_object_new()
     struct json_object_s *obj = malloc(sizeof(struct json_object_s));
     obj->start = NULL;
     obj->length = 0;
+    obj->index = NULL;
+    obj->index_size = 0;
     return obj;
 }
 
@@ -2981,6 +3039,10 @@ void json_object_append(
         obj->start = elem;
     }
     obj->length++;
+
+    /* the index has no room for new elements, fall back to scanning. */
+    obj->index = NULL;
+    obj->index_size = 0;
 }
 
 void json_object_append_bool(struct json_object_s *obj, const char *key, int b)
@@ -3014,6 +3076,17 @@ struct json_value_s *json_object_get_value(
     if (!obj) {
         return json_null;
     }
+    if (obj->index) {
+        const size_t mask = obj->index_size - 1;
+        size_t i = json_hash_key(key, strlen(key)) & mask;
+        while (obj->index[i]) {
+            if (!strcmp(obj->index[i]->name->string, key)) {
+                return obj->index[i]->value;
+            }
+            i = (i + 1) & mask;
+        }
+        return json_null;
+    }
     struct json_object_element_s *elem = obj->start;
     while (elem) {
         if (!strcmp(elem->name->string, key)) {
@@ -51,6 +51,10 @@ struct json_object_s {
     struct json_object_element_s *start;
     size_t length;
     size_t ref_count;
+    /* open addressing hash table of the elements, or NULL if the object was
+       not parsed with json_parse_flags_build_object_index. */
+    struct json_object_element_s **index;
+    size_t index_size;
 };
 
 struct json_array_element_s {
@@ -165,6 +169,10 @@ enum json_parse_flags_e {
     /* allow multi line string values. */
     json_parse_flags_allow_multi_line_strings = 0x2000,
 
+    /* build a hash table of the members of each object, so that looking them
+       up by key does not need to scan the whole object. */
+    json_parse_flags_build_object_index = 0x4000,
+
     /* allow simplified JSON to be parsed. Simplified JSON is an enabling of a
        set of other parsing options. */
     json_parse_flags_allow_simplified_json =
@@ -240,6 +248,8 @@ int json_get_object_size(
     struct json_parse_state_s *state, int is_global_object);
 int json_get_array_size(struct json_parse_state_s *state);
 int json_get_number_size(struct json_parse_state_s *state);
+size_t json_get_object_index_size(size_t elements);
+size_t json_hash_key(const char *key, size_t key_size);
 
 void json_parse_value(
     struct json_parse_state_s *state, int is_global_object,
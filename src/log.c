@@ -3,45 +3,392 @@
 #include "filesystem.h"
 #include "memory.h"
 
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_thread.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdio.h>
 
-FILE *m_LogHandle = NULL;
+#define LOG_QUEUE_SIZE 256 // must be a power of two
+#define LOG_MESSAGE_SIZE 512
+#define LOG_FLUSH_INTERVAL 50 // in milliseconds
+#define LOG_RATE_LIMIT 20 // messages per call site per window
+#define LOG_RATE_WINDOW 1000 // in milliseconds
+#define LOG_MAX_SITES 256 // must be a power of two
 
-void Log_Init()
+typedef struct LOG_ENTRY {
+    SDL_atomic_t sequence;
+    LOG_LEVEL level;
+    const char *file;
+    int line;
+    const char *func;
+    uint32_t ticks;
+    char message[LOG_MESSAGE_SIZE];
+} LOG_ENTRY;
+
+typedef struct LOG_SITE {
+    const char *file;
+    int line;
+    const char *func;
+    uint32_t window_start;
+    int32_t count;
+    int32_t suppressed;
+} LOG_SITE;
+
+static const char *m_LevelNames[] = {
+    [LOG_LEVEL_DEBUG] = "debug",
+    [LOG_LEVEL_INFO] = "info",
+    [LOG_LEVEL_WARNING] = "warning",
+    [LOG_LEVEL_ERROR] = "error",
+};
+
+static FILE *m_LogHandle = NULL;
+static SDL_atomic_t m_IsRunning;
+static void *m_JSONHandle = NULL;
+static SDL_Thread *m_FlushThread = NULL;
+static SDL_sem *m_Wakeup = NULL;
+
+// bounded multi-producer, single-consumer queue; every entry carries
+// a sequence number that tells whether it is free for the position that
+// a producer wants to write or holds a message the consumer can take
+static LOG_ENTRY m_Queue[LOG_QUEUE_SIZE];
+static SDL_atomic_t m_QueueHead;
+static uint32_t m_QueueTail = 0;
+static SDL_atomic_t m_DroppedCount;
+
+// only touched by whichever thread writes the messages out
+static LOG_SITE m_Sites[LOG_MAX_SITES];
+
+static LOG_ENTRY *Log_AcquireEntry(uint32_t *out_pos);
+static void Log_ReleaseEntry(LOG_ENTRY *entry, uint32_t pos);
+static LOG_SITE *Log_GetSite(const char *file, int line, const char *func);
+static bool Log_CheckRateLimit(const LOG_ENTRY *entry);
+static void Log_WriteJSONString(FILE *fp, const char *str);
+static void Log_WriteEntry(const LOG_ENTRY *entry);
+static void Log_WriteNote(const LOG_ENTRY *entry, const char *fmt, ...);
+static void Log_Flush();
+static void Log_Drain();
+static void Log_DrainSuppressed();
+static int Log_FlushThread(void *arg);
+
+static LOG_ENTRY *Log_AcquireEntry(uint32_t *out_pos)
 {
-    char *full_path = NULL;
-    File_GetFullPath("Tomb1Main.log", &full_path);
-    m_LogHandle = fopen(full_path, "w");
-    Memory_FreePointer(&full_path);
+    uint32_t pos = SDL_AtomicGet(&m_QueueHead);
+    while (true) {
+        LOG_ENTRY *entry = &m_Queue[pos % LOG_QUEUE_SIZE];
+        const int32_t diff =
+            (int32_t)((uint32_t)SDL_AtomicGet(&entry->sequence) - pos);
+        if (diff == 0) {
+            if (SDL_AtomicCAS(&m_QueueHead, (int)pos, (int)(pos + 1))) {
+                *out_pos = pos;
+                return entry;
+            }
+        } else if (diff < 0) {
+            // the queue is full
+            return NULL;
+        }
+        pos = SDL_AtomicGet(&m_QueueHead);
+    }
 }
 
-void Log_Message(
-    const char *file, int line, const char *func, const char *fmt, ...)
+static void Log_ReleaseEntry(LOG_ENTRY *entry, uint32_t pos)
+{
+    SDL_AtomicSet(&entry->sequence, (int)(pos + 1));
+}
+
+static LOG_SITE *Log_GetSite(const char *file, int line, const char *func)
 {
+    uintptr_t hash = (uintptr_t)file ^ ((uintptr_t)line * 2654435761u);
+    for (int i = 0; i < LOG_MAX_SITES; i++) {
+        LOG_SITE *site = &m_Sites[(hash + i) % LOG_MAX_SITES];
+        if (!site->file) {
+            site->file = file;
+            site->line = line;
+            site->func = func;
+            return site;
+        }
+        if (site->file == file && site->line == line) {
+            return site;
+        }
+    }
+    return NULL;
+}
+
+static bool Log_CheckRateLimit(const LOG_ENTRY *entry)
+{
+    LOG_SITE *site = Log_GetSite(entry->file, entry->line, entry->func);
+    if (!site) {
+        return true;
+    }
+
+    if (!site->count || entry->ticks - site->window_start >= LOG_RATE_WINDOW) {
+        if (site->suppressed) {
+            Log_WriteNote(
+                entry, "(%d similar messages suppressed)", site->suppressed);
+        }
+        site->window_start = entry->ticks;
+        site->count = 0;
+        site->suppressed = 0;
+    }
+
+    if (site->count >= LOG_RATE_LIMIT) {
+        site->suppressed++;
+        return false;
+    }
+    site->count++;
+    return true;
+}
+
+static void Log_WriteJSONString(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (const unsigned char *ptr = (const unsigned char *)str; *ptr; ptr++) {
+        switch (*ptr) {
+        case '"':
+            fputs("\\\"", fp);
+            break;
+        case '\\':
+            fputs("\\\\", fp);
+            break;
+        case '\n':
+            fputs("\\n", fp);
+            break;
+        case '\r':
+            fputs("\\r", fp);
+            break;
+        case '\t':
+            fputs("\\t", fp);
+            break;
+        default:
+            if (*ptr < 0x20) {
+                fprintf(fp, "\\u%04x", *ptr);
+            } else {
+                fputc(*ptr, fp);
+            }
+            break;
+        }
+    }
+    fputc('"', fp);
+}
+
+static void Log_WriteEntry(const LOG_ENTRY *entry)
+{
+    printf(
+        "%s %d %s %s\n", entry->file, entry->line, entry->func,
+        entry->message);
+
+    if (m_LogHandle) {
+        fprintf(
+            m_LogHandle, "%s %d %s %s\n", entry->file, entry->line,
+            entry->func, entry->message);
+    }
+
+    FILE *json_handle = SDL_AtomicGetPtr(&m_JSONHandle);
+    if (json_handle) {
+        fprintf(
+            json_handle, "{\"time\":%u,\"level\":\"%s\",\"file\":",
+            entry->ticks, m_LevelNames[entry->level]);
+        Log_WriteJSONString(json_handle, entry->file);
+        fprintf(json_handle, ",\"line\":%d,\"func\":", entry->line);
+        Log_WriteJSONString(json_handle, entry->func);
+        fputs(",\"message\":", json_handle);
+        Log_WriteJSONString(json_handle, entry->message);
+        fputs("}\n", json_handle);
+    }
+}
+
+static void Log_WriteNote(const LOG_ENTRY *entry, const char *fmt, ...)
+{
+    LOG_ENTRY note = *entry;
     va_list va;
     va_start(va, fmt);
+    vsnprintf(note.message, LOG_MESSAGE_SIZE, fmt, va);
+    va_end(va);
+    Log_WriteEntry(&note);
+}
 
-    // print to stdout
-    printf("%s %d %s ", file, line, func);
-    vprintf(fmt, va);
-    printf("\n");
+static void Log_Flush()
+{
     fflush(stdout);
-
     if (m_LogHandle) {
-        // now print the same to the log file
-        fprintf(m_LogHandle, "%s %d %s ", file, line, func);
-        vfprintf(m_LogHandle, fmt, va);
-        fprintf(m_LogHandle, "\n");
         fflush(m_LogHandle);
     }
+    FILE *json_handle = SDL_AtomicGetPtr(&m_JSONHandle);
+    if (json_handle) {
+        fflush(json_handle);
+    }
+}
 
-    va_end(va);
+static void Log_Drain()
+{
+    bool written = false;
+
+    const int32_t dropped = SDL_AtomicSet(&m_DroppedCount, 0);
+    if (dropped) {
+        const LOG_ENTRY note = {
+            .level = LOG_LEVEL_WARNING,
+            .file = __FILE__,
+            .line = __LINE__,
+            .func = __func__,
+            .ticks = SDL_GetTicks(),
+        };
+        Log_WriteNote(
+            &note, "(%d messages dropped, the log queue was full)", dropped);
+        written = true;
+    }
+
+    while (true) {
+        LOG_ENTRY *entry = &m_Queue[m_QueueTail % LOG_QUEUE_SIZE];
+        if ((uint32_t)SDL_AtomicGet(&entry->sequence) != m_QueueTail + 1) {
+            break;
+        }
+        if (Log_CheckRateLimit(entry)) {
+            Log_WriteEntry(entry);
+            written = true;
+        }
+        SDL_AtomicSet(&entry->sequence, (int)(m_QueueTail + LOG_QUEUE_SIZE));
+        m_QueueTail++;
+    }
+
+    if (written) {
+        Log_Flush();
+    }
+}
+
+static void Log_DrainSuppressed()
+{
+    for (int i = 0; i < LOG_MAX_SITES; i++) {
+        LOG_SITE *site = &m_Sites[i];
+        if (!site->suppressed) {
+            continue;
+        }
+        const LOG_ENTRY note = {
+            .level = LOG_LEVEL_INFO,
+            .file = site->file,
+            .line = site->line,
+            .func = site->func,
+            .ticks = SDL_GetTicks(),
+        };
+        Log_WriteNote(
+            &note, "(%d similar messages suppressed)", site->suppressed);
+        site->suppressed = 0;
+    }
+    Log_Flush();
+}
+
+static int Log_FlushThread(void *arg)
+{
+    while (SDL_AtomicGet(&m_IsRunning)) {
+        SDL_SemWaitTimeout(m_Wakeup, LOG_FLUSH_INTERVAL);
+        Log_Drain();
+    }
+    Log_Drain();
+    Log_DrainSuppressed();
+    return 0;
+}
+
+void Log_Init()
+{
+    char *full_path = NULL;
+    File_GetFullPath("Tomb1Main.log", &full_path);
+    m_LogHandle = fopen(full_path, "w");
+    Memory_FreePointer(&full_path);
+
+    for (int i = 0; i < LOG_QUEUE_SIZE; i++) {
+        SDL_AtomicSet(&m_Queue[i].sequence, i);
+    }
+    SDL_AtomicSet(&m_QueueHead, 0);
+    SDL_AtomicSet(&m_DroppedCount, 0);
+    m_QueueTail = 0;
+
+    m_Wakeup = SDL_CreateSemaphore(0);
+    if (!m_Wakeup) {
+        return;
+    }
+    SDL_AtomicSet(&m_IsRunning, 1);
+    m_FlushThread = SDL_CreateThread(Log_FlushThread, "log", NULL);
+    if (!m_FlushThread) {
+        SDL_AtomicSet(&m_IsRunning, 0);
+        SDL_DestroySemaphore(m_Wakeup);
+        m_Wakeup = NULL;
+    }
 }
 
 void Log_Shutdown()
 {
+    if (m_FlushThread) {
+        SDL_AtomicSet(&m_IsRunning, 0);
+        SDL_SemPost(m_Wakeup);
+        SDL_WaitThread(m_FlushThread, NULL);
+        m_FlushThread = NULL;
+    }
+    if (m_Wakeup) {
+        SDL_DestroySemaphore(m_Wakeup);
+        m_Wakeup = NULL;
+    }
+
+    FILE *json_handle = SDL_AtomicSetPtr(&m_JSONHandle, NULL);
+    if (json_handle) {
+        fclose(json_handle);
+    }
     if (m_LogHandle) {
         fclose(m_LogHandle);
+        m_LogHandle = NULL;
+    }
+}
+
+void Log_EnableJSONLines()
+{
+    if (SDL_AtomicGetPtr(&m_JSONHandle)) {
+        return;
+    }
+
+    char *full_path = NULL;
+    File_GetFullPath("Tomb1Main.log.jsonl", &full_path);
+    FILE *json_handle = fopen(full_path, "w");
+    Memory_FreePointer(&full_path);
+    if (json_handle) {
+        SDL_AtomicSetPtr(&m_JSONHandle, json_handle);
+    }
+}
+
+void Log_Message(
+    LOG_LEVEL level, const char *file, int line, const char *func,
+    const char *fmt, ...)
+{
+    uint32_t pos = 0;
+    LOG_ENTRY *entry = NULL;
+    LOG_ENTRY local_entry;
+
+    const bool is_running = SDL_AtomicGet(&m_IsRunning);
+    if (is_running) {
+        entry = Log_AcquireEntry(&pos);
+        if (!entry) {
+            SDL_AtomicIncRef(&m_DroppedCount);
+            return;
+        }
+    } else {
+        entry = &local_entry;
+    }
+
+    entry->level = level;
+    entry->file = file;
+    entry->line = line;
+    entry->func = func;
+    entry->ticks = SDL_GetTicks();
+
+    va_list va;
+    va_start(va, fmt);
+    vsnprintf(entry->message, LOG_MESSAGE_SIZE, fmt, va);
+    va_end(va);
+
+    if (is_running) {
+        Log_ReleaseEntry(entry, pos);
+        if (level >= LOG_LEVEL_ERROR) {
+            SDL_SemPost(m_Wakeup);
+        }
+    } else {
+        Log_WriteEntry(entry);
+        Log_Flush();
     }
 }
@@ -1,10 +1,42 @@
 #pragma once
 
-#define LOG_INFO(...) Log_Message(__FILE__, __LINE__, __func__, __VA_ARGS__)
-#define LOG_WARNING(...) Log_Message(__FILE__, __LINE__, __func__, __VA_ARGS__)
-#define LOG_ERROR(...) Log_Message(__FILE__, __LINE__, __func__, __VA_ARGS__)
-#define LOG_DEBUG(...) Log_Message(__FILE__, __LINE__, __func__, __VA_ARGS__)
+#include <stdbool.h>
 
+typedef enum LOG_LEVEL {
+    LOG_LEVEL_DEBUG = 0,
+    LOG_LEVEL_INFO = 1,
+    LOG_LEVEL_WARNING = 2,
+    LOG_LEVEL_ERROR = 3,
+} LOG_LEVEL;
+
+// Messages below this level are compiled out entirely. Can be overridden
+// with, for example, -DLOG_MIN_LEVEL=LOG_LEVEL_INFO.
+#ifndef LOG_MIN_LEVEL
+    #define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_MESSAGE(level, ...)                                                \
+    do {                                                                       \
+        if ((level) >= LOG_MIN_LEVEL) {                                        \
+            Log_Message(level, __FILE__, __LINE__, __func__, __VA_ARGS__);     \
+        }                                                                      \
+    } while (0)
+
+#define LOG_INFO(...) LOG_MESSAGE(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_MESSAGE(LOG_LEVEL_WARNING, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_MESSAGE(LOG_LEVEL_ERROR, __VA_ARGS__)
+#define LOG_DEBUG(...) LOG_MESSAGE(LOG_LEVEL_DEBUG, __VA_ARGS__)
+
+// Messages are formatted on the calling thread and handed over to a
+// background thread that writes them out, so logging never waits on the
+// console or the disk. Messages logged before Log_Init or after Log_Shutdown
+// are written out directly.
 void Log_Init();
+void Log_Shutdown();
+
+// Additionally writes every message as a line of JSON to Tomb1Main.log.jsonl.
+void Log_EnableJSONLines();
+
 void Log_Message(
-    const char *file, int line, const char *func, const char *fmt, ...);
+    LOG_LEVEL level, const char *file, int line, const char *func,
+    const char *fmt, ...);
@@ -23,8 +23,21 @@ bool S_Audio_StreamSoundSetFinishCallback(
     void *user_data);
 
 bool S_Audio_SamplesClear();
+// Stops and frees the current samples to make room for count new ones.
+// This must happen on the main thread; the samples themselves may then be
+// loaded on any thread, as long as nothing plays them until that is done.
+bool S_Audio_SamplesPrepare(size_t count);
 bool S_Audio_SamplesLoad(size_t count, const char **contents, size_t *sizes);
 
+// Access to the decoded samples, so that they can be stored and loaded back
+// without decoding them again. The data is interleaved 32-bit float PCM at
+// the working sample rate.
+bool S_Audio_SampleGetData(
+    int sample_id, const float **data, int *channels, int *num_samples);
+bool S_Audio_SamplesLoadData(
+    size_t count, const float **data, const int *channels,
+    const int *num_samples);
+
 int S_Audio_SampleSoundPlay(
     int sample_id, int volume, float pitch, int pan, bool is_looped);
 bool S_Audio_SampleSoundIsPlaying(int sound_id);
@@ -4,6 +4,7 @@
 #include "game/shell.h"
 #include "log.h"
 #include "memory.h"
+#include "specific/s_job.h"
 #include "util.h"
 
 #include <libavcodec/avcodec.h>
@@ -33,6 +34,12 @@ typedef struct AUDIO_SAMPLE_SOUND {
     AUDIO_SAMPLE *sample;
 } AUDIO_SAMPLE_SOUND;
 
+typedef struct AUDIO_SAMPLE_LOAD_WORK {
+    const char **contents;
+    size_t *sizes;
+    SDL_atomic_t failed_count;
+} AUDIO_SAMPLE_LOAD_WORK;
+
 typedef struct AUDIO_AV_BUFFER {
     const char *data;
     const char *ptr;
@@ -65,6 +72,9 @@ static bool S_Audio_SampleRecalculateChannelVolumes(int sound_id)
     return true;
 }
 
+static void S_Audio_SampleLoadJob(void *arg, int32_t sample_id);
+static void S_Audio_SamplesFree();
+
 static int S_Audio_ReadAVBuffer(void *opaque, uint8_t *dst, int dst_size)
 {
     AUDIO_AV_BUFFER *src = opaque;
@@ -334,6 +344,15 @@ fail:
     return false;
 }
 
+static void S_Audio_SampleLoadJob(void *arg, int32_t sample_id)
+{
+    AUDIO_SAMPLE_LOAD_WORK *work = arg;
+    if (!S_Audio_SampleLoad(
+            sample_id, work->contents[sample_id], work->sizes[sample_id])) {
+        SDL_AtomicAdd(&work->failed_count, 1);
+    }
+}
+
 void S_Audio_SampleSoundInit()
 {
     for (int sound_id = 0; sound_id < AUDIO_MAX_ACTIVE_SAMPLES; sound_id++) {
@@ -364,15 +383,20 @@ bool S_Audio_SamplesClear()
     }
 
     S_Audio_SampleSoundCloseAll();
+    S_Audio_SamplesFree();
 
-    for (int i = 0; i < AUDIO_MAX_ACTIVE_SAMPLES; i++) {
+    return true;
+}
+
+static void S_Audio_SamplesFree()
+{
+    m_LoadedSamplesCount = 0;
+    for (int i = 0; i < AUDIO_MAX_SAMPLES; i++) {
         Memory_FreePointer(&m_LoadedSamples[i].sample_data);
     }
-
-    return true;
 }
 
-bool S_Audio_SamplesLoad(size_t count, const char **contents, size_t *sizes)
+bool S_Audio_SamplesPrepare(size_t count)
 {
     if (!g_AudioDeviceID) {
         return false;
@@ -386,20 +410,71 @@ bool S_Audio_SamplesLoad(size_t count, const char **contents, size_t *sizes)
     }
 
     S_Audio_SamplesClear();
+    return true;
+}
 
-    bool result = true;
-    for (int sample_id = 0; sample_id < (int)count; sample_id++) {
-        result &= S_Audio_SampleLoad(
-            sample_id, contents[sample_id], sizes[sample_id]);
+bool S_Audio_SamplesLoad(size_t count, const char **contents, size_t *sizes)
+{
+    if (!g_AudioDeviceID || count > AUDIO_MAX_SAMPLES) {
+        return false;
     }
+
+    // every sample is decoded into its own slot, so they can be decoded in
+    // parallel
+    AUDIO_SAMPLE_LOAD_WORK work = {
+        .contents = contents,
+        .sizes = sizes,
+    };
+    SDL_AtomicSet(&work.failed_count, 0);
+    S_Job_ParallelFor(S_Audio_SampleLoadJob, &work, count);
+
+    const bool result = SDL_AtomicGet(&work.failed_count) == 0;
     if (result) {
         m_LoadedSamplesCount = count;
     } else {
-        S_Audio_SamplesClear();
+        S_Audio_SamplesFree();
     }
     return result;
 }
 
+bool S_Audio_SampleGetData(
+    int sample_id, const float **data, int *channels, int *num_samples)
+{
+    if (sample_id < 0 || sample_id >= m_LoadedSamplesCount) {
+        return false;
+    }
+
+    const AUDIO_SAMPLE *sample = &m_LoadedSamples[sample_id];
+    if (!sample->sample_data) {
+        return false;
+    }
+    *data = sample->sample_data;
+    *channels = sample->channels;
+    *num_samples = sample->num_samples;
+    return true;
+}
+
+bool S_Audio_SamplesLoadData(
+    size_t count, const float **data, const int *channels,
+    const int *num_samples)
+{
+    if (!g_AudioDeviceID || count > AUDIO_MAX_SAMPLES) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        AUDIO_SAMPLE *sample = &m_LoadedSamples[i];
+        const size_t size = num_samples[i] * channels[i] * sizeof(float);
+        sample->sample_data = Memory_Alloc(size);
+        memcpy(sample->sample_data, data[i], size);
+        sample->channels = channels[i];
+        sample->num_samples = num_samples[i];
+    }
+
+    m_LoadedSamplesCount = count;
+    return true;
+}
+
 int S_Audio_SampleSoundPlay(
     int sample_id, int volume, float pitch, int pan, bool is_looped)
 {
@@ -3,14 +3,20 @@
 #include "log.h"
 
 #include <assert.h>
+#include <errno.h>
 #include <SDL2/SDL.h>
 #include <string.h>
 
 #if defined(_WIN32)
     #include <direct.h>
+    #include <io.h>
+    #include <windows.h>
 #else
+    #include <fcntl.h>
+    #include <sys/mman.h>
     #include <sys/types.h>
     #include <sys/stat.h>
+    #include <unistd.h>
 #endif
 
 const char *m_GameDir = NULL;
@@ -36,3 +42,106 @@ void S_File_CreateDirectory(const char *path)
     mkdir(path, 0664);
 #endif
 }
+
+void *S_File_Map(const char *path, size_t *out_size)
+{
+    assert(path);
+    assert(out_size);
+    void *data = NULL;
+    *out_size = 0;
+
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(
+        path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+
+    LARGE_INTEGER size;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        HANDLE mapping =
+            CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+        if (mapping) {
+            // the view keeps the mapping alive after the handles are closed
+            data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        if (data) {
+            *out_size = size.QuadPart;
+        } else {
+            LOG_ERROR("Can't map file %s: %lu", path, GetLastError());
+        }
+    }
+    CloseHandle(file);
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(
+            NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            LOG_ERROR("Can't map file %s: %s", path, strerror(errno));
+            data = NULL;
+        } else {
+            *out_size = st.st_size;
+        }
+    }
+    close(fd);
+#endif
+
+    return data;
+}
+
+void S_File_Unmap(void *data, size_t size)
+{
+    if (!data) {
+        return;
+    }
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+#else
+    munmap(data, size);
+#endif
+}
+
+bool S_File_Sync(FILE *fp)
+{
+    assert(fp);
+    if (fflush(fp)) {
+        return false;
+    }
+#if defined(_WIN32)
+    return _commit(_fileno(fp)) == 0;
+#else
+    return fsync(fileno(fp)) == 0;
+#endif
+}
+
+bool S_File_Replace(const char *src_path, const char *dst_path)
+{
+    assert(src_path);
+    assert(dst_path);
+#if defined(_WIN32)
+    if (!MoveFileExA(
+            src_path, dst_path,
+            MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+        LOG_ERROR(
+            "Can't move file %s to %s: %lu", src_path, dst_path,
+            GetLastError());
+        return false;
+    }
+#else
+    if (rename(src_path, dst_path)) {
+        LOG_ERROR(
+            "Can't move file %s to %s: %s", src_path, dst_path,
+            strerror(errno));
+        return false;
+    }
+#endif
+    return true;
+}
@@ -1,4 +1,20 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
 const char *S_File_GetGameDirectory();
 void S_File_CreateDirectory(const char *path);
+
+// Maps the whole file into memory as a private copy-on-write view, so that
+// the contents can be patched in place without touching the file on disk.
+// Returns NULL if the file cannot be mapped.
+void *S_File_Map(const char *path, size_t *out_size);
+void S_File_Unmap(void *data, size_t size);
+
+// Makes sure that everything written to the file so far reached the disk.
+bool S_File_Sync(FILE *fp);
+
+// Moves the file over the target path, replacing the target in one step.
+bool S_File_Replace(const char *src_path, const char *dst_path);
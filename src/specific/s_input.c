@@ -492,6 +492,8 @@ INPUT_STATE S_Input_GetCurrentState()
     if (!g_ModeLock && g_Camera.type != CAM_CINEMATIC) {
         linput.save = KEY_DOWN(DIK_F5);
         linput.load = KEY_DOWN(DIK_F6);
+        linput.quick_save = KEY_DOWN(DIK_F7);
+        linput.quick_load = KEY_DOWN(DIK_F8);
     }
 
     if (KEY_DOWN(DIK_F3)) {
@@ -0,0 +1,119 @@
+#include "specific/s_job.h"
+
+#include "log.h"
+#include "memory.h"
+#include "util.h"
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_thread.h>
+#include <assert.h>
+#include <stdbool.h>
+
+#define S_JOB_MAX_WORKERS 8
+
+typedef struct S_JOB_PARALLEL_FOR {
+    void (*func)(void *arg, int32_t index);
+    void *arg;
+    int32_t count;
+    SDL_atomic_t next_index;
+} S_JOB_PARALLEL_FOR;
+
+struct S_JOB {
+    void (*func)(void *arg);
+    void *arg;
+    SDL_Thread *thread;
+    SDL_atomic_t is_done;
+};
+
+static void S_Job_RunParallelFor(S_JOB_PARALLEL_FOR *work);
+static int S_Job_ParallelForWorker(void *arg);
+static int S_Job_Worker(void *arg);
+
+static void S_Job_RunParallelFor(S_JOB_PARALLEL_FOR *work)
+{
+    while (true) {
+        const int32_t index = SDL_AtomicAdd(&work->next_index, 1);
+        if (index >= work->count) {
+            break;
+        }
+        work->func(work->arg, index);
+    }
+}
+
+static int S_Job_ParallelForWorker(void *arg)
+{
+    S_Job_RunParallelFor(arg);
+    return 0;
+}
+
+static int S_Job_Worker(void *arg)
+{
+    S_JOB *job = arg;
+    job->func(job->arg);
+    SDL_AtomicSet(&job->is_done, 1);
+    return 0;
+}
+
+void S_Job_ParallelFor(
+    void (*func)(void *arg, int32_t index), void *arg, int32_t count)
+{
+    assert(func);
+
+    S_JOB_PARALLEL_FOR work = {
+        .func = func,
+        .arg = arg,
+        .count = count,
+    };
+    SDL_AtomicSet(&work.next_index, 0);
+
+    SDL_Thread *workers[S_JOB_MAX_WORKERS];
+    int32_t worker_count = MIN(SDL_GetCPUCount(), count) - 1;
+    CLAMP(worker_count, 0, S_JOB_MAX_WORKERS);
+    for (int i = 0; i < worker_count; i++) {
+        workers[i] =
+            SDL_CreateThread(S_Job_ParallelForWorker, "parallel_for", &work);
+        if (!workers[i]) {
+            LOG_ERROR("SDL_CreateThread(): %s", SDL_GetError());
+            worker_count = i;
+            break;
+        }
+    }
+
+    S_Job_RunParallelFor(&work);
+    for (int i = 0; i < worker_count; i++) {
+        SDL_WaitThread(workers[i], NULL);
+    }
+}
+
+S_JOB *S_Job_Start(void (*func)(void *arg), void *arg, const char *name)
+{
+    assert(func);
+
+    S_JOB *job = Memory_Alloc(sizeof(S_JOB));
+    job->func = func;
+    job->arg = arg;
+    SDL_AtomicSet(&job->is_done, 0);
+    job->thread = SDL_CreateThread(S_Job_Worker, name, job);
+    if (!job->thread) {
+        LOG_ERROR("SDL_CreateThread(): %s", SDL_GetError());
+        func(arg);
+        SDL_AtomicSet(&job->is_done, 1);
+    }
+    return job;
+}
+
+void S_Job_Wait(S_JOB *job)
+{
+    if (!job) {
+        return;
+    }
+    if (job->thread) {
+        SDL_WaitThread(job->thread, NULL);
+    }
+    Memory_FreePointer(&job);
+}
+
+bool S_Job_IsDone(S_JOB *job)
+{
+    return !job || SDL_AtomicGet(&job->is_done);
+}
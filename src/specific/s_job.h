@@ -0,0 +1,20 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct S_JOB S_JOB;
+
+// Calls the function for every index from 0 to count - 1, spreading the calls
+// across worker threads. The calling thread takes part too and the function
+// returns once all of the calls are done.
+void S_Job_ParallelFor(
+    void (*func)(void *arg, int32_t index), void *arg, int32_t count);
+
+// Runs the function on a background thread. If the thread cannot be created,
+// the function runs right away on the calling thread instead.
+S_JOB *S_Job_Start(void (*func)(void *arg), void *arg, const char *name);
+void S_Job_Wait(S_JOB *job);
+
+// Returns true once the function started with S_Job_Start has returned.
+bool S_Job_IsDone(S_JOB *job);
@@ -15,10 +15,14 @@
 #include "global/vars_platform.h"
 #include "log.h"
 #include "memory.h"
+#include "specific/s_texture.h"
 
 #include <assert.h>
+#include <string.h>
 
 #define CLIP_VERTCOUNT_SCALE 4
+#define TEXTURE_PAGE_WIDTH 256
+#define TEXTURE_PAGE_HEIGHT 256
 
 #define S_Output_CheckError(result)                                            \
     {                                                                          \
@@ -37,6 +41,7 @@ static bool m_IsRendering = false;
 static bool m_IsRenderingOld = false;
 static bool m_IsTextureMode = false;
 static int32_t m_SelectedTexture = -1;
+static bool m_IsTextureArrayLoaded = false;
 
 static int32_t m_SurfaceWidth = 0;
 static int32_t m_SurfaceHeight = 0;
@@ -47,15 +52,22 @@ static float m_SurfaceMaxY = 0.0f;
 static GFX_2D_Surface *m_PrimarySurface = NULL;
 static GFX_2D_Surface *m_BackSurface = NULL;
 static GFX_2D_Surface *m_PictureSurface = NULL;
-static GFX_2D_Surface *m_TextureSurfaces[GFX_MAX_TEXTURES] = { NULL };
+static uint64_t m_TextureKeys[GFX_MAX_TEXTURES] = { 0 };
+static int32_t m_TexturePageCount = 0;
 
 static void S_Output_SetHardwareVideoMode();
 static void S_Output_SetupRenderContextAndRender();
 static void S_Output_ReleaseTextures();
+static bool S_Output_UpdateTextures(
+    int32_t pages, const uint32_t *page_data, const uint64_t *page_keys);
 static void S_Output_ReleaseSurfaces();
 static void S_Output_FlipPrimaryBuffer();
 static void S_Output_ClearSurface(GFX_2D_Surface *surface);
-static void S_Output_DrawTriangleStrip(GFX_3D_Vertex *vertices, int num);
+static void S_Output_DrawTriangleFan(GFX_3D_Vertex *vertices, int num);
+static void S_Output_SetRoomVertex(
+    GFX_3D_RoomVertex *vertex, const int16_t *room_vertices,
+    int32_t vertex_count, int16_t vertex_num, const PHD_TEXTURE *texture,
+    int32_t corner);
 static int32_t S_Output_ClipVertices(int32_t num, GFX_3D_Vertex *source);
 static int32_t S_Output_ClipVertices2(int32_t num, GFX_3D_Vertex *source);
 static int32_t S_Output_ZedClipper(
@@ -63,6 +75,17 @@ static int32_t S_Output_ZedClipper(
 
 static void S_Output_ReleaseTextures()
 {
+    m_TexturePageCount = 0;
+
+    if (m_IsTextureArrayLoaded) {
+        GFX_3D_Renderer_TextureArrayUnreg(m_Renderer3D);
+        m_IsTextureArrayLoaded = false;
+        for (int i = 0; i < GFX_MAX_TEXTURES; i++) {
+            m_TextureMap[i] = GFX_NO_TEXTURE;
+        }
+        return;
+    }
+
     for (int i = 0; i < GFX_MAX_TEXTURES; i++) {
         if (m_TextureMap[i] != GFX_NO_TEXTURE) {
             GFX_3D_Renderer_TextureUnreg(m_Renderer3D, m_TextureMap[i]);
@@ -71,6 +94,56 @@ static void S_Output_ReleaseTextures()
     }
 }
 
+static bool S_Output_UpdateTextures(
+    int32_t pages, const uint32_t *page_data, const uint64_t *page_keys)
+{
+    // only the pages that changed since the last download are uploaded, as
+    // long as the number of pages and the kind of textures stay the same
+    if (pages != m_TexturePageCount || !pages) {
+        return false;
+    }
+    if (g_Config.rendering.enable_texture_array != m_IsTextureArrayLoaded) {
+        return false;
+    }
+
+    const int32_t page_size = TEXTURE_PAGE_WIDTH * TEXTURE_PAGE_HEIGHT;
+    int32_t changed_pages = 0;
+
+    if (m_IsTextureArrayLoaded) {
+        // neighbouring layers are uploaded together
+        int32_t first = -1;
+        for (int i = 0; i <= pages; i++) {
+            const bool is_changed =
+                i < pages && page_keys[i] != m_TextureKeys[i];
+            if (is_changed && first == -1) {
+                first = i;
+            } else if (!is_changed && first != -1) {
+                GFX_3D_Renderer_TextureArrayUpdate(
+                    m_Renderer3D, &page_data[first * page_size],
+                    TEXTURE_PAGE_WIDTH, TEXTURE_PAGE_HEIGHT, first, i - first);
+                changed_pages += i - first;
+                first = -1;
+            }
+        }
+    } else {
+        for (int i = 0; i < pages; i++) {
+            if (page_keys[i] == m_TextureKeys[i]) {
+                continue;
+            }
+            if (m_TextureMap[i] != GFX_NO_TEXTURE) {
+                GFX_3D_Renderer_TextureUnreg(m_Renderer3D, m_TextureMap[i]);
+            }
+            m_TextureMap[i] = GFX_3D_Renderer_TextureReg(
+                m_Renderer3D, &page_data[i * page_size], TEXTURE_PAGE_WIDTH,
+                TEXTURE_PAGE_HEIGHT);
+            changed_pages++;
+        }
+    }
+
+    LOG_INFO("uploaded %d of %d texture pages", changed_pages, pages);
+    return true;
+}
+
 static void S_Output_SetHardwareVideoMode()
 {
     S_Output_ReleaseSurfaces();
@@ -98,14 +171,6 @@ static void S_Output_SetHardwareVideoMode()
         S_Output_ClearSurface(m_PrimarySurface);
     }
 
-    for (int i = 0; i < GFX_MAX_TEXTURES; i++) {
-        GFX_2D_SurfaceDesc surface_desc = {
-            .width = 256,
-            .height = 256,
-        };
-        m_TextureSurfaces[i] = GFX_2D_Surface_Create(&surface_desc);
-    }
-
     S_Output_SetupRenderContextAndRender();
 }
 
@@ -114,13 +179,13 @@ static void S_Output_SetupRenderContextAndRender()
     S_Output_RenderBegin();
     GFX_3D_Renderer_SetSmoothingEnabled(
         m_Renderer3D, g_Config.rendering.enable_bilinear_filter);
+    GFX_3D_Renderer_SetBatchingEnabled(
+        m_Renderer3D, g_Config.rendering.enable_draw_batching);
     S_Output_RenderToggle();
 }
 
 static void S_Output_ReleaseSurfaces()
 {
-    int i;
-
     if (m_PrimarySurface) {
         S_Output_ClearSurface(m_PrimarySurface);
         S_Output_ClearSurface(m_BackSurface);
@@ -130,13 +195,6 @@ static void S_Output_ReleaseSurfaces()
         m_BackSurface = NULL;
     }
 
-    for (i = 0; i < GFX_MAX_TEXTURES; i++) {
-        if (m_TextureSurfaces[i]) {
-            GFX_2D_Surface_Free(m_TextureSurfaces[i]);
-            m_TextureSurfaces[i] = NULL;
-        }
-    }
-
     if (m_PictureSurface) {
         GFX_2D_Surface_Free(m_PictureSurface);
         m_PictureSurface = NULL;
@@ -159,15 +217,28 @@ static void S_Output_ClearSurface(GFX_2D_Surface *surface)
     S_Output_CheckError(result);
 }
 
-static void S_Output_DrawTriangleStrip(GFX_3D_Vertex *vertices, int num)
+static void S_Output_DrawTriangleFan(GFX_3D_Vertex *vertices, int num)
 {
-    GFX_3D_Renderer_RenderPrimStrip(m_Renderer3D, vertices, 3);
-    int left = num - 2;
-    for (int i = num - 3; i > 0; i--) {
-        memcpy(&vertices[1], &vertices[2], left * sizeof(GFX_3D_Vertex));
-        GFX_3D_Renderer_RenderPrimStrip(m_Renderer3D, vertices, 3);
-        left--;
-    }
+    GFX_3D_Renderer_RenderPrimFan(m_Renderer3D, vertices, num);
+}
+
+static void S_Output_SetRoomVertex(
+    GFX_3D_RoomVertex *vertex, const int16_t *room_vertices,
+    int32_t vertex_count, int16_t vertex_num, const PHD_TEXTURE *texture,
+    int32_t corner)
+{
+    const int16_t *obj_ptr = &room_vertices[vertex_num * 4];
+    vertex->x = obj_ptr[0];
+    vertex->y = obj_ptr[1];
+    vertex->z = obj_ptr[2];
+    vertex->shade = obj_ptr[3];
+    vertex->u = ((texture->uv[corner].u1 & 0xFF00) + 127) * 0.00390625f
+        * 0.00390625f;
+    vertex->v = ((texture->uv[corner].v1 & 0xFF00) + 127) * 0.00390625f
+        * 0.00390625f;
+    vertex->layer = m_TextureMap[texture->tpage];
+    vertex->water_rand =
+        (uint8_t)g_RandTable[(vertex_count - vertex_num) % WIBBLE_SIZE];
 }
 
 static int32_t S_Output_ClipVertices(int32_t num, GFX_3D_Vertex *source)
@@ -816,7 +887,11 @@ void S_Output_SelectTexture(int tex_num)
         return;
     }
 
-    GFX_3D_Renderer_SelectTexture(m_Renderer3D, m_TextureMap[tex_num]);
+    if (m_IsTextureArrayLoaded) {
+        GFX_3D_Renderer_SelectTextureLayer(m_Renderer3D, m_TextureMap[tex_num]);
+    } else {
+        GFX_3D_Renderer_SelectTexture(m_Renderer3D, m_TextureMap[tex_num]);
+    }
     m_SelectedTexture = tex_num;
 }
 
@@ -903,10 +978,10 @@ void S_Output_DrawSprite(
     if (m_TextureMap[sprite->tpage] != GFX_NO_TEXTURE) {
         S_Output_EnableTextureMode();
         S_Output_SelectTexture(sprite->tpage);
-        S_Output_DrawTriangleStrip(vertices, vertex_count);
+        S_Output_DrawTriangleFan(vertices, vertex_count);
     } else {
         S_Output_DisableTextureMode();
-        S_Output_DrawTriangleStrip(vertices, vertex_count);
+        S_Output_DrawTriangleFan(vertices, vertex_count);
     }
 }
 
@@ -972,7 +1047,7 @@ void S_Output_Draw2DQuad(
 
     S_Output_DisableTextureMode();
 
-    S_Output_DrawTriangleStrip(vertices, 4);
+    S_Output_DrawTriangleFan(vertices, 4);
 }
 
 void S_Output_DrawTranslucentQuad(
@@ -1015,7 +1090,7 @@ void S_Output_DrawTranslucentQuad(
     S_Output_DisableTextureMode();
 
     GFX_3D_Renderer_SetBlendingEnabled(m_Renderer3D, true);
-    S_Output_DrawTriangleStrip(vertices, 4);
+    S_Output_DrawTriangleFan(vertices, 4);
     GFX_3D_Renderer_SetBlendingEnabled(m_Renderer3D, false);
 }
 
@@ -1062,7 +1137,7 @@ void S_Output_DrawLightningSegment(
 
     int num = S_Output_ClipVertices(4, vertices);
     if (num) {
-        S_Output_DrawTriangleStrip(vertices, num);
+        S_Output_DrawTriangleFan(vertices, num);
     }
 
     vertices[0].x = thickness1 / 2 + x1;
@@ -1099,7 +1174,7 @@ void S_Output_DrawLightningSegment(
 
     num = S_Output_ClipVertices(4, vertices);
     if (num) {
-        S_Output_DrawTriangleStrip(vertices, num);
+        S_Output_DrawTriangleFan(vertices, num);
     }
     GFX_3D_Renderer_SetBlendingEnabled(m_Renderer3D, false);
 }
@@ -1136,7 +1211,7 @@ void S_Output_DrawShadow(PHD_VBUF *vbufs, int clip, int vertex_count)
     S_Output_DisableTextureMode();
 
     GFX_3D_Renderer_SetBlendingEnabled(m_Renderer3D, true);
-    S_Output_DrawTriangleStrip(vertices, vertex_count);
+    S_Output_DrawTriangleFan(vertices, vertex_count);
     GFX_3D_Renderer_SetBlendingEnabled(m_Renderer3D, false);
 }
 
@@ -1165,7 +1240,6 @@ bool S_Output_Init()
 {
     for (int i = 0; i < GFX_MAX_TEXTURES; i++) {
         m_TextureMap[i] = GFX_NO_TEXTURE;
-        m_TextureSurfaces[i] = NULL;
     }
 
     GFX_Context_Attach(g_TombHWND);
@@ -1182,6 +1256,7 @@ void S_Output_Shutdown()
 {
     S_Output_ReleaseTextures();
     S_Output_ReleaseSurfaces();
+    S_Texture_ClearCache();
     GFX_Context_Detach();
     m_Renderer3D = NULL;
 }
@@ -1245,7 +1320,7 @@ void S_Output_DrawFlatTriangle(
         return;
     }
 
-    S_Output_DrawTriangleStrip(vertices, vertex_count);
+    S_Output_DrawTriangleFan(vertices, vertex_count);
 }
 
 void S_Output_DrawTexturedTriangle(
@@ -1333,10 +1408,10 @@ void S_Output_DrawTexturedTriangle(
     if (m_TextureMap[tpage] != GFX_NO_TEXTURE) {
         S_Output_EnableTextureMode();
         S_Output_SelectTexture(tpage);
-        S_Output_DrawTriangleStrip(vertices, vertex_count);
+        S_Output_DrawTriangleFan(vertices, vertex_count);
     } else {
         S_Output_DisableTextureMode();
-        S_Output_DrawTriangleStrip(vertices, vertex_count);
+        S_Output_DrawTriangleFan(vertices, vertex_count);
     }
 }
 
@@ -1424,34 +1499,182 @@ void S_Output_DownloadTextures(int32_t pages)
         Shell_ExitSystem("Attempt to download more than texture page limit");
     }
 
-    S_Output_ReleaseTextures();
+    const int32_t page_size = TEXTURE_PAGE_WIDTH * TEXTURE_PAGE_HEIGHT;
+    uint32_t *page_data = Memory_Alloc(pages * page_size * sizeof(uint32_t));
+    uint64_t page_keys[GFX_MAX_TEXTURES];
+    S_Texture_ConvertPages(
+        (const uint8_t *const *)g_TexturePagePtrs, pages, page_size,
+        m_ATIPalette, page_data, page_keys);
+
+    if (!S_Output_UpdateTextures(pages, page_data, page_keys)) {
+        S_Output_ReleaseTextures();
+
+        // in the texture array mode all pages are uploaded at once and the
+        // texture map holds the array layers rather than texture handles
+        if (g_Config.rendering.enable_texture_array && pages) {
+            m_IsTextureArrayLoaded = GFX_3D_Renderer_TextureArrayReg(
+                m_Renderer3D, page_data, TEXTURE_PAGE_WIDTH,
+                TEXTURE_PAGE_HEIGHT, pages);
+        }
 
-    for (int i = 0; i < pages; i++) {
-        GFX_2D_SurfaceDesc surface_desc = { 0 };
-        bool result = GFX_2D_Surface_Lock(m_TextureSurfaces[i], &surface_desc);
-        S_Output_CheckError(result);
+        for (int i = 0; i < pages; i++) {
+            if (m_IsTextureArrayLoaded) {
+                m_TextureMap[i] = i;
+            } else {
+                m_TextureMap[i] = GFX_3D_Renderer_TextureReg(
+                    m_Renderer3D, &page_data[i * page_size],
+                    TEXTURE_PAGE_WIDTH, TEXTURE_PAGE_HEIGHT);
+            }
+        }
+    }
 
-        uint32_t *output_ptr = surface_desc.pixels;
-        uint8_t *input_ptr = g_TexturePagePtrs[i];
-        for (int j = 0; j < surface_desc.width * surface_desc.height; j++) {
-            uint8_t pal_idx = *input_ptr++;
-            // first color in the palette is chroma key, make it transparent
-            uint8_t alpha = pal_idx == 0 ? 0 : 0xFF;
-            RGB888 pix = S_Output_GetPaletteColor(pal_idx);
-            *output_ptr++ =
-                pix.b | (pix.g << 8) | (pix.r << 16) | (alpha << 24);
+    memcpy(m_TextureKeys, page_keys, pages * sizeof(uint64_t));
+    m_TexturePageCount = pages;
+    Memory_FreePointer(&page_data);
+
+    m_SelectedTexture = -1;
+}
+
+bool S_Output_CacheRooms()
+{
+    GFX_3D_Renderer_RoomCacheUnreg(m_Renderer3D);
+    if (!m_IsTextureArrayLoaded) {
+        return false;
+    }
+
+    size_t vertex_count = 0;
+    size_t index_count = 0;
+    for (int i = 0; i < g_RoomCount; i++) {
+        const int16_t *obj_ptr = g_RoomInfo[i].data;
+        obj_ptr += 1 + *obj_ptr * 4;
+        int32_t quad_count = *obj_ptr++;
+        for (int j = 0; j < quad_count; j++, obj_ptr += 5) {
+            if (!Output_IsAnimatedTexture(obj_ptr[4])) {
+                vertex_count += 4;
+                index_count += 6;
+            }
+        }
+        int32_t tri_count = *obj_ptr++;
+        for (int j = 0; j < tri_count; j++, obj_ptr += 4) {
+            if (!Output_IsAnimatedTexture(obj_ptr[3])) {
+                vertex_count += 3;
+                index_count += 3;
+            }
         }
+    }
 
-        result =
-            GFX_2D_Surface_Unlock(m_TextureSurfaces[i], surface_desc.pixels);
-        S_Output_CheckError(result);
+    GFX_3D_RoomVertex *vertices =
+        Memory_Alloc(sizeof(GFX_3D_RoomVertex) * vertex_count);
+    GLuint *indices = Memory_Alloc(sizeof(GLuint) * index_count);
+    GFX_3D_IndexRange *rooms =
+        Memory_Alloc(sizeof(GFX_3D_IndexRange) * g_RoomCount);
+
+    // the faces keep the winding of the original triangles, and quads are
+    // split the same way as S_Output_DrawTexturedQuad splits them when
+    // clipping
+    GFX_3D_RoomVertex *vertex = vertices;
+    GLuint *index = indices;
+    for (int i = 0; i < g_RoomCount; i++) {
+        const int16_t *obj_ptr = g_RoomInfo[i].data;
+        const int32_t room_vertex_count = *obj_ptr;
+        const int16_t *room_vertices = obj_ptr + 1;
+        obj_ptr += 1 + room_vertex_count * 4;
+
+        rooms[i].start = index - indices;
+
+        int32_t quad_count = *obj_ptr++;
+        for (int j = 0; j < quad_count; j++, obj_ptr += 5) {
+            if (Output_IsAnimatedTexture(obj_ptr[4])) {
+                continue;
+            }
+            const PHD_TEXTURE *texture = &g_PhdTextureInfo[obj_ptr[4]];
+            const GLuint base = vertex - vertices;
+            for (int k = 0; k < 4; k++) {
+                S_Output_SetRoomVertex(
+                    vertex++, room_vertices, room_vertex_count, obj_ptr[k],
+                    texture, k);
+            }
+            *index++ = base + 0;
+            *index++ = base + 1;
+            *index++ = base + 2;
+            *index++ = base + 2;
+            *index++ = base + 3;
+            *index++ = base + 0;
+        }
+
+        int32_t tri_count = *obj_ptr++;
+        for (int j = 0; j < tri_count; j++, obj_ptr += 4) {
+            if (Output_IsAnimatedTexture(obj_ptr[3])) {
+                continue;
+            }
+            const PHD_TEXTURE *texture = &g_PhdTextureInfo[obj_ptr[3]];
+            for (int k = 0; k < 3; k++) {
+                *index++ = vertex - vertices;
+                S_Output_SetRoomVertex(
+                    vertex++, room_vertices, room_vertex_count, obj_ptr[k],
+                    texture, k);
+            }
+        }
 
-        m_TextureMap[i] = GFX_3D_Renderer_TextureReg(
-            m_Renderer3D, surface_desc.pixels, surface_desc.width,
-            surface_desc.height);
+        rooms[i].count = (index - indices) - rooms[i].start;
     }
 
-    m_SelectedTexture = -1;
+    GFX_3D_Renderer_RoomCacheReg(
+        m_Renderer3D, vertices, vertex_count, indices, index_count, rooms,
+        g_RoomCount, g_WibbleTable, g_ShadeTable);
+
+    Memory_FreePointer(&vertices);
+    Memory_FreePointer(&indices);
+    Memory_FreePointer(&rooms);
+
+    LOG_INFO(
+        "Cached room geometry: %d vertices, %d indices", (int)vertex_count,
+        (int)index_count);
+    return true;
+}
+
+void S_Output_BeginDrawList()
+{
+    GFX_3D_Renderer_BeginDrawList(m_Renderer3D);
+}
+
+void S_Output_DrawRoom(int32_t entry_num)
+{
+    const float scale = 1.0f / W2V_SCALE;
+    GFX_3D_RoomParams params;
+    params.matrix[0][0] = g_PhdMatrixPtr->_00 * scale;
+    params.matrix[0][1] = g_PhdMatrixPtr->_01 * scale;
+    params.matrix[0][2] = g_PhdMatrixPtr->_02 * scale;
+    params.matrix[0][3] = g_PhdMatrixPtr->_03 * scale;
+    params.matrix[1][0] = g_PhdMatrixPtr->_10 * scale;
+    params.matrix[1][1] = g_PhdMatrixPtr->_11 * scale;
+    params.matrix[1][2] = g_PhdMatrixPtr->_12 * scale;
+    params.matrix[1][3] = g_PhdMatrixPtr->_13 * scale;
+    params.matrix[2][0] = g_PhdMatrixPtr->_20 * scale;
+    params.matrix[2][1] = g_PhdMatrixPtr->_21 * scale;
+    params.matrix[2][2] = g_PhdMatrixPtr->_22 * scale;
+    params.matrix[2][3] = g_PhdMatrixPtr->_23 * scale;
+    params.clip_left = g_PhdLeft;
+    params.clip_top = g_PhdTop;
+    params.clip_right = g_PhdRight;
+    params.clip_bottom = g_PhdBottom;
+    params.center_x = ViewPort_GetCenterX();
+    params.center_y = ViewPort_GetCenterY();
+    params.perspective = g_PhdPersp;
+    params.near_z = Output_GetNearZ() * scale;
+    params.fog_begin = Output_GetDrawDistFade();
+    params.fog_end = Output_GetDrawDistMax();
+    params.draw_dist_max = Output_GetDrawDistMax();
+    params.brightness = g_Config.brightness;
+    params.tint_r = 1.0f;
+    params.tint_g = 1.0f;
+    params.tint_b = 1.0f;
+    Output_ApplyWaterEffect(&params.tint_r, &params.tint_g, &params.tint_b);
+    params.water_effect = g_IsWaterEffect;
+    params.wibble_effect = g_IsWibbleEffect;
+    params.wibble_offset = g_WibbleOffset;
+
+    GFX_3D_Renderer_DrawRoom(m_Renderer3D, entry_num, &params);
 }
 
 bool S_Output_MakeScreenshot(const char *path)
@@ -1459,3 +1682,14 @@ bool S_Output_MakeScreenshot(const char *path)
     GFX_Context_ScheduleScreenshot(path);
     return true;
 }
+
+void S_Output_LogRenderStats()
+{
+    GFX_3D_VertexStreamStats stats;
+    GFX_3D_Renderer_GetStreamStats(m_Renderer3D, &stats);
+    LOG_INFO(
+        "Vertex stream: %d bytes per frame, %d stalls, %d orphans, "
+        "%d draw calls",
+        (int)stats.bytes_streamed, stats.stalls, stats.orphans,
+        stats.draw_calls);
+}
@@ -54,4 +54,11 @@ void S_Output_DrawLightningSegment(
     int x1, int y1, int z1, int thickness1, int x2, int y2, int z2,
     int thickness2);
 
+void S_Output_BeginDrawList();
+
+bool S_Output_CacheRooms();
+void S_Output_DrawRoom(int32_t entry_num);
+
 bool S_Output_MakeScreenshot(const char *path);
+
+void S_Output_LogRenderStats();
@@ -7,6 +7,7 @@
 #include "game/input.h"
 #include "game/music.h"
 #include "game/output.h"
+#include "game/quicksave.h"
 #include "game/random.h"
 #include "game/shell.h"
 #include "global/vars_platform.h"
@@ -34,6 +35,7 @@ void S_Shell_Shutdown()
         Input_Update();
     }
     GameFlow_Shutdown();
+    QuickSave_Shutdown();
     GameBuf_Shutdown();
     Output_Shutdown();
     S_Audio_Shutdown();
@@ -80,6 +82,7 @@ void S_Shell_TerminateGame(int exit_code)
         SDL_DestroyWindow(m_Window);
     }
     SDL_Quit();
+    Log_Shutdown();
     exit(exit_code);
 }
 
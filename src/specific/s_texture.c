@@ -0,0 +1,208 @@
+#include "specific/s_texture.h"
+
+#include "log.h"
+#include "memory.h"
+#include "specific/s_job.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define S_TEXTURE_CACHE_SIZE 64
+#define S_TEXTURE_HASH_SEED 0xCBF29CE484222325ULL
+#define S_TEXTURE_HASH_PRIME 0x9E3779B97F4A7C15ULL
+
+typedef struct S_TEXTURE_CACHE_ENTRY {
+    uint64_t key;
+    int32_t page_size;
+    uint32_t last_used;
+    uint32_t *pixels;
+} S_TEXTURE_CACHE_ENTRY;
+
+typedef struct S_TEXTURE_JOB {
+    const uint8_t *input;
+    uint32_t *output;
+} S_TEXTURE_JOB;
+
+typedef struct S_TEXTURE_WORK {
+    const uint32_t *lut;
+    const S_TEXTURE_JOB *jobs;
+    int32_t page_size;
+} S_TEXTURE_WORK;
+
+static S_TEXTURE_CACHE_ENTRY m_Cache[S_TEXTURE_CACHE_SIZE] = { 0 };
+static uint32_t m_CacheTick = 0;
+
+static uint64_t S_Texture_Hash(uint64_t hash, const void *data, size_t size);
+static void S_Texture_ExpandPalette(
+    const uint32_t *lut, const uint8_t *input, uint32_t *output, size_t count);
+static void S_Texture_RunJob(void *arg, int32_t index);
+static S_TEXTURE_CACHE_ENTRY *S_Texture_FindCached(
+    uint64_t key, int32_t page_size);
+static void S_Texture_StoreCached(
+    uint64_t key, int32_t page_size, const uint32_t *pixels);
+
+static uint64_t S_Texture_Hash(uint64_t hash, const void *data, size_t size)
+{
+    // the pages are hashed 8 bytes at a time, which keeps the hashing
+    // noticeably cheaper than the conversion it saves
+    const uint8_t *ptr = data;
+    while (size >= sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, ptr, sizeof(word));
+        hash = (hash ^ word) * S_TEXTURE_HASH_PRIME;
+        hash ^= hash >> 32;
+        ptr += sizeof(uint64_t);
+        size -= sizeof(uint64_t);
+    }
+    while (size--) {
+        hash = (hash ^ *ptr++) * S_TEXTURE_HASH_PRIME;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
+
+static void S_Texture_ExpandPalette(
+    const uint32_t *lut, const uint8_t *input, uint32_t *output, size_t count)
+{
+    // there are no gathers before AVX2, so the lookups are done 8 pixels at
+    // a time from a single load of the indices instead
+    while (count >= 8) {
+        uint64_t idx;
+        memcpy(&idx, input, sizeof(idx));
+        output[0] = lut[idx & 0xFF];
+        output[1] = lut[(idx >> 8) & 0xFF];
+        output[2] = lut[(idx >> 16) & 0xFF];
+        output[3] = lut[(idx >> 24) & 0xFF];
+        output[4] = lut[(idx >> 32) & 0xFF];
+        output[5] = lut[(idx >> 40) & 0xFF];
+        output[6] = lut[(idx >> 48) & 0xFF];
+        output[7] = lut[idx >> 56];
+        input += 8;
+        output += 8;
+        count -= 8;
+    }
+    while (count--) {
+        *output++ = lut[*input++];
+    }
+}
+
+static void S_Texture_RunJob(void *arg, int32_t index)
+{
+    const S_TEXTURE_WORK *work = arg;
+    S_Texture_ExpandPalette(
+        work->lut, work->jobs[index].input, work->jobs[index].output,
+        work->page_size);
+}
+
+static S_TEXTURE_CACHE_ENTRY *S_Texture_FindCached(
+    uint64_t key, int32_t page_size)
+{
+    for (int i = 0; i < S_TEXTURE_CACHE_SIZE; i++) {
+        S_TEXTURE_CACHE_ENTRY *entry = &m_Cache[i];
+        if (entry->pixels && entry->key == key
+            && entry->page_size == page_size) {
+            entry->last_used = ++m_CacheTick;
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+static void S_Texture_StoreCached(
+    uint64_t key, int32_t page_size, const uint32_t *pixels)
+{
+    // reuse an empty slot, or evict the least recently used page
+    S_TEXTURE_CACHE_ENTRY *entry = &m_Cache[0];
+    for (int i = 0; i < S_TEXTURE_CACHE_SIZE; i++) {
+        if (!m_Cache[i].pixels) {
+            entry = &m_Cache[i];
+            break;
+        }
+        if (m_Cache[i].last_used < entry->last_used) {
+            entry = &m_Cache[i];
+        }
+    }
+
+    if (entry->page_size != page_size) {
+        Memory_FreePointer(&entry->pixels);
+    }
+    if (!entry->pixels) {
+        entry->pixels = Memory_Alloc(page_size * sizeof(uint32_t));
+    }
+    memcpy(entry->pixels, pixels, page_size * sizeof(uint32_t));
+    entry->key = key;
+    entry->page_size = page_size;
+    entry->last_used = ++m_CacheTick;
+}
+
+void S_Texture_ConvertPages(
+    const uint8_t *const *pages, int32_t page_count, int32_t page_size,
+    const RGB888 *palette, uint32_t *output, uint64_t *out_keys)
+{
+    assert(pages);
+    assert(palette);
+    assert(output);
+    assert(out_keys);
+
+    uint32_t lut[256];
+    for (int i = 0; i < 256; i++) {
+        // first color in the palette is chroma key, make it transparent
+        const uint8_t alpha = i == 0 ? 0 : 0xFF;
+        lut[i] = palette[i].b | (palette[i].g << 8) | (palette[i].r << 16)
+            | (alpha << 24);
+    }
+    const uint64_t palette_hash =
+        S_Texture_Hash(S_TEXTURE_HASH_SEED, lut, sizeof(lut));
+
+    S_TEXTURE_JOB *jobs = Memory_Alloc(page_count * sizeof(S_TEXTURE_JOB));
+    int32_t job_count = 0;
+
+    for (int i = 0; i < page_count; i++) {
+        uint32_t *page_output = &output[i * page_size];
+        out_keys[i] = S_Texture_Hash(palette_hash, pages[i], page_size);
+
+        const S_TEXTURE_CACHE_ENTRY *entry =
+            S_Texture_FindCached(out_keys[i], page_size);
+        if (entry) {
+            memcpy(page_output, entry->pixels, page_size * sizeof(uint32_t));
+        } else {
+            jobs[job_count].input = pages[i];
+            jobs[job_count].output = page_output;
+            job_count++;
+        }
+    }
+
+    if (job_count) {
+        S_TEXTURE_WORK work = {
+            .lut = lut,
+            .jobs = jobs,
+            .page_size = page_size,
+        };
+        S_Job_ParallelFor(S_Texture_RunJob, &work, job_count);
+
+        for (int i = 0; i < page_count; i++) {
+            if (!S_Texture_FindCached(out_keys[i], page_size)) {
+                S_Texture_StoreCached(
+                    out_keys[i], page_size, &output[i * page_size]);
+            }
+        }
+    }
+
+    LOG_INFO(
+        "converted %d texture pages, %d reused from cache", page_count,
+        page_count - job_count);
+
+    Memory_FreePointer(&jobs);
+}
+
+void S_Texture_ClearCache()
+{
+    for (int i = 0; i < S_TEXTURE_CACHE_SIZE; i++) {
+        Memory_FreePointer(&m_Cache[i].pixels);
+        m_Cache[i].key = 0;
+        m_Cache[i].page_size = 0;
+        m_Cache[i].last_used = 0;
+    }
+    m_CacheTick = 0;
+}
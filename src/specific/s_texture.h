@@ -0,0 +1,17 @@
+#pragma once
+
+#include "global/types.h"
+
+#include <stdint.h>
+
+// Converts the 8-bit texture pages to 32-bit BGRA using the given palette
+// and writes them one after another to the output buffer. Pages that were
+// already converted with the same palette are taken from a cache, the rest
+// are converted on worker threads. Each page gets a key identifying both its
+// contents and the palette, which can be used to tell which pages changed
+// since the previous conversion.
+void S_Texture_ConvertPages(
+    const uint8_t *const *pages, int32_t page_count, int32_t page_size,
+    const RGB888 *palette, uint32_t *output, uint64_t *out_keys);
+
+void S_Texture_ClearCache();